@@ -0,0 +1,186 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    ARENA_ALIGN = alignof(max_align_t),
+    ARENA_CACHE_SIZE = 16,      // chunks cached per thread
+};
+
+struct EjArenaChunk
+{
+    struct EjArenaChunk *next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+};
+
+struct EjArena
+{
+    size_t chunk_size;
+    struct EjArenaChunk *first;
+};
+
+/*
+ * chunks of the most recent standard size are reused without malloc,
+ * only threads that create arenas keep a cache (threads that only free,
+ * such as the refresh scheduler, would just hold the chunks), the cache
+ * is freed when the thread exits
+ */
+static __thread struct EjArenaChunk *chunk_cache;
+static __thread int chunk_cache_count;
+static __thread _Bool chunk_cache_registered;
+
+static pthread_once_t chunk_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t chunk_cache_key;
+
+static void
+chunk_cache_thread_exit(void *arg)
+{
+    struct EjArenaChunk *p, *q;
+    for (p = chunk_cache; p; p = q) {
+        q = p->next;
+        free(p);
+    }
+    chunk_cache = NULL;
+    chunk_cache_count = 0;
+}
+
+static void
+chunk_cache_init_func(void)
+{
+    pthread_key_create(&chunk_cache_key, chunk_cache_thread_exit);
+}
+
+static struct EjArenaChunk *
+arena_chunk_create(size_t size)
+{
+    if (!chunk_cache_registered) {
+        pthread_once(&chunk_cache_once, chunk_cache_init_func);
+        // any non-NULL value makes the destructor run
+        pthread_setspecific(chunk_cache_key, &chunk_cache_registered);
+        chunk_cache_registered = 1;
+    }
+    struct EjArenaChunk *eac = chunk_cache;
+    if (eac && eac->size == size) {
+        chunk_cache = eac->next;
+        --chunk_cache_count;
+    } else {
+        eac = malloc(sizeof(*eac) + size);
+        if (!eac) abort();
+        eac->size = size;
+    }
+    eac->next = NULL;
+    eac->used = 0;
+    return eac;
+}
+
+static void
+arena_chunk_free(struct EjArenaChunk *eac, size_t chunk_size)
+{
+    if (chunk_cache_registered && eac->size == chunk_size && chunk_cache_count < ARENA_CACHE_SIZE
+        && (!chunk_cache || chunk_cache->size == chunk_size)) {
+        eac->next = chunk_cache;
+        chunk_cache = eac;
+        ++chunk_cache_count;
+    } else {
+        free(eac);
+    }
+}
+
+struct EjArena *
+arena_create(size_t chunk_size)
+{
+    // the arena header is the first allocation of its first chunk
+    struct EjArenaChunk *eac = arena_chunk_create(chunk_size);
+    struct EjArena *ea = (struct EjArena *) eac->data;
+    eac->used = (sizeof(*ea) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    ea->chunk_size = chunk_size;
+    ea->first = eac;
+    return ea;
+}
+
+void
+arena_free(struct EjArena *ea)
+{
+    if (ea) {
+        size_t chunk_size = ea->chunk_size;
+        struct EjArenaChunk *p, *q;
+        for (p = ea->first; p; p = q) {
+            q = p->next;
+            arena_chunk_free(p, chunk_size);
+        }
+    }
+}
+
+void *
+arena_alloc(struct EjArena *ea, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    struct EjArenaChunk *eac = ea->first;
+    if (eac->size - eac->used < size) {
+        if (size > ea->chunk_size / 2) {
+            // a large block gets its own chunk behind the current one
+            struct EjArenaChunk *big = arena_chunk_create(size);
+            big->used = size;
+            big->next = eac->next;
+            eac->next = big;
+            return big->data;
+        }
+        eac = arena_chunk_create(ea->chunk_size);
+        eac->next = ea->first;
+        ea->first = eac;
+    }
+    void *ptr = eac->data + eac->used;
+    eac->used += size;
+    return ptr;
+}
+
+void *
+arena_calloc(struct EjArena *ea, size_t count, size_t size)
+{
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) abort();
+    void *ptr = arena_alloc(ea, total);
+    memset(ptr, 0, total);
+    return ptr;
+}
+
+void *
+arena_memdup(struct EjArena *ea, const void *data, size_t size)
+{
+    void *ptr = arena_alloc(ea, size);
+    memcpy(ptr, data, size);
+    return ptr;
+}
+
+unsigned char *
+arena_strdup(struct EjArena *ea, const unsigned char *str)
+{
+    if (!str) return NULL;
+    return arena_memdup(ea, str, strlen(str) + 1);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Bump allocator owning all the memory of one generation of a parsed
+ * object, the object is released with a single arena_free.
+ */
+
+#include <stddef.h>
+
+struct EjArena;
+
+struct EjArena *arena_create(size_t chunk_size);
+void arena_free(struct EjArena *ea);
+
+void *arena_alloc(struct EjArena *ea, size_t size);
+void *arena_calloc(struct EjArena *ea, size_t count, size_t size);
+void *arena_memdup(struct EjArena *ea, const void *data, size_t size);
+unsigned char *arena_strdup(struct EjArena *ea, const unsigned char *str);
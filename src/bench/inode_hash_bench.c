@@ -0,0 +1,155 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Lookup/insert throughput of inode_hash at 1, 8 and 32 threads
+ * (or the thread counts given on the command line).
+ * Every thread looks up the preloaded digests and inserts a new digest
+ * each INSERT_PERIOD operations, so the shards grow while being read.
+ * Usage: inode_hash_bench [THREADS...]
+ */
+
+#include "inode_hash.h"
+
+#include <openssl/sha.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum
+{
+    PRELOAD_COUNT = 100000,
+    OPS_PER_THREAD = 2000000,
+    INSERT_PERIOD = 16,
+};
+
+struct BenchThread
+{
+    pthread_t tid;
+    int index;
+    unsigned long long found;
+};
+
+static struct EjInodeHash *hash;
+static unsigned char (*digests)[SHA256_DIGEST_LENGTH];
+static pthread_barrier_t start_barrier;
+
+static long long
+get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void
+make_digest(unsigned char *digest, int thread, unsigned serial)
+{
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "/bench/%d/%u", thread, serial);
+    SHA256((const unsigned char *) buf, len, digest);
+}
+
+static void *
+bench_thread(void *arg)
+{
+    struct BenchThread *bt = arg;
+    unsigned long long found = 0;
+    unsigned rnd = bt->index * 2654435761U + 1;
+    unsigned serial = 0;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+
+    pthread_barrier_wait(&start_barrier);
+    for (int i = 0; i < OPS_PER_THREAD; ++i) {
+        if (i % INSERT_PERIOD == INSERT_PERIOD - 1) {
+            make_digest(digest, bt->index + 1, serial++);
+            found += inode_hash_insert(hash, digest) != 0;
+        } else {
+            rnd = rnd * 1103515245U + 12345U;
+            found += inode_hash_find(hash, digests[(rnd >> 8) % PRELOAD_COUNT]) != 0;
+        }
+    }
+    bt->found = found;
+    return NULL;
+}
+
+static void
+run_bench(int thread_count)
+{
+    hash = inode_hash_create();
+    for (int i = 0; i < PRELOAD_COUNT; ++i) {
+        inode_hash_insert(hash, digests[i]);
+    }
+
+    struct BenchThread *bts = calloc(thread_count, sizeof(bts[0]));
+    pthread_barrier_init(&start_barrier, NULL, thread_count + 1);
+    for (int i = 0; i < thread_count; ++i) {
+        bts[i].index = i;
+        pthread_create(&bts[i].tid, NULL, bench_thread, &bts[i]);
+    }
+    pthread_barrier_wait(&start_barrier);
+    long long start_ns = get_time_ns();
+    unsigned long long found = 0;
+    for (int i = 0; i < thread_count; ++i) {
+        pthread_join(bts[i].tid, NULL);
+        found += bts[i].found;
+    }
+    long long elapsed_ns = get_time_ns() - start_ns;
+
+    unsigned long long total_ops = (unsigned long long) thread_count * OPS_PER_THREAD;
+    if (found != total_ops) {
+        fprintf(stderr, "inode_hash_bench: %llu of %llu digests not found\n", total_ops - found, total_ops);
+        exit(1);
+    }
+    printf("%3d threads: %8.2f Mops/s, %7.1f ns/op per thread\n",
+           thread_count,
+           total_ops * 1000.0 / elapsed_ns,
+           (double) elapsed_ns * thread_count / total_ops);
+
+    pthread_barrier_destroy(&start_barrier);
+    free(bts);
+    inode_hash_free(hash);
+    hash = NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    digests = malloc(PRELOAD_COUNT * sizeof(digests[0]));
+    for (int i = 0; i < PRELOAD_COUNT; ++i) {
+        make_digest(digests[i], 0, i);
+    }
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            int thread_count = atoi(argv[i]);
+            if (thread_count > 0) run_bench(thread_count);
+        }
+    } else {
+        run_bench(1);
+        run_bench(8);
+        run_bench(32);
+    }
+
+    free(digests);
+    return 0;
+}
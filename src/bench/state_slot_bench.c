@@ -0,0 +1,202 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Contention between the sibling slots of one state object, with the
+ * slots packed together and with each slot on its own cache line
+ * (EJ_CACHE_ALIGNED, as in the contest, problem and run states).
+ * The reader threads acquire and release the objects of three slots
+ * (thread i reads slot i % 3), one more thread keeps refreshing the
+ * fourth slot: it takes and drops the update flag and the access time.
+ * Usage: state_slot_bench [THREADS...], 1, 8 and 32 reader threads by default.
+ */
+
+#include "contests_state.h"
+#include "ebr.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum
+{
+    SLOT_COUNT = 4,
+    READ_SLOT_COUNT = 3,
+    RUN_TIME_MS = 1000,
+};
+
+struct BenchObject
+{
+    int value;
+};
+
+struct PackedSlot
+{
+    EJ_STATE_SLOT(struct BenchObject) slot;
+};
+
+struct AlignedSlot
+{
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct BenchObject) slot;
+};
+
+struct PackedState
+{
+    struct PackedSlot slots[SLOT_COUNT];
+};
+
+struct AlignedState
+{
+    struct AlignedSlot slots[SLOT_COUNT];
+};
+
+_Static_assert(sizeof(struct AlignedState) == SLOT_COUNT * EJFUSE_CACHE_LINE_SIZE, "aligned slots expected");
+
+struct BenchThread
+{
+    pthread_t tid;
+    int index;
+    struct BenchObject * _Atomic *obj_slot;
+    _Atomic long long *access_slot;
+    _Atomic _Bool *update_slot;
+    unsigned long long ops;
+};
+
+static _Atomic int stop_flag;
+static struct BenchObject bench_objects[SLOT_COUNT];
+
+static long long
+get_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void *
+reader_thread(void *arg)
+{
+    struct BenchThread *bt = arg;
+    unsigned long long ops = 0;
+    long long sum = 0;
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        struct BenchObject *obj = ebr_slot_acquire(bt->obj_slot);
+        if (obj) {
+            sum += obj->value;
+            ebr_slot_release(obj);
+        }
+        // what access_touch does once a second, the flag is only read
+        sum += atomic_load_explicit(bt->update_slot, memory_order_relaxed);
+        sum += atomic_load_explicit(bt->access_slot, memory_order_relaxed) & 1;
+        ++ops;
+    }
+    bt->ops = ops + (sum < 0);
+    return NULL;
+}
+
+static void *
+writer_thread(void *arg)
+{
+    struct BenchThread *bt = arg;
+    unsigned long long ops = 0;
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        if (!atomic_exchange_explicit(bt->update_slot, 1, memory_order_acquire)) {
+            atomic_store_explicit(bt->access_slot, ops, memory_order_relaxed);
+            atomic_store_explicit(bt->update_slot, 0, memory_order_release);
+        }
+        ++ops;
+    }
+    bt->ops = ops;
+    return NULL;
+}
+
+#define SETUP_SLOTS(state, bts, count)                                   \
+    do {                                                                \
+        for (int i = 0; i < SLOT_COUNT; ++i) {                          \
+            atomic_init(&(state)->slots[i].slot.obj, &bench_objects[i]);     \
+        }                                                               \
+        for (int i = 0; i <= (count); ++i) {                            \
+            int slot = i < (count) ? i % READ_SLOT_COUNT : SLOT_COUNT - 1; \
+            (bts)[i].index = i;                                         \
+            (bts)[i].obj_slot = &(state)->slots[slot].slot.obj;              \
+            (bts)[i].access_slot = &(state)->slots[slot].slot.access_us;     \
+            (bts)[i].update_slot = &(state)->slots[slot].slot.update;        \
+        }                                                               \
+    } while (0)
+
+static double
+run_threads(struct BenchThread *bts, int reader_count)
+{
+    atomic_store(&stop_flag, 0);
+    for (int i = 0; i < reader_count; ++i) {
+        pthread_create(&bts[i].tid, NULL, reader_thread, &bts[i]);
+    }
+    pthread_create(&bts[reader_count].tid, NULL, writer_thread, &bts[reader_count]);
+    long long start_ns = get_time_ns();
+    struct timespec ts = { RUN_TIME_MS / 1000, (RUN_TIME_MS % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    atomic_store(&stop_flag, 1);
+    unsigned long long ops = 0;
+    for (int i = 0; i <= reader_count; ++i) {
+        pthread_join(bts[i].tid, NULL);
+        if (i < reader_count) ops += bts[i].ops;
+    }
+    long long elapsed_ns = get_time_ns() - start_ns;
+    return ops * 1000.0 / elapsed_ns;
+}
+
+static void
+run_bench(int reader_count)
+{
+    struct BenchThread *bts = calloc(reader_count + 1, sizeof(bts[0]));
+
+    struct PackedState *packed = calloc(1, sizeof(*packed));
+    SETUP_SLOTS(packed, bts, reader_count);
+    double packed_rate = run_threads(bts, reader_count);
+    free(packed);
+
+    struct AlignedState *aligned = aligned_alloc(_Alignof(struct AlignedState), sizeof(*aligned));
+    memset(aligned, 0, sizeof(*aligned));
+    SETUP_SLOTS(aligned, bts, reader_count);
+    double aligned_rate = run_threads(bts, reader_count);
+    free(aligned);
+
+    printf("%3d readers: packed %8.2f Mreads/s, aligned %8.2f Mreads/s\n",
+           reader_count, packed_rate, aligned_rate);
+    free(bts);
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            int reader_count = atoi(argv[i]);
+            if (reader_count > 0) run_bench(reader_count);
+        }
+    } else {
+        run_bench(1);
+        run_bench(8);
+        run_bench(32);
+    }
+    return 0;
+}
@@ -18,7 +18,15 @@
  */
 
 #include "contests_state.h"
+#include "arena.h"
+#include "dir_listing.h"
+#include "ebr.h"
 #include "ejfuse_file.h"
+#include "inode_code.h"
+#include "memfd_blob.h"
+#include "settings.h"
+#include "single_flight.h"
+#include "slab.h"
 
 #include <pthread.h>
 #include <stdlib.h>
@@ -26,36 +34,97 @@
 #include <stdatomic.h>
 #include <stdio.h>
 
-struct EjContestsState
-{
-    pthread_rwlock_t rwl;
+// slabs of the objects created on every refresh
+static pthread_once_t state_slabs_once = PTHREAD_ONCE_INIT;
+static struct EjSlab *problem_info_slab;
+static struct EjSlab *problem_statement_slab;
+static struct EjSlab *problem_runs_slab;
+static struct EjSlab *run_state_slab;
+static struct EjSlab *run_source_slab;
+static struct EjSlab *run_messages_slab;
+static struct EjSlab *run_test_slab;
+static struct EjSlab *run_test_data_slab;
+
+static void
+state_slabs_init(void)
+{
+    problem_info_slab = slab_create("problem_info", sizeof(struct EjProblemInfo), _Alignof(struct EjProblemInfo));
+    problem_statement_slab = slab_create("problem_statement", sizeof(struct EjProblemStatement), _Alignof(struct EjProblemStatement));
+    problem_runs_slab = slab_create("problem_runs", sizeof(struct EjProblemRuns), _Alignof(struct EjProblemRuns));
+    run_state_slab = slab_create("run_state", sizeof(struct EjRunState), _Alignof(struct EjRunState));
+    run_source_slab = slab_create("run_source", sizeof(struct EjRunSource), _Alignof(struct EjRunSource));
+    run_messages_slab = slab_create("run_messages", sizeof(struct EjRunMessages), _Alignof(struct EjRunMessages));
+    run_test_slab = slab_create("run_test", sizeof(struct EjRunTest), _Alignof(struct EjRunTest));
+    run_test_data_slab = slab_create("run_test_data", sizeof(struct EjRunTestData), _Alignof(struct EjRunTestData));
+}
+
+// free functions for ebr_retire
+#define STATE_RETIRE_FUNC(name) static void name##_retire(void *ptr) { name##_free(ptr); }
+STATE_RETIRE_FUNC(contest_info)
+STATE_RETIRE_FUNC(contest_log)
+STATE_RETIRE_FUNC(contest_session)
+STATE_RETIRE_FUNC(problem_info)
+STATE_RETIRE_FUNC(problem_statement)
+STATE_RETIRE_FUNC(problem_runs)
+STATE_RETIRE_FUNC(run_info)
+STATE_RETIRE_FUNC(run_source)
+STATE_RETIRE_FUNC(run_messages)
+STATE_RETIRE_FUNC(run_test_data)
+#undef STATE_RETIRE_FUNC
 
-    int reserved;
+/*
+ * Immutable array of the contest states sorted by cnts_id. A new contest
+ * state is added by publishing a copy, the old array is retired.
+ */
+struct EjContestsTable
+{
     int size;
-    struct EjContestState **entries;
+    struct EjContestState *entries[];
+};
+
+struct EjContestsState
+{
+    struct EjContestsTable * _Atomic table;
+    pthread_mutex_t m;                  // serializes the writers
 };
 
 struct EjProblemStates
 {
     pthread_rwlock_t rwl;
+    int cnts_id;
 
     int size;
     struct EjProblemState **entries;
 };
 
-struct EjRunStates
+/*
+ * Run ids are dense, so the run states are kept in a two-level table
+ * indexed directly by run_id. Readers take no lock, pages and states are
+ * installed with CAS and stay until the contest state is freed.
+ */
+enum
 {
-    pthread_rwlock_t rwl;
+    RUN_STATES_PAGE_BITS = 10,
+    RUN_STATES_PAGE_SIZE = 1 << RUN_STATES_PAGE_BITS,
+    RUN_STATES_PAGE_COUNT = 4096,       // run_id < 4M
+};
 
-    // sorted by increasing run_id
-    int reserved;
-    int size;
-    struct EjRunState **runs;
+struct EjRunStatesPage
+{
+    struct EjRunState * _Atomic runs[RUN_STATES_PAGE_SIZE];
+};
+
+struct EjRunStates
+{
+    int cnts_id;
+    struct EjRunStatesPage * _Atomic pages[RUN_STATES_PAGE_COUNT];
 };
 
 struct EjRunTests
 {
     pthread_rwlock_t rwl;
+    int cnts_id;
+    int run_id;
 
     // indexed by (num - 1)
     int reserved;
@@ -147,6 +216,9 @@ contest_info_free(struct EjContestInfo *eci)
             contest_language_free(eci->compilers[i]);
         }
         free(eci->compilers);
+        free(eci->prob_index.slots);
+        free(eci->compiler_index.slots);
+        dir_listing_free(eci->probs_listing);
         free(eci->info_json_text);
         free(eci->info_text);
         free(eci->name);
@@ -154,6 +226,84 @@ contest_info_free(struct EjContestInfo *eci)
     }
 }
 
+/* FNV-1a */
+static unsigned
+name_index_hash(const unsigned char *name)
+{
+    unsigned hash = 2166136261U;
+    for (; *name; ++name) {
+        hash ^= *name;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static void
+name_index_init(struct EjNameIndex *eni, int count)
+{
+    unsigned size = 4;
+    while (size < (unsigned) count * 2) size *= 2;
+    eni->mask = size - 1;
+    eni->slots = calloc(size, sizeof(eni->slots[0]));
+}
+
+/* the first id added for a name wins, as with the linear scan */
+static void
+name_index_add(struct EjNameIndex *eni, const unsigned char *name, int id)
+{
+    unsigned i = name_index_hash(name) & eni->mask;
+    while (eni->slots[i].id > 0) {
+        if (!strcmp(eni->slots[i].name, name)) return;
+        i = (i + 1) & eni->mask;
+    }
+    eni->slots[i].name = name;
+    eni->slots[i].id = id;
+}
+
+static int
+name_index_find(const struct EjNameIndex *eni, const unsigned char *name)
+{
+    if (!eni->slots) return 0;
+    unsigned i = name_index_hash(name) & eni->mask;
+    while (eni->slots[i].id > 0) {
+        if (!strcmp(eni->slots[i].name, name)) return eni->slots[i].id;
+        i = (i + 1) & eni->mask;
+    }
+    return 0;
+}
+
+void
+contest_info_build_index(struct EjContestInfo *eci)
+{
+    name_index_init(&eci->prob_index, eci->prob_size);
+    for (int prob_id = 1; prob_id < eci->prob_size; ++prob_id) {
+        struct EjContestProblem *ecp = eci->probs[prob_id];
+        if (ecp && ecp->short_name) {
+            name_index_add(&eci->prob_index, ecp->short_name, prob_id);
+        }
+    }
+    name_index_init(&eci->compiler_index, eci->compiler_size);
+    for (int lang_id = 1; lang_id < eci->compiler_size; ++lang_id) {
+        struct EjContestCompiler *ecl = eci->compilers[lang_id];
+        if (ecl && ecl->short_name) {
+            name_index_add(&eci->compiler_index, ecl->short_name, lang_id);
+        }
+    }
+}
+
+/* returns 0 if not found */
+int
+contest_info_find_problem(const struct EjContestInfo *eci, const unsigned char *short_name)
+{
+    return name_index_find(&eci->prob_index, short_name);
+}
+
+int
+contest_info_find_compiler(const struct EjContestInfo *eci, const unsigned char *short_name)
+{
+    return name_index_find(&eci->compiler_index, short_name);
+}
+
 struct EjContestLog *
 contest_log_create(const unsigned char *init_str)
 {
@@ -176,14 +326,20 @@ contest_log_free(struct EjContestLog *ecl)
 struct EjContestState *
 contest_state_create(int cnts_id)
 {
-    struct EjContestState *ecs = calloc(1, sizeof(*ecs));
+    struct EjContestState *ecs = aligned_alloc(_Alignof(struct EjContestState), sizeof(*ecs));
+    memset(ecs, 0, sizeof(*ecs));
     ecs->cnts_id = cnts_id;
-    atomic_store_explicit(&ecs->info, contest_info_create(cnts_id), memory_order_relaxed);
+    ecs->inode = inode_code_make(INODE_KIND_CONTEST, cnts_id, 0, 0);
+    ecs->info_inode = inode_code_make(INODE_KIND_CONTEST_INFO, cnts_id, 0, 0);
+    ecs->info_json_inode = inode_code_make(INODE_KIND_CONTEST_INFO_JSON, cnts_id, 0, 0);
+    ecs->log_inode = inode_code_make(INODE_KIND_CONTEST_LOG, cnts_id, 0, 0);
+    ecs->problems_inode = inode_code_make(INODE_KIND_PROBLEMS, cnts_id, 0, 0);
+    atomic_store_explicit(&ecs->info.obj, contest_info_create(cnts_id), memory_order_relaxed);
     pthread_mutex_init(&ecs->log_mutex, NULL);
-    atomic_store_explicit(&ecs->log, contest_log_create(""), memory_order_relaxed);
-    atomic_store_explicit(&ecs->session, contest_session_create(cnts_id), memory_order_relaxed);
-    ecs->prob_states = problem_states_create();
-    ecs->run_states = run_states_create();
+    atomic_store_explicit(&ecs->log.obj, contest_log_create(""), memory_order_relaxed);
+    atomic_store_explicit(&ecs->session.obj, contest_session_create(cnts_id), memory_order_relaxed);
+    ecs->prob_states = problem_states_create(cnts_id);
+    ecs->run_states = run_states_create(cnts_id);
     return ecs;
 }
 
@@ -191,10 +347,10 @@ void
 contest_state_free(struct EjContestState *ecs)
 {
     if (ecs) {
-        contest_info_free(ecs->info);
-        contest_log_free(ecs->log);
+        contest_info_free(ecs->info.obj);
+        contest_log_free(ecs->log.obj);
         pthread_mutex_destroy(&ecs->log_mutex);
-        contest_session_free(ecs->session);
+        contest_session_free(ecs->session.obj);
         problem_states_free(ecs->prob_states);
         run_states_free(ecs->run_states);
         free(ecs);
@@ -205,7 +361,7 @@ struct EjContestsState *
 contests_state_create(void)
 {
     struct EjContestsState *ecss = calloc(1, sizeof(*ecss));
-    pthread_rwlock_init(&ecss->rwl, NULL);
+    pthread_mutex_init(&ecss->m, NULL);
     return ecss;
 }
 
@@ -213,67 +369,78 @@ void
 contests_state_free(struct EjContestsState *ecss)
 {
     if (ecss) {
-        pthread_rwlock_destroy(&ecss->rwl);
+        pthread_mutex_destroy(&ecss->m);
+        free(ecss->table);
         free(ecss);
     }
 }
 
-struct EjContestState *
-contests_state_get(struct EjContestsState *ecss, int cnts_id)
+// returns the position of cnts_id or the insertion point as -pos - 1
+static int
+contests_table_find(const struct EjContestsTable *ect, int cnts_id)
 {
-    pthread_rwlock_rdlock(&ecss->rwl);
-    if (ecss->size > 0) {
-        int low = 0, high = ecss->size;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            struct EjContestState *ecs = ecss->entries[mid];
-            if (ecs->cnts_id == cnts_id) {
-                pthread_rwlock_unlock(&ecss->rwl);
-                return ecs;
-            } else if (ecs->cnts_id < cnts_id) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
-        }
-    }
-    pthread_rwlock_unlock(&ecss->rwl);
-    pthread_rwlock_wrlock(&ecss->rwl);
-    struct EjContestState *retval = NULL;
-    if (ecss->reserved <= 0) {
-        ecss->reserved = 16;
-        ecss->entries = calloc(ecss->reserved, sizeof(ecss->entries[0]));
-    }
-    if (ecss->size > 0) {
-        int low = 0, high = ecss->size;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            struct EjContestState *ecs = ecss->entries[mid];
-            if (ecs->cnts_id == cnts_id) {
-                pthread_rwlock_unlock(&ecss->rwl);
-                return ecs;
-            } else if (ecs->cnts_id < cnts_id) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
-        }
-        if (ecss->size == ecss->reserved) {
-            ecss->entries = realloc(ecss->entries, (ecss->reserved *= 2) * sizeof(ecss->entries[0]));
-        }
-        if (low < ecss->size) {
-            memmove(&ecss->entries[low + 1], &ecss->entries[low], (ecss->size - low) * sizeof(ecss->entries[0]));
-            retval = ecss->entries[low] = contest_state_create(cnts_id);
-            ++ecss->size;
+    int low = 0, high = ect ? ect->size : 0;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        int id = ect->entries[mid]->cnts_id;
+        if (id == cnts_id) {
+            return mid;
+        } else if (id < cnts_id) {
+            low = mid + 1;
         } else {
-            retval = ecss->entries[ecss->size++] = contest_state_create(cnts_id);
+            high = mid;
         }
-    } else {
-        ecss->size = 1;
-        retval = ecss->entries[0] = contest_state_create(cnts_id);
     }
-    pthread_rwlock_unlock(&ecss->rwl);
-    return retval;
+    return -low - 1;
+}
+
+struct EjContestState *
+contests_state_try(struct EjContestsState *ecss, int cnts_id)
+{
+    struct EjContestState *ecs = NULL;
+    struct EjContestsTable *ect = ebr_slot_acquire(&ecss->table);
+    int pos = contests_table_find(ect, cnts_id);
+    if (pos >= 0) ecs = ect->entries[pos];
+    ebr_slot_release(ect);
+    return ecs;
+}
+
+static void
+contests_table_retire(void *ptr)
+{
+    free(ptr);
+}
+
+struct EjContestState *
+contests_state_get(struct EjContestsState *ecss, int cnts_id)
+{
+    struct EjContestState *ecs = contests_state_try(ecss, cnts_id);
+    if (ecs) return ecs;
+
+    pthread_mutex_lock(&ecss->m);
+    // the table is replaced only under the mutex
+    struct EjContestsTable *ect = atomic_load_explicit(&ecss->table, memory_order_acquire);
+    int pos = contests_table_find(ect, cnts_id);
+    if (pos >= 0) {
+        ecs = ect->entries[pos];
+        pthread_mutex_unlock(&ecss->m);
+        return ecs;
+    }
+    pos = -pos - 1;
+    int size = ect ? ect->size : 0;
+    struct EjContestsTable *nt = malloc(sizeof(*nt) + (size + 1) * sizeof(nt->entries[0]));
+    nt->size = size + 1;
+    if (pos > 0) {
+        memcpy(nt->entries, ect->entries, pos * sizeof(nt->entries[0]));
+    }
+    if (pos < size) {
+        memcpy(&nt->entries[pos + 1], &ect->entries[pos], (size - pos) * sizeof(nt->entries[0]));
+    }
+    ecs = nt->entries[pos] = contest_state_create(cnts_id);
+    ect = ebr_slot_exchange(&ecss->table, nt);
+    pthread_mutex_unlock(&ecss->m);
+    ebr_retire(ect, contests_table_retire);
+    return ecs;
 }
 
 // return false if there's no session and true if session valid
@@ -300,75 +467,86 @@ contest_state_copy_session(struct EjContestState *ecs, struct EjSessionValue *es
 struct EjContestInfo *
 contest_info_read_lock(struct EjContestState *ecs)
 {
-    atomic_fetch_add_explicit(&ecs->info_guard, 1, memory_order_acquire);
-    struct EjContestInfo *data = atomic_load_explicit(&ecs->info, memory_order_relaxed);
-    atomic_fetch_add_explicit(&data->reader_count, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&ecs->info_guard, 1, memory_order_release);
-    return data;
+    return ebr_slot_acquire(&ecs->info.obj);
 }
 
 struct EjContestInfo *
 contests_info_read_lock(struct EjContestsState *ecss, int cnts_id)
 {
-    return contest_info_read_lock(contests_state_get(ecss, cnts_id));
+    struct EjContestState *ecs = contests_state_try(ecss, cnts_id);
+    if (!ecs) return NULL;
+    return contest_info_read_lock(ecs);
 }
 
 void
 contest_info_read_unlock(struct EjContestInfo *eci)
 {
-    if (eci) {
-        atomic_fetch_sub_explicit(&eci->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(eci);
 }
 
 int
 contest_info_try_write_lock(struct EjContestState *ecs)
 {
-    return atomic_exchange_explicit(&ecs->info_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ecs->info.update, 1, memory_order_acquire);
 }
 
 void
 contest_info_set(struct EjContestState *ecs, struct EjContestInfo *ecd)
 {
-    struct EjContestInfo *old = atomic_exchange_explicit(&ecs->info, ecd, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ecs->info_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ecs->info_update, 0, memory_order_release);
+    struct EjContestInfo *old = ebr_slot_exchange(&ecs->info.obj, ecd);
+    single_flight_done(&ecs->info.update);
+    ebr_retire(old, contest_info_retire);
+}
+
+static int
+same_name(const unsigned char *s1, const unsigned char *s2)
+{
+    if (!s1 || !s2) return s1 == s2;
+    return !strcmp(s1, s2);
+}
 
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_acquire, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
+int
+contest_info_same_names(const struct EjContestInfo *eci1, const struct EjContestInfo *eci2)
+{
+    if (!eci1 || !eci2 || !eci1->ok || !eci2->ok) return 0;
+    if (eci1->prob_size != eci2->prob_size || eci1->compiler_size != eci2->compiler_size) return 0;
+    for (int i = 0; i < eci1->prob_size; ++i) {
+        const struct EjContestProblem *p1 = eci1->probs[i], *p2 = eci2->probs[i];
+        if (!p1 || !p2) {
+            if (p1 != p2) return 0;
+        } else if (!same_name(p1->short_name, p2->short_name)) {
+            return 0;
         }
-        contest_info_free(old);
     }
+    for (int i = 0; i < eci1->compiler_size; ++i) {
+        const struct EjContestCompiler *c1 = eci1->compilers[i], *c2 = eci2->compilers[i];
+        if (!c1 || !c2) {
+            if (c1 != c2) return 0;
+        } else if (!same_name(c1->short_name, c2->short_name)) {
+            return 0;
+        }
+    }
+    return 1;
 }
 
 struct EjContestLog *
 contest_log_read_lock(struct EjContestState *ecs)
 {
-    atomic_fetch_add_explicit(&ecs->log_guard, 1, memory_order_acquire);
-    struct EjContestLog *log = atomic_load_explicit(&ecs->log, memory_order_relaxed);
-    atomic_fetch_add_explicit(&log->reader_count, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&ecs->log_guard, 1, memory_order_release);
-    return log;
+    return ebr_slot_acquire(&ecs->log.obj);
 }
 
 struct EjContestLog *
 contests_log_read_lock(struct EjContestsState *ecss, int cnts_id)
 {
-    return contest_log_read_lock(contests_state_get(ecss, cnts_id));
+    struct EjContestState *ecs = contests_state_try(ecss, cnts_id);
+    if (!ecs) return NULL;
+    return contest_log_read_lock(ecs);
 }
 
 void
 contests_log_read_unlock(struct EjContestLog *ecl)
 {
-    if (ecl) {
-        atomic_fetch_sub_explicit(&ecl->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(ecl);
 }
 
 struct EjContestState *
@@ -384,21 +562,9 @@ contests_log_write_lock(struct EjContestsState *ecss, int cnts_id)
 void
 contest_log_set(struct EjContestState *ecs, struct EjContestLog *ecl)
 {
-    struct EjContestLog *old = atomic_exchange_explicit(&ecs->log, ecl, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ecs->log_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
+    struct EjContestLog *old = ebr_slot_exchange(&ecs->log.obj, ecl);
     pthread_mutex_unlock(&ecs->log_mutex);
-
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_acquire, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        contest_log_free(old);
-    }
+    ebr_retire(old, contest_log_retire);
 }
 
 void
@@ -409,9 +575,9 @@ contest_log_append(struct EjContestState *ecs, const unsigned char *text)
     pthread_mutex_lock(&ecs->log_mutex);
     struct EjContestLog *nl = contest_log_create(NULL);
     size_t tz = strlen(text);
-    size_t nz = ecs->log->size + tz;
+    size_t nz = ecs->log.obj->size + tz;
     unsigned char *nt = malloc(nz + 1);
-    unsigned char *p = stpcpy(nt, ecs->log->text);
+    unsigned char *p = stpcpy(nt, ecs->log.obj->text);
     stpcpy(p, text);
     free(nl->text);
     nl->size = nz;
@@ -422,58 +588,43 @@ contest_log_append(struct EjContestState *ecs, const unsigned char *text)
 struct EjContestSession *
 contest_session_read_lock(struct EjContestState *ecs)
 {
-    atomic_fetch_add_explicit(&ecs->session_guard, 1, memory_order_acquire);
-    struct EjContestSession *ecc = atomic_load_explicit(&ecs->session, memory_order_relaxed);
-    atomic_fetch_add_explicit(&ecc->reader_count, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&ecs->session_guard, 1, memory_order_release);
-    return ecc;
+    return ebr_slot_acquire(&ecs->session.obj);
 }
 
 struct EjContestSession *
 contests_session_read_lock(struct EjContestsState *ecss, int cnts_id)
 {
-    return contest_session_read_lock(contests_state_get(ecss, cnts_id));
+    struct EjContestState *ecs = contests_state_try(ecss, cnts_id);
+    if (!ecs) return NULL;
+    return contest_session_read_lock(ecs);
 }
 
 void
 contest_session_read_unlock(struct EjContestSession *ecc)
 {
-    if (ecc) {
-        atomic_fetch_sub_explicit(&ecc->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(ecc);
 }
 
 int
 contest_session_try_write_lock(struct EjContestState *ecs)
 {
-    return atomic_exchange_explicit(&ecs->session_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ecs->session.update, 1, memory_order_acquire);
 }
 
 void
 contest_session_set(struct EjContestState *ecs, struct EjContestSession *ecc)
 {
-    struct EjContestSession *old = atomic_exchange_explicit(&ecs->session, ecc, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ecs->session_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ecs->session_update, 0, memory_order_release);
-
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_acquire, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        contest_session_free(old);
-    }
+    struct EjContestSession *old = ebr_slot_exchange(&ecs->session.obj, ecc);
+    single_flight_done(&ecs->session.update);
+    ebr_retire(old, contest_session_retire);
 }
 
 struct EjProblemStates *
-problem_states_create(void)
+problem_states_create(int cnts_id)
 {
     struct EjProblemStates *epss = calloc(1, sizeof(*epss));
     pthread_rwlock_init(&epss->rwl, NULL);
+    epss->cnts_id = cnts_id;
     return epss;
 }
 
@@ -514,7 +665,7 @@ problem_states_get(struct EjProblemStates *epss, int prob_id)
     }
     retval = epss->entries[prob_id];
     if (!retval) {
-        retval = epss->entries[prob_id] = problem_state_create(prob_id);
+        retval = epss->entries[prob_id] = problem_state_create(epss->cnts_id, prob_id);
     }
     pthread_rwlock_unlock(&epss->rwl);
 
@@ -535,10 +686,17 @@ problem_states_try(struct EjProblemStates *epss, int prob_id)
 }
 
 struct EjProblemState *
-problem_state_create(int prob_id)
+problem_state_create(int cnts_id, int prob_id)
 {
-    struct EjProblemState *eps = calloc(1, sizeof(*eps));
+    struct EjProblemState *eps = aligned_alloc(_Alignof(struct EjProblemState), sizeof(*eps));
+    memset(eps, 0, sizeof(*eps));
     eps->prob_id = prob_id;
+    eps->inode = inode_code_make(INODE_KIND_PROBLEM, cnts_id, prob_id, 0);
+    eps->info_inode = inode_code_make(INODE_KIND_PROBLEM_INFO, cnts_id, prob_id, 0);
+    eps->info_json_inode = inode_code_make(INODE_KIND_PROBLEM_INFO_JSON, cnts_id, prob_id, 0);
+    eps->stmt_inode = inode_code_make(INODE_KIND_PROBLEM_STATEMENT, cnts_id, prob_id, 0);
+    eps->runs_inode = inode_code_make(INODE_KIND_RUNS, cnts_id, prob_id, 0);
+    eps->submit_inode = inode_code_make(INODE_KIND_SUBMIT, cnts_id, prob_id, 0);
     eps->submits = problem_submits_create();
     return eps;
 }
@@ -554,7 +712,8 @@ problem_state_free(struct EjProblemState *eps)
 struct EjProblemInfo *
 problem_info_create(int prob_id)
 {
-    struct EjProblemInfo *epi = calloc(1, sizeof(*epi));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjProblemInfo *epi = slab_alloc(problem_info_slab);
     epi->acm_run_penalty = 20;
     epi->test_score = 1;
     epi->best_run = -1;
@@ -581,60 +740,44 @@ problem_info_free(struct EjProblemInfo *epi)
         free(epi->compilers);
         free(epi->log_s);
         free(epi->penalty_formula);
-        free(epi);
+        dir_listing_free(epi->submit_listing);
+        slab_free(problem_info_slab, epi);
     }
 }
 
 struct EjProblemInfo *
 problem_info_read_lock(struct EjProblemState *eps)
 {
-    atomic_fetch_add_explicit(&eps->info_guard, 1, memory_order_acquire);
-    struct EjProblemInfo *epi = atomic_load_explicit(&eps->info, memory_order_relaxed);
-    if (epi) {
-        atomic_fetch_add_explicit(&epi->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&eps->info_guard, 1, memory_order_release);
-    return epi;
+    return ebr_slot_acquire(&eps->info.obj);
 }
 
 void
 problem_info_read_unlock(struct EjProblemInfo *epi)
 {
-    if (epi) {
-        atomic_fetch_sub_explicit(&epi->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(epi);
 }
 
 int
 problem_info_try_write_lock(struct EjProblemState *eps)
 {
-    return atomic_exchange_explicit(&eps->info_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&eps->info.update, 1, memory_order_acquire);
 }
 
 void
 problem_info_set(struct EjProblemState *eps, struct EjProblemInfo *epi)
 {
-    struct EjProblemInfo *old = atomic_exchange_explicit(&eps->info, epi, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&eps->info_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&eps->info_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        problem_info_free(old);
-    }
+    struct EjProblemInfo *old = ebr_slot_exchange(&eps->info.obj, epi);
+    single_flight_done(&eps->info.update);
+    ebr_retire(old, problem_info_retire);
 }
 
 struct EjProblemStatement *
 problem_statement_create(int prob_id)
 {
-    struct EjProblemStatement *eph = calloc(1, sizeof(*eph));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjProblemStatement *eph = slab_alloc(problem_statement_slab);
     eph->prob_id = prob_id;
+    eph->stmt_fd = -1;
     return eph;
 }
 
@@ -643,62 +786,52 @@ problem_statement_free(struct EjProblemStatement *eph)
 {
     if (eph) {
         free(eph->log_s);
-        free(eph->stmt_text);
-        free(eph);
+        memfd_blob_free(eph->stmt_text, eph->stmt_size, eph->stmt_fd);
+        slab_free(problem_statement_slab, eph);
     }
 }
 
 struct EjProblemStatement *
 problem_statement_read_lock(struct EjProblemState *eps)
 {
-    atomic_fetch_add_explicit(&eps->stmt_guard, 1, memory_order_acquire);
-    struct EjProblemStatement *eph = atomic_load_explicit(&eps->stmt, memory_order_relaxed);
-    if (eph) {
-        atomic_fetch_add_explicit(&eph->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&eps->stmt_guard, 1, memory_order_release);
-    return eph;
+    return ebr_slot_acquire(&eps->stmt.obj);
 }
 
 void
 problem_statement_read_unlock(struct EjProblemStatement *eph)
 {
-    if (eph) {
-        atomic_fetch_sub_explicit(&eph->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(eph);
 }
 
 int
 problem_statement_try_write_lock(struct EjProblemState *eps)
 {
-    return atomic_exchange_explicit(&eps->stmt_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&eps->stmt.update, 1, memory_order_acquire);
 }
 
 void
 problem_statement_set(struct EjProblemState *eps, struct EjProblemStatement *eph)
 {
-    struct EjProblemStatement *old = atomic_exchange_explicit(&eps->stmt, eph, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&eps->stmt_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&eps->stmt_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        problem_statement_free(old);
-    }
+    struct EjProblemStatement *old = ebr_slot_exchange(&eps->stmt.obj, eph);
+    single_flight_done(&eps->stmt.update);
+    ebr_retire(old, problem_statement_retire);
 }
 
 struct EjRunState *
-run_state_create(int run_id)
+run_state_create(int cnts_id, int run_id)
 {
-    struct EjRunState *ejr = calloc(1, sizeof(*ejr));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjRunState *ejr = slab_alloc(run_state_slab);
     ejr->run_id = run_id;
-    ejr->tests = run_tests_create();
+    ejr->inode = inode_code_make(INODE_KIND_RUN, cnts_id, run_id, 0);
+    ejr->info_inode = inode_code_make(INODE_KIND_RUN_INFO, cnts_id, run_id, 0);
+    ejr->info_json_inode = inode_code_make(INODE_KIND_RUN_INFO_JSON, cnts_id, run_id, 0);
+    ejr->compiler_inode = inode_code_make(INODE_KIND_RUN_COMPILER, cnts_id, run_id, 0);
+    ejr->valuer_inode = inode_code_make(INODE_KIND_RUN_VALUER, cnts_id, run_id, 0);
+    ejr->src_inode = inode_code_make(INODE_KIND_RUN_SOURCE, cnts_id, run_id, 0);
+    ejr->msg_inode = inode_code_make(INODE_KIND_RUN_MESSAGES, cnts_id, run_id, 0);
+    ejr->tests_inode = inode_code_make(INODE_KIND_TESTS, cnts_id, run_id, 0);
+    ejr->tests = run_tests_create(cnts_id, run_id);
     return ejr;
 }
 
@@ -707,15 +840,15 @@ run_state_free(struct EjRunState *ejr)
 {
     if (ejr) {
         run_tests_free(ejr->tests);
-        free(ejr);
+        slab_free(run_state_slab, ejr);
     }
 }
 
 struct EjRunStates *
-run_states_create(void)
+run_states_create(int cnts_id)
 {
     struct EjRunStates *ejrs = calloc(1, sizeof(*ejrs));
-    pthread_rwlock_init(&ejrs->rwl, NULL);
+    ejrs->cnts_id = cnts_id;
     return ejrs;
 }
 
@@ -723,11 +856,14 @@ void
 run_states_free(struct EjRunStates *ejrs)
 {
     if (ejrs) {
-        pthread_rwlock_destroy(&ejrs->rwl);
-        for (int i = 0; i < ejrs->size; ++i) {
-            free(ejrs->runs[i]);
+        for (int i = 0; i < RUN_STATES_PAGE_COUNT; ++i) {
+            struct EjRunStatesPage *page = ejrs->pages[i];
+            if (!page) continue;
+            for (int j = 0; j < RUN_STATES_PAGE_SIZE; ++j) {
+                run_state_free(page->runs[j]);
+            }
+            free(page);
         }
-        free(ejrs->runs);
         free(ejrs);
     }
 }
@@ -735,67 +871,29 @@ run_states_free(struct EjRunStates *ejrs)
 struct EjRunState *
 run_states_get(struct EjRunStates *erss, int run_id)
 {
-    struct EjRunState *ers = NULL;
-    int low, high;
+    if (run_id < 0 || run_id >= RUN_STATES_PAGE_COUNT * RUN_STATES_PAGE_SIZE) return NULL;
 
-    pthread_rwlock_rdlock(&erss->rwl);
-    if (erss->size > 0 && run_id >= erss->runs[0]->run_id && run_id <= erss->runs[erss->size - 1]->run_id) {
-        low = 0; high = erss->size;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            ers = erss->runs[mid];
-            if (ers->run_id == run_id) {
-                pthread_rwlock_unlock(&erss->rwl);
-                return ers;
-            } else if (ers->run_id < run_id) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
-        }
-    }
-    pthread_rwlock_unlock(&erss->rwl);
-    pthread_rwlock_wrlock(&erss->rwl);
-    if (erss->size <= 0 || run_id < erss->runs[0]->run_id) {
-        low = high = 0;
-        ers = NULL;
-    } else if (run_id > erss->runs[erss->size - 1]->run_id) {
-        low = high = erss->size;
-        ers = NULL;
-    } else {
-        low = 0; high = erss->size;
-        ers = NULL;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            struct EjRunState *tmp = erss->runs[mid];
-            if (tmp->run_id == run_id) {
-                ers = tmp;
-                break;
-            } else if (tmp->run_id < run_id) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
+    struct EjRunStatesPage * _Atomic *p_page = &erss->pages[run_id >> RUN_STATES_PAGE_BITS];
+    struct EjRunStatesPage *page = atomic_load_explicit(p_page, memory_order_acquire);
+    if (!page) {
+        struct EjRunStatesPage *new_page = calloc(1, sizeof(*new_page));
+        if (atomic_compare_exchange_strong_explicit(p_page, &page, new_page, memory_order_acq_rel, memory_order_acquire)) {
+            page = new_page;
+        } else {
+            free(new_page);
         }
     }
-    if (ers) {
-        pthread_rwlock_unlock(&erss->rwl);
-        return ers;
-    }
-    if (erss->size >= erss->reserved) {
-        if (!erss->reserved) {
-            erss->reserved = 16;
+
+    struct EjRunState * _Atomic *p_ers = &page->runs[run_id & (RUN_STATES_PAGE_SIZE - 1)];
+    struct EjRunState *ers = atomic_load_explicit(p_ers, memory_order_acquire);
+    if (!ers) {
+        struct EjRunState *new_ers = run_state_create(erss->cnts_id, run_id);
+        if (atomic_compare_exchange_strong_explicit(p_ers, &ers, new_ers, memory_order_acq_rel, memory_order_acquire)) {
+            ers = new_ers;
         } else {
-            erss->reserved *= 2;
+            run_state_free(new_ers);
         }
-        erss->runs = realloc(erss->runs, erss->reserved * sizeof(erss->runs[0]));
     }
-    if (low < erss->size) {
-        memmove(&erss->runs[low + 1], &erss->runs[low], (erss->size - low) * sizeof(erss->runs[0]));
-    }
-    ++erss->size;
-    ers = erss->runs[low] = run_state_create(run_id);
-    pthread_rwlock_unlock(&erss->rwl);
     return ers;
 }
 
@@ -897,7 +995,8 @@ problem_submits_get(struct EjProblemSubmits *epss, int lang_id)
 struct EjProblemRuns *
 problem_runs_create(int prob_id)
 {
-    struct EjProblemRuns *eprs = calloc(1, sizeof(*eprs));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjProblemRuns *eprs = slab_alloc(problem_runs_slab);
     eprs->prob_id = prob_id;
     return eprs;
 }
@@ -908,54 +1007,36 @@ problem_runs_free(struct EjProblemRuns *eprs)
     if (eprs) {
         free(eprs->log_s);
         free(eprs->runs);
+        dir_listing_free(eprs->listing);
         free(eprs->info_json_text);
-        free(eprs);
+        slab_free(problem_runs_slab, eprs);
     }
 }
 
 struct EjProblemRuns *
 problem_runs_read_lock(struct EjProblemState *eps)
 {
-    atomic_fetch_add_explicit(&eps->runs_guard, 1, memory_order_acquire);
-    struct EjProblemRuns *eprs = atomic_load_explicit(&eps->runs, memory_order_relaxed);
-    if (eprs) {
-        atomic_fetch_add_explicit(&eprs->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&eps->runs_guard, 1, memory_order_release);
-    return eprs;
+    return ebr_slot_acquire(&eps->runs.obj);
 }
 
 void
 problem_runs_read_unlock(struct EjProblemRuns *eprs)
 {
-    if (eprs) {
-        atomic_fetch_sub_explicit(&eprs->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(eprs);
 }
 
 int
 problem_runs_try_write_lock(struct EjProblemState *eps)
 {
-    return atomic_exchange_explicit(&eps->runs_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&eps->runs.update, 1, memory_order_acquire);
 }
 
 void
 problem_runs_set(struct EjProblemState *eps, struct EjProblemRuns *eprs)
 {
-    struct EjProblemRuns *old = atomic_exchange_explicit(&eps->runs, eprs, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&eps->runs_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&eps->runs_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        problem_runs_free(old);
-    }
+    struct EjProblemRuns *old = ebr_slot_exchange(&eps->runs.obj, eprs);
+    single_flight_done(&eps->runs.update);
+    ebr_retire(old, problem_runs_retire);
 }
 
 struct EjProblemRun *
@@ -978,10 +1059,24 @@ problem_runs_find_unlocked(struct EjProblemRuns *eprs, int run_id)
     return NULL;
 }
 
+int
+problem_runs_same_runs(const struct EjProblemRuns *eprs1, const struct EjProblemRuns *eprs2)
+{
+    if (!eprs1 || !eprs2 || !eprs1->ok || !eprs2->ok) return 0;
+    if (eprs1->size != eprs2->size) return 0;
+    for (int i = 0; i < eprs1->size; ++i) {
+        if (eprs1->runs[i].run_id != eprs2->runs[i].run_id) return 0;
+    }
+    return 1;
+}
+
 struct EjRunInfo *
 run_info_create(int run_id)
 {
-    struct EjRunInfo *eri = calloc(1, sizeof(*eri));
+    // the run info and everything parsed into it share one arena
+    struct EjArena *ea = arena_create(EJFUSE_RUN_INFO_ARENA_SIZE);
+    struct EjRunInfo *eri = arena_calloc(ea, 1, sizeof(*eri));
+    eri->arena = ea;
     eri->run_id = run_id;
     return eri;
 }
@@ -990,61 +1085,79 @@ void
 run_info_free(struct EjRunInfo *eri)
 {
     if (eri) {
-        free(eri->log_s);
-        free(eri->info_json_text);
-        free(eri->info_text);
-        free(eri->compiler_text);
-        free(eri->src_sfx);
-        free(eri->score_str);
-        free(eri->valuer_text);
-        free(eri->tests);
-        free(eri);
+        dir_listing_free(eri->tests_listing);
+        arena_free(eri->arena);
     }
 }
 
 struct EjRunInfo *
 run_info_read_lock(struct EjRunState *ers)
 {
-    atomic_fetch_add_explicit(&ers->info_guard, 1, memory_order_acquire);
-    struct EjRunInfo *eri = atomic_load_explicit(&ers->info, memory_order_relaxed);
-    if (eri) {
-        atomic_fetch_add_explicit(&eri->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&ers->info_guard, 1, memory_order_release);
-    return eri;
+    return ebr_slot_acquire(&ers->info.obj);
 }
 
 void
 run_info_read_unlock(struct EjRunInfo *eri)
 {
-    if (eri) {
-        atomic_fetch_sub_explicit(&eri->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(eri);
 }
 
 int
 run_info_try_write_lock(struct EjRunState *ers)
 {
-    return atomic_exchange_explicit(&ers->info_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ers->info.update, 1, memory_order_acquire);
+}
+
+/*
+ * The generation is kept while a refetched blob has the same content as
+ * the one it replaces, so the kernel page cache may survive reopening.
+ * New generations come from one counter, so a blob refetched after a
+ * failed fetch never gets the generation of the content cached before.
+ */
+static _Atomic unsigned content_gen_last;
+
+unsigned
+content_gen_next(
+        unsigned old_gen,
+        const unsigned char *old_data,
+        size_t old_size,
+        const unsigned char *new_data,
+        size_t new_size)
+{
+    if (old_gen && old_size == new_size
+        && (!new_size || memcmp(old_data, new_data, new_size) == 0)) {
+        return old_gen;
+    }
+    unsigned gen = atomic_fetch_add_explicit(&content_gen_last, 1, memory_order_relaxed) + 1;
+    if (!gen) gen = atomic_fetch_add_explicit(&content_gen_last, 1, memory_order_relaxed) + 1;
+    return gen;
+}
+
+// returns 1 if the content did not change since the last open
+_Bool
+content_gen_keep_cache(_Atomic unsigned *p_open_gen, unsigned gen)
+{
+    if (!gen) return 0;
+    return atomic_exchange_explicit(p_open_gen, gen, memory_order_relaxed) == gen;
 }
 
 void
 run_info_set(struct EjRunState *ers, struct EjRunInfo *eri)
 {
-    struct EjRunInfo *old = atomic_exchange_explicit(&ers->info, eri, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ers->info_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ers->info_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
+    // writers are serialized by run_info_try_write_lock
+    struct EjRunInfo *cur = atomic_load_explicit(&ers->info.obj, memory_order_acquire);
+    if (eri && eri->ok) {
+        if (cur && cur->ok) {
+            eri->compiler_gen = content_gen_next(cur->compiler_gen, cur->compiler_text, cur->compiler_size, eri->compiler_text, eri->compiler_size);
+            eri->valuer_gen = content_gen_next(cur->valuer_gen, cur->valuer_text, cur->valuer_size, eri->valuer_text, eri->valuer_size);
+        } else {
+            eri->compiler_gen = content_gen_next(0, NULL, 0, eri->compiler_text, eri->compiler_size);
+            eri->valuer_gen = content_gen_next(0, NULL, 0, eri->valuer_text, eri->valuer_size);
         }
-        run_info_free(old);
     }
+    struct EjRunInfo *old = ebr_slot_exchange(&ers->info.obj, eri);
+    single_flight_done(&ers->info.update);
+    ebr_retire(old, run_info_retire);
 }
 
 struct EjRunInfoTestResult *
@@ -1059,11 +1172,28 @@ run_info_get_test_result_unlocked(struct EjRunInfo *eri, int num)
     return NULL;
 }
 
+int
+run_info_same_tests(const struct EjRunInfo *eri1, const struct EjRunInfo *eri2)
+{
+    if (!eri1 || !eri2 || !eri1->ok || !eri2->ok) return 0;
+    if (eri1->is_test_available != eri2->is_test_available) return 0;
+    if (eri1->test_count != eri2->test_count) return 0;
+    for (int i = 0; i < eri1->test_count; ++i) {
+        if (eri1->tests[i].num != eri2->tests[i].num
+            || eri1->tests[i].is_visibility_full != eri2->tests[i].is_visibility_full) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 struct EjRunSource *
 run_source_create(int run_id)
 {
-    struct EjRunSource *ert = calloc(1, sizeof(*ert));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjRunSource *ert = slab_alloc(run_source_slab);
     ert->run_id = run_id;
+    ert->data_fd = -1;
     return ert;
 }
 
@@ -1072,60 +1202,50 @@ run_source_free(struct EjRunSource *ert)
 {
     if (ert) {
         free(ert->log_s);
-        free(ert->data);
-        free(ert);
+        memfd_blob_free(ert->data, ert->size, ert->data_fd);
+        slab_free(run_source_slab, ert);
     }
 }
 
 struct EjRunSource *
 run_source_read_lock(struct EjRunState *ers)
 {
-    atomic_fetch_add_explicit(&ers->src_guard, 1, memory_order_acquire);
-    struct EjRunSource *ert = atomic_load_explicit(&ers->src, memory_order_relaxed);
-    if (ert) {
-        atomic_fetch_add_explicit(&ert->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&ers->src_guard, 1, memory_order_release);
-    return ert;
+    return ebr_slot_acquire(&ers->src.obj);
 }
 
 void
 run_source_read_unlock(struct EjRunSource *ert)
 {
-    if (ert) {
-        atomic_fetch_sub_explicit(&ert->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(ert);
 }
 
 int
 run_source_try_write_lock(struct EjRunState *ers)
 {
-    return atomic_exchange_explicit(&ers->src_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ers->src.update, 1, memory_order_acquire);
 }
 
 void
 run_source_set(struct EjRunState *ers, struct EjRunSource *eri)
 {
-    struct EjRunSource *old = atomic_exchange_explicit(&ers->src, eri, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ers->src_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ers->src_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
+    struct EjRunSource *cur = atomic_load_explicit(&ers->src.obj, memory_order_acquire);
+    if (eri && eri->ok) {
+        if (cur && cur->ok) {
+            eri->gen = content_gen_next(cur->gen, cur->data, cur->size, eri->data, eri->size);
+        } else {
+            eri->gen = content_gen_next(0, NULL, 0, eri->data, eri->size);
         }
-        run_source_free(old);
     }
+    struct EjRunSource *old = ebr_slot_exchange(&ers->src.obj, eri);
+    single_flight_done(&ers->src.update);
+    ebr_retire(old, run_source_retire);
 }
 
 struct EjRunMessages *
 run_messages_create(int run_id)
 {
-    struct EjRunMessages *erms = calloc(1, sizeof(*erms));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjRunMessages *erms = slab_alloc(run_messages_slab);
     erms->run_id = run_id;
     return erms;
 }
@@ -1143,60 +1263,43 @@ run_messages_free(struct EjRunMessages *erms)
         free(erms->json_text);
         free(erms->text);
         free(erms->log_s);
-        free(erms);
+        slab_free(run_messages_slab, erms);
     }
 }
 
 struct EjRunMessages *
 run_messages_read_lock(struct EjRunState *ers)
 {
-    atomic_fetch_add_explicit(&ers->msg_guard, 1, memory_order_acquire);
-    struct EjRunMessages *ert = atomic_load_explicit(&ers->msg, memory_order_relaxed);
-    if (ert) {
-        atomic_fetch_add_explicit(&ert->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&ers->msg_guard, 1, memory_order_release);
-    return ert;
+    return ebr_slot_acquire(&ers->msg.obj);
 }
 
 void
 run_messages_read_unlock(struct EjRunMessages *erms)
 {
-    if (erms) {
-        atomic_fetch_sub_explicit(&erms->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(erms);
 }
 
 int
 run_messages_try_write_lock(struct EjRunState *ers)
 {
-    return atomic_exchange_explicit(&ers->msg_update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ers->msg.update, 1, memory_order_acquire);
 }
 
 void
 run_messages_set(struct EjRunState *ers, struct EjRunMessages *erms)
 {
-    struct EjRunMessages *old = atomic_exchange_explicit(&ers->msg, erms, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ers->msg_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ers->msg_update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        run_messages_free(old);
-    }
+    struct EjRunMessages *old = ebr_slot_exchange(&ers->msg.obj, erms);
+    single_flight_done(&ers->msg.update);
+    ebr_retire(old, run_messages_retire);
 }
 
 struct EjRunTests *
-run_tests_create(void)
+run_tests_create(int cnts_id, int run_id)
 {
     struct EjRunTests *erts = calloc(1, sizeof(*erts));
     pthread_rwlock_init(&erts->rwl, NULL);
+    erts->cnts_id = cnts_id;
+    erts->run_id = run_id;
     return erts;
 }
 
@@ -1241,7 +1344,7 @@ run_tests_get(struct EjRunTests *erts, int num)
         }
         ert = erts->tests[num - 1];
         if (!ert) {
-            ert = erts->tests[num - 1] = run_test_create(num);
+            ert = erts->tests[num - 1] = run_test_create(erts->cnts_id, erts->run_id, num);
         }
         pthread_rwlock_unlock(&erts->rwl);
     }
@@ -1249,10 +1352,15 @@ run_tests_get(struct EjRunTests *erts, int num)
 }
 
 struct EjRunTest *
-run_test_create(int num)
+run_test_create(int cnts_id, int run_id, int num)
 {
-    struct EjRunTest *ert = calloc(1, sizeof(*ert));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjRunTest *ert = slab_alloc(run_test_slab);
     ert->num = num;
+    ert->inode = inode_code_make(INODE_KIND_TEST, cnts_id, run_id, num);
+    for (int i = 0; i < TESTING_REPORT_LAST; ++i) {
+        ert->parts[i].inode = inode_code_make(INODE_KIND_TEST_PART + i, cnts_id, run_id, num);
+    }
     return ert;
 }
 
@@ -1260,14 +1368,16 @@ void
 run_test_free(struct EjRunTest *ert)
 {
     if (ert) {
-        free(ert);
+        slab_free(run_test_slab, ert);
     }
 }
 
 struct EjRunTestData *
 run_test_data_create(void)
 {
-    struct EjRunTestData *ertd = calloc(1, sizeof(*ertd));
+    pthread_once(&state_slabs_once, state_slabs_init);
+    struct EjRunTestData *ertd = slab_alloc(run_test_data_slab);
+    ertd->data_fd = -1;
     return ertd;
 }
 
@@ -1275,8 +1385,8 @@ void
 run_test_data_free(struct EjRunTestData *ertd)
 {
     if (ertd) {
-        free(ertd->data);
-        free(ertd);
+        memfd_blob_free(ertd->data, ertd->size, ertd->data_fd);
+        slab_free(run_test_data_slab, ertd);
     }
 }
 
@@ -1285,21 +1395,13 @@ run_test_data_read_lock(struct EjRunTest *ert, int index)
 {
     if (index < 0 || index >= TESTING_REPORT_LAST) return NULL;
     struct EjRunTestPart *ertp = &ert->parts[index];
-    atomic_fetch_add_explicit(&ertp->guard, 1, memory_order_acquire);
-    struct EjRunTestData *ertd = atomic_load_explicit(&ertp->info, memory_order_relaxed);
-    if (ertd) {
-        atomic_fetch_add_explicit(&ertd->reader_count, 1, memory_order_relaxed);
-    }
-    atomic_fetch_sub_explicit(&ertp->guard, 1, memory_order_release);
-    return ertd;
+    return ebr_slot_acquire(&ertp->data.obj);
 }
 
 void
 run_test_data_read_unlock(struct EjRunTestData *ertd)
 {
-    if (ertd) {
-        atomic_fetch_sub_explicit(&ertd->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(ertd);
 }
 
 int
@@ -1307,7 +1409,7 @@ run_test_data_try_write_lock(struct EjRunTest *ert, int index)
 {
     if (index < 0 || index >= TESTING_REPORT_LAST) return 1;
     struct EjRunTestPart *ertp = &ert->parts[index];
-    return atomic_exchange_explicit(&ertp->update, 1, memory_order_acquire);
+    return atomic_exchange_explicit(&ertp->data.update, 1, memory_order_acquire);
 }
 
 void
@@ -1315,20 +1417,17 @@ run_test_data_set(struct EjRunTest *ert, int index, struct EjRunTestData *ertd)
 {
     if (index < 0 || index >= TESTING_REPORT_LAST) return;
     struct EjRunTestPart *ertp = &ert->parts[index];
-    struct EjRunTestData *old = atomic_exchange_explicit(&ertp->info, ertd, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&ertp->guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&ertp->update, 0, memory_order_release);
-    if (old) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old->reader_count, &expected, 0, memory_order_release, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
+    struct EjRunTestData *cur = atomic_load_explicit(&ertp->data.obj, memory_order_acquire);
+    if (ertd && ertd->ok) {
+        if (cur && cur->ok) {
+            ertd->gen = content_gen_next(cur->gen, cur->data, cur->size, ertd->data, ertd->size);
+        } else {
+            ertd->gen = content_gen_next(0, NULL, 0, ertd->data, ertd->size);
         }
-        run_test_data_free(old);
     }
+    struct EjRunTestData *old = ebr_slot_exchange(&ertp->data.obj, ertd);
+    single_flight_done(&ertp->data.update);
+    ebr_retire(old, run_test_data_retire);
 }
 
 static const unsigned char * const testing_info_file_names[] =
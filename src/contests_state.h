@@ -19,10 +19,28 @@
  * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "settings.h"
+
 #include <pthread.h>
 
 typedef unsigned char ejbytebool_t;
 
+/*
+ * A published object with its refresh state. The slots of the states
+ * read by many threads are aligned to EJFUSE_CACHE_LINE_SIZE, so the
+ * readers and the refresh of one object do not bounce the cache line
+ * of its siblings.
+ */
+#define EJ_STATE_SLOT(type)                                             \
+    struct                                                              \
+    {                                                                   \
+        type * _Atomic obj;                                             \
+        _Atomic _Bool update;           /* refresh in flight */         \
+        _Atomic long long access_us;    /* last access time */          \
+    }
+
+#define EJ_CACHE_ALIGNED _Alignas(EJFUSE_CACHE_LINE_SIZE)
+
 struct EjSessionValue
 {
     _Bool ok;
@@ -32,8 +50,6 @@ struct EjSessionValue
 
 struct EjContestSession
 {
-    _Atomic int reader_count;
-
     int cnts_id;
     _Bool ok;
     long long      recheck_time_us;
@@ -44,6 +60,9 @@ struct EjContestSession
     long long expire_us;
 };
 
+struct EjDirListing;
+struct EjArena;
+
 struct EjContestProblem
 {
     int id;
@@ -59,10 +78,24 @@ struct EjContestCompiler
     unsigned char *src_suffix;
 };
 
-struct EjContestInfo
+/*
+ * Immutable open addressing index of short names, built once when
+ * the contest info is parsed.
+ */
+struct EjNameIndexSlot
 {
-    _Atomic int reader_count;
+    const unsigned char *name;  // owned by the indexed object
+    int id;                     // 0 - empty slot
+};
 
+struct EjNameIndex
+{
+    unsigned mask;              // table size - 1, the size is a power of 2
+    struct EjNameIndexSlot *slots;
+};
+
+struct EjContestInfo
+{
     int cnts_id;
     _Bool ok;
     long long      recheck_time_us;
@@ -111,20 +144,23 @@ struct EjContestInfo
 
     int compiler_size;
     struct EjContestCompiler **compilers;
+
+    // problem and compiler ids by short name
+    struct EjNameIndex prob_index;
+    struct EjNameIndex compiler_index;
+
+    // pre-rendered listing of the problems directory
+    struct EjDirListing *probs_listing;
 };
 
 struct EjContestLog
 {
-    _Atomic int reader_count;
-
     size_t size;
     unsigned char *text;
 };
 
 struct EjProblemInfo
 {
-    _Atomic int reader_count;
-
     int prob_id;
     _Bool ok;
     long long recheck_time_us;
@@ -230,12 +266,13 @@ struct EjProblemInfo
 
     // estimate statement size
     int est_stmt_size;
+
+    // pre-rendered listing of the submit directory
+    struct EjDirListing *submit_listing;
 };
 
 struct EjProblemStatement
 {
-    _Atomic int reader_count;
-
     int prob_id;
     _Bool ok;
     long long recheck_time_us;
@@ -244,6 +281,7 @@ struct EjProblemStatement
 
     unsigned char *stmt_text;
     size_t stmt_size;
+    int stmt_fd;                        // memfd of stmt_text or -1
 };
 
 struct EjDirectoryNodes;
@@ -269,8 +307,6 @@ struct EjProblemRun
 
 struct EjProblemRuns
 {
-    _Atomic int reader_count;
-
     int prob_id;
     _Bool ok;
     long long recheck_time_us;
@@ -282,6 +318,9 @@ struct EjProblemRuns
 
     int size;
     struct EjProblemRun *runs;
+
+    // pre-rendered listing of the runs directory
+    struct EjDirListing *listing;
 };
 
 // problem state is a container for updateable data structures
@@ -289,17 +328,19 @@ struct EjProblemState
 {
     int prob_id;
 
-    _Atomic int info_guard;
-    struct EjProblemInfo *info;
-    _Atomic _Bool info_update;
+    // inode numbers of the problem directory and its fixed entries
+    unsigned long long inode;
+    unsigned long long info_inode;
+    unsigned long long info_json_inode;
+    unsigned long long stmt_inode;
+    unsigned long long runs_inode;
+    unsigned long long submit_inode;
 
-    _Atomic int stmt_guard;
-    struct EjProblemStatement *stmt;
-    _Atomic _Bool stmt_update;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjProblemInfo) info;
 
-    _Atomic int runs_guard;
-    struct EjProblemRuns *runs;
-    _Atomic _Bool runs_update;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjProblemStatement) stmt;
+
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjProblemRuns) runs;
 
     struct EjProblemSubmits *submits;
 };
@@ -341,7 +382,8 @@ struct EjRunInfoTestResult
 
 struct EjRunInfo
 {
-    _Atomic int reader_count;
+    // owns the structure and all its strings and arrays
+    struct EjArena *arena;
 
     _Bool ok;
     long long recheck_time_us;
@@ -354,6 +396,10 @@ struct EjRunInfo
     unsigned char *info_text;
     size_t info_size;
 
+    // content generations, see run_info_set
+    unsigned compiler_gen;
+    unsigned valuer_gen;
+
     int run_id;
 
     time_t server_time;
@@ -400,12 +446,13 @@ struct EjRunInfo
 
     int test_count;
     struct EjRunInfoTestResult *tests;
+
+    // pre-rendered listing of the tests directory
+    struct EjDirListing *tests_listing;
 };
 
 struct EjRunSource
 {
-    _Atomic int reader_count;
-
     int run_id;
 
     _Bool ok;
@@ -416,6 +463,8 @@ struct EjRunSource
     long long mtime;
     unsigned char *data;
     size_t size;
+    int data_fd;                        // memfd of data or -1
+    unsigned gen;                       // content generation
 };
 
 struct EjRunMessage
@@ -432,8 +481,6 @@ struct EjRunMessage
 
 struct EjRunMessages
 {
-    _Atomic int reader_count;
-
     int run_id;
 
     _Bool ok;
@@ -457,8 +504,6 @@ struct EjRunMessages
 
 struct EjRunTestData
 {
-    _Atomic int reader_count;
-
     _Bool ok;
     long long recheck_time_us;
     unsigned char *log_s;
@@ -466,19 +511,23 @@ struct EjRunTestData
 
     unsigned char *data;
     size_t size;
+    int data_fd;                        // memfd of data or -1
     long long mtime_us;
+    unsigned gen;                       // content generation
 };
 
 struct EjRunTestPart
 {
-    _Atomic int guard;
-    struct EjRunTestData *info;
-    _Atomic _Bool update;
+    // parts are read one at a time, they are not padded to cache lines
+    EJ_STATE_SLOT(struct EjRunTestData) data;
+    unsigned long long inode;
+    _Atomic unsigned open_gen;          // content generation at the last open
 };
 
 struct EjRunTest
 {
     int num;
+    unsigned long long inode;
 
     struct EjRunTestPart parts[TESTING_REPORT_LAST];
 };
@@ -490,17 +539,26 @@ struct EjRunState
 {
     int run_id;
 
-    _Atomic int info_guard;
-    struct EjRunInfo *info;
-    _Atomic _Bool info_update;
+    // inode numbers of the run directory and its fixed entries
+    unsigned long long inode;
+    unsigned long long info_inode;
+    unsigned long long info_json_inode;
+    unsigned long long compiler_inode;
+    unsigned long long valuer_inode;
+    unsigned long long src_inode;
+    unsigned long long msg_inode;
+    unsigned long long tests_inode;
+
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjRunInfo) info;
 
-    _Atomic int src_guard;
-    struct EjRunSource *src;
-    _Atomic _Bool src_update;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjRunSource) src;
 
-    _Atomic int msg_guard;
-    struct EjRunMessages *msg;
-    _Atomic _Bool msg_update;
+    // content generations at the last open, for keep_cache
+    _Atomic unsigned src_open_gen;
+    _Atomic unsigned compiler_open_gen;
+    _Atomic unsigned valuer_open_gen;
+
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjRunMessages) msg;
 
     struct EjRunTests *tests;
 };
@@ -512,17 +570,23 @@ struct EjContestState
 {
     int cnts_id;
 
-    _Atomic int info_guard;
-    struct EjContestInfo * _Atomic info;
-    _Atomic _Bool info_update;
+    // inode numbers of the contest directory and its fixed entries
+    unsigned long long inode;
+    unsigned long long info_inode;
+    unsigned long long info_json_inode;
+    unsigned long long log_inode;
+    unsigned long long problems_inode;
+
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjContestInfo) info;
 
-    _Atomic int log_guard;
-    struct EjContestLog * _Atomic log;
-    pthread_mutex_t log_mutex;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjContestLog) log;
+    pthread_mutex_t log_mutex;          // serializes the writers of the log
 
-    _Atomic int session_guard;
-    struct EjContestSession * _Atomic session;
-    _Atomic _Bool session_update;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjContestSession) session;
+
+    // incremented when the contest info, a problem run list or a run info
+    // is replaced, the cached path resolutions of the contest become invalid
+    _Atomic unsigned path_gen;
 
     // PIMPL pointer to the problem list
     struct EjProblemStates *prob_states;
@@ -537,6 +601,8 @@ struct EjContestsState *contests_state_create(void);
 void contests_state_free(struct EjContestsState *ecss);
 
 struct EjContestState *contests_state_get(struct EjContestsState *ecss, int cnts_id);
+/* does not create the contest state, returns NULL if it does not exist */
+struct EjContestState *contests_state_try(struct EjContestsState *ecss, int cnts_id);
 
 struct EjContestLog *contest_log_create(const unsigned char *init_str);
 void contest_log_free(struct EjContestLog *ecl);
@@ -568,12 +634,20 @@ struct EjContestInfo *contest_info_read_lock(struct EjContestState *ecs);
 void contest_info_read_unlock(struct EjContestInfo *eci);
 int contest_info_try_write_lock(struct EjContestState *ecs);
 void contest_info_set(struct EjContestState *ecs, struct EjContestInfo *ecd);
+void contest_info_build_index(struct EjContestInfo *eci);
+int contest_info_find_problem(const struct EjContestInfo *eci, const unsigned char *short_name);
+int contest_info_find_compiler(const struct EjContestInfo *eci, const unsigned char *short_name);
+/*
+ * The *_same_* functions return 1 if the data the path resolution depends
+ * on is the same in both objects (and both are valid).
+ */
+int contest_info_same_names(const struct EjContestInfo *eci1, const struct EjContestInfo *eci2);
 
-struct EjProblemStates *problem_states_create(void);
+struct EjProblemStates *problem_states_create(int cnts_id);
 void problem_states_free(struct EjProblemStates *epss);
 struct EjProblemState *problem_states_get(struct EjProblemStates *epss, int prob_id);
 
-struct EjProblemState *problem_state_create(int prob_id);
+struct EjProblemState *problem_state_create(int cnts_id, int prob_id);
 void problem_state_free(struct EjProblemState *eps);
 
 struct EjProblemInfo *problem_info_create(int prob_id);
@@ -590,10 +664,10 @@ void problem_statement_read_unlock(struct EjProblemStatement *eph);
 int problem_statement_try_write_lock(struct EjProblemState *eps);
 void problem_statement_set(struct EjProblemState *eps, struct EjProblemStatement *eph);
 
-struct EjRunState *run_state_create(int run_id);
+struct EjRunState *run_state_create(int cnts_id, int run_id);
 void run_state_free(struct EjRunState *ejr);
 
-struct EjRunStates *run_states_create(void);
+struct EjRunStates *run_states_create(int cnts_id);
 void run_states_free(struct EjRunStates *ejrs);
 struct EjRunState *run_states_get(struct EjRunStates *erss, int run_id);
 
@@ -612,6 +686,7 @@ void problem_runs_read_unlock(struct EjProblemRuns *eprs);
 int problem_runs_try_write_lock(struct EjProblemState *eps);
 void problem_runs_set(struct EjProblemState *eps, struct EjProblemRuns *eprs);
 struct EjProblemRun *problem_runs_find_unlocked(struct EjProblemRuns *eprs, int run_id);
+int problem_runs_same_runs(const struct EjProblemRuns *eprs1, const struct EjProblemRuns *eprs2);
 
 struct EjRunInfo *run_info_create(int run_id);
 void run_info_free(struct EjRunInfo *eri);
@@ -622,6 +697,15 @@ int run_info_try_write_lock(struct EjRunState *ers);
 void run_info_set(struct EjRunState *ers, struct EjRunInfo *eri);
 
 struct EjRunInfoTestResult *run_info_get_test_result_unlocked(struct EjRunInfo *eri, int num);
+int run_info_same_tests(const struct EjRunInfo *eri1, const struct EjRunInfo *eri2);
+
+unsigned content_gen_next(
+        unsigned old_gen,
+        const unsigned char *old_data,
+        size_t old_size,
+        const unsigned char *new_data,
+        size_t new_size);
+_Bool content_gen_keep_cache(_Atomic unsigned *p_open_gen, unsigned gen);
 
 struct EjRunSource *run_source_create(int run_id);
 void run_source_free(struct EjRunSource *ert);
@@ -639,10 +723,10 @@ void run_messages_read_unlock(struct EjRunMessages *erms);
 int run_messages_try_write_lock(struct EjRunState *ers);
 void run_messages_set(struct EjRunState *ers, struct EjRunMessages *eri);
 
-struct EjRunTest *run_test_create(int num);
+struct EjRunTest *run_test_create(int cnts_id, int run_id, int num);
 void run_test_free(struct EjRunTest *ert);
 
-struct EjRunTests *run_tests_create(void);
+struct EjRunTests *run_tests_create(int cnts_id, int run_id);
 void run_tests_free(struct EjRunTests *erts);
 struct EjRunTest *run_tests_get(struct EjRunTests *erts, int num);
 
@@ -0,0 +1,216 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "curl_pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+/* TCP keep-alive settings (in seconds) */
+enum { CURL_POOL_KEEPIDLE = 60 };
+enum { CURL_POOL_KEEPINTVL = 30 };
+
+// thread-specific slot
+struct EjCurlSlot
+{
+    struct EjCurlPool *ecp;
+    CURL *curl;
+};
+
+struct EjCurlPool
+{
+    pthread_key_t slot_key;
+
+    CURLSH *share;
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+
+    pthread_mutex_t m;
+
+    // handles not cached by any thread
+    int free_reserved;
+    int free_size;
+    CURL **free_handles;
+
+    // all the handles ever created
+    int all_reserved;
+    int all_size;
+    CURL **all_handles;
+};
+
+static void
+share_lock_func(CURL *curl, curl_lock_data data, curl_lock_access access, void *ptr)
+{
+    struct EjCurlPool *ecp = (struct EjCurlPool *) ptr;
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pthread_mutex_lock(&ecp->share_locks[data]);
+    }
+}
+
+static void
+share_unlock_func(CURL *curl, curl_lock_data data, void *ptr)
+{
+    struct EjCurlPool *ecp = (struct EjCurlPool *) ptr;
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pthread_mutex_unlock(&ecp->share_locks[data]);
+    }
+}
+
+static void
+put_free_unlocked(struct EjCurlPool *ecp, CURL *curl)
+{
+    if (ecp->free_size == ecp->free_reserved) {
+        if (!(ecp->free_reserved *= 2)) ecp->free_reserved = 16;
+        ecp->free_handles = realloc(ecp->free_handles, ecp->free_reserved * sizeof(ecp->free_handles[0]));
+    }
+    ecp->free_handles[ecp->free_size++] = curl;
+}
+
+// called on thread exit: the cached handle goes back to the shared list
+static void
+slot_destructor(void *ptr)
+{
+    struct EjCurlSlot *ecs = (struct EjCurlSlot *) ptr;
+    if (ecs) {
+        if (ecs->curl) {
+            pthread_mutex_lock(&ecs->ecp->m);
+            put_free_unlocked(ecs->ecp, ecs->curl);
+            pthread_mutex_unlock(&ecs->ecp->m);
+        }
+        free(ecs);
+    }
+}
+
+struct EjCurlPool *
+curl_pool_create(void)
+{
+    struct EjCurlPool *ecp = calloc(1, sizeof(*ecp));
+    pthread_key_create(&ecp->slot_key, slot_destructor);
+    pthread_mutex_init(&ecp->m, NULL);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+        pthread_mutex_init(&ecp->share_locks[i], NULL);
+    }
+
+    ecp->share = curl_share_init();
+    if (ecp->share) {
+        curl_share_setopt(ecp->share, CURLSHOPT_LOCKFUNC, share_lock_func);
+        curl_share_setopt(ecp->share, CURLSHOPT_UNLOCKFUNC, share_unlock_func);
+        curl_share_setopt(ecp->share, CURLSHOPT_USERDATA, ecp);
+        curl_share_setopt(ecp->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(ecp->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        // may fail on old libcurl (< 7.57), then each handle keeps its own connections
+        curl_share_setopt(ecp->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+    return ecp;
+}
+
+void
+curl_pool_free(struct EjCurlPool *ecp)
+{
+    if (ecp) {
+        // the calling thread's slot is not destroyed by pthread_key_delete
+        struct EjCurlSlot *ecs = pthread_getspecific(ecp->slot_key);
+        pthread_setspecific(ecp->slot_key, NULL);
+        free(ecs);
+        pthread_key_delete(ecp->slot_key);
+
+        for (int i = 0; i < ecp->all_size; ++i) {
+            curl_easy_cleanup(ecp->all_handles[i]);
+        }
+        free(ecp->all_handles);
+        free(ecp->free_handles);
+        if (ecp->share) {
+            curl_share_cleanup(ecp->share);
+        }
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+            pthread_mutex_destroy(&ecp->share_locks[i]);
+        }
+        pthread_mutex_destroy(&ecp->m);
+        free(ecp);
+    }
+}
+
+// options which survive between requests
+static void
+setup_handle(struct EjCurlPool *ecp, CURL *curl)
+{
+    if (ecp->share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, ecp->share);
+    }
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, (long) CURL_POOL_KEEPIDLE);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, (long) CURL_POOL_KEEPINTVL);
+    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+}
+
+CURL *
+curl_pool_acquire(struct EjCurlPool *ecp)
+{
+    CURL *curl = NULL;
+    struct EjCurlSlot *ecs = pthread_getspecific(ecp->slot_key);
+    if (ecs && ecs->curl) {
+        curl = ecs->curl;
+        ecs->curl = NULL;
+    } else {
+        pthread_mutex_lock(&ecp->m);
+        if (ecp->free_size > 0) {
+            curl = ecp->free_handles[--ecp->free_size];
+        }
+        pthread_mutex_unlock(&ecp->m);
+    }
+
+    if (curl) {
+        // reset keeps live connections and the session cache
+        curl_easy_reset(curl);
+    } else {
+        if (!(curl = curl_easy_init())) {
+            return NULL;
+        }
+        pthread_mutex_lock(&ecp->m);
+        if (ecp->all_size == ecp->all_reserved) {
+            if (!(ecp->all_reserved *= 2)) ecp->all_reserved = 16;
+            ecp->all_handles = realloc(ecp->all_handles, ecp->all_reserved * sizeof(ecp->all_handles[0]));
+        }
+        ecp->all_handles[ecp->all_size++] = curl;
+        pthread_mutex_unlock(&ecp->m);
+    }
+    setup_handle(ecp, curl);
+    return curl;
+}
+
+void
+curl_pool_release(struct EjCurlPool *ecp, CURL *curl)
+{
+    if (!curl) return;
+
+    struct EjCurlSlot *ecs = pthread_getspecific(ecp->slot_key);
+    if (!ecs) {
+        ecs = calloc(1, sizeof(*ecs));
+        ecs->ecp = ecp;
+        pthread_setspecific(ecp->slot_key, ecs);
+    }
+    if (!ecs->curl) {
+        ecs->curl = curl;
+        return;
+    }
+
+    pthread_mutex_lock(&ecp->m);
+    put_free_unlocked(ecp, curl);
+    pthread_mutex_unlock(&ecp->m);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <curl/curl.h>
+
+/*
+ * A pool of reusable CURL easy handles.
+ *
+ * Each thread (FUSE worker threads, the submit thread) keeps one handle
+ * cached in a thread-specific slot, so in the common case acquire/release
+ * is just a TLS access. All handles share the connection cache, the TLS
+ * session cache and the DNS cache, so a connection opened by one thread
+ * may be reused by another without a new TCP/TLS handshake.
+ */
+
+struct EjCurlPool;
+
+struct EjCurlPool *curl_pool_create(void);
+void curl_pool_free(struct EjCurlPool *ecp);
+
+// returns a handle reset to the default state, NULL on error
+CURL *curl_pool_acquire(struct EjCurlPool *ecp);
+// returns the handle to the pool, the handle must not be used afterwards
+void curl_pool_release(struct EjCurlPool *ecp, CURL *curl);
@@ -0,0 +1,198 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dir_listing.h"
+#include "ejfuse.h"
+#include "contests_state.h"
+#include "ejudge.h"
+#include "inode_code.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+struct EjDirListing *
+dir_listing_create(void)
+{
+    struct EjDirListing *edl = calloc(1, sizeof(*edl));
+    return edl;
+}
+
+void
+dir_listing_free(struct EjDirListing *edl)
+{
+    if (edl) {
+        free(edl->data);
+        free(edl);
+    }
+}
+
+// names longer than NAME_MAX cannot be looked up, so they are skipped
+void
+dir_listing_add(struct EjDirListing *edl, const unsigned char *name, unsigned long long inode, unsigned mode)
+{
+    size_t len = strlen(name);
+    if (len > NAME_MAX) return;
+    size_t size = (sizeof(struct EjDirEntry) + len + 1 + 7) & ~(size_t) 7;
+    if (edl->size + size > edl->reserved) {
+        size_t new_reserved = edl->reserved;
+        if (!new_reserved) new_reserved = 1024;
+        while (edl->size + size > new_reserved) new_reserved *= 2;
+        edl->data = realloc(edl->data, new_reserved);
+        edl->reserved = new_reserved;
+    }
+    struct EjDirEntry *ede = (struct EjDirEntry *) (edl->data + edl->size);
+    memset(ede, 0, size);
+    ede->inode = inode;
+    ede->size = size;
+    ede->mode = mode;
+    memcpy(ede->name, name, len);
+    edl->size += size;
+    ++edl->count;
+}
+
+void
+ejfuse_contest_problems_listing(struct EjContestInfo *eci)
+{
+    if (!eci->ok) return;
+
+    int cnts_id = eci->cnts_id;
+    struct EjDirListing *edl = dir_listing_create();
+    dir_listing_add(edl, ".", inode_code_make(INODE_KIND_PROBLEMS, cnts_id, 0, 0), S_IFDIR);
+    dir_listing_add(edl, "..", inode_code_make(INODE_KIND_CONTEST, cnts_id, 0, 0), S_IFDIR);
+    for (int prob_id = 1; prob_id < eci->prob_size; ++prob_id) {
+        struct EjContestProblem *ecp = eci->probs[prob_id];
+        if (ecp) {
+            unsigned char dpath[PATH_MAX];
+            if (ecp->short_name && ecp->long_name) {
+                snprintf(dpath, sizeof(dpath), "%s,%s", ecp->short_name, ecp->long_name);
+            } else if (ecp->short_name) {
+                snprintf(dpath, sizeof(dpath), "%s", ecp->short_name);
+            } else {
+                snprintf(dpath, sizeof(dpath), "%d", prob_id);
+            }
+            dir_listing_add(edl, fix_name(dpath), inode_code_make(INODE_KIND_PROBLEM, cnts_id, prob_id, 0), S_IFDIR);
+        }
+    }
+    eci->probs_listing = edl;
+}
+
+static void
+add_compiler(struct EjDirListing *edl, struct EjContestCompiler *ecl, int cnts_id, int prob_id, int lang_id)
+{
+    unsigned char entry_name[PATH_MAX];
+    if (ecl->short_name && ecl->short_name[0] && ecl->long_name && ecl->long_name[0]) {
+        snprintf(entry_name, sizeof(entry_name), "%s,%s", ecl->short_name, ecl->long_name);
+    } else if (ecl->short_name && ecl->short_name[0]) {
+        snprintf(entry_name, sizeof(entry_name), "%s", ecl->short_name);
+    } else {
+        snprintf(entry_name, sizeof(entry_name), "%d", lang_id);
+    }
+    dir_listing_add(edl, entry_name, inode_code_make(INODE_KIND_SUBMIT_COMP, cnts_id, prob_id, lang_id), S_IFDIR);
+}
+
+/*
+ * compiler names are taken from the contest info current at the time
+ * the problem info is fetched
+ */
+void
+ejfuse_problem_submit_listing(struct EjProblemInfo *epi, struct EjContestState *ecs)
+{
+    if (!epi->ok || !epi->is_submittable) return;
+
+    int cnts_id = ecs->cnts_id;
+    int prob_id = epi->prob_id;
+    struct EjDirListing *edl = dir_listing_create();
+    dir_listing_add(edl, ".", inode_code_make(INODE_KIND_SUBMIT, cnts_id, prob_id, 0), S_IFDIR);
+    dir_listing_add(edl, "..", inode_code_make(INODE_KIND_PROBLEM, cnts_id, prob_id, 0), S_IFDIR);
+
+    if (epi->type != 0) {
+        dir_listing_add(edl, "0", inode_code_make(INODE_KIND_SUBMIT_COMP, cnts_id, prob_id, 0), S_IFDIR);
+        epi->submit_listing = edl;
+        return;
+    }
+
+    struct EjContestInfo *eci = contest_info_read_lock(ecs);
+    if (eci && eci->ok) {
+        if (epi->compilers && epi->compiler_size > 0) {
+            for (int lang_id = 1; lang_id < epi->compiler_size; ++lang_id) {
+                struct EjContestCompiler *ecl = NULL;
+                if (epi->compilers[lang_id] && lang_id < eci->compiler_size && (ecl = eci->compilers[lang_id])) {
+                    add_compiler(edl, ecl, cnts_id, prob_id, lang_id);
+                }
+            }
+        } else if (eci->compiler_size > 0 && eci->compilers) {
+            for (int lang_id = 1; lang_id < eci->compiler_size; ++lang_id){
+                struct EjContestCompiler *ecl = eci->compilers[lang_id];
+                if (ecl) {
+                    add_compiler(edl, ecl, cnts_id, prob_id, lang_id);
+                }
+            }
+        }
+    }
+    contest_info_read_unlock(eci);
+    epi->submit_listing = edl;
+}
+
+void
+ejfuse_problem_runs_listing(struct EjProblemRuns *eprs, struct EjContestState *ecs)
+{
+    if (!eprs->ok) return;
+
+    int cnts_id = ecs->cnts_id;
+    struct EjDirListing *edl = dir_listing_create();
+    dir_listing_add(edl, ".", inode_code_make(INODE_KIND_RUNS, cnts_id, eprs->prob_id, 0), S_IFDIR);
+    dir_listing_add(edl, "..", inode_code_make(INODE_KIND_PROBLEM, cnts_id, eprs->prob_id, 0), S_IFDIR);
+    for (int i = 0; i < eprs->size; ++i) {
+        struct EjProblemRun *epr = &eprs->runs[i];
+        unsigned char entry_name[PATH_MAX];
+        unsigned char status_str[128];
+        unsigned char score_str[128];
+        run_status_str(epr->status, status_str, sizeof(status_str), 0, 0);
+        score_str[0] = 0;
+        if (epr->score >= 0) {
+            snprintf(score_str, sizeof(score_str), ",%d", epr->score);
+        }
+        snprintf(entry_name, sizeof(entry_name), "%d,%s%s", epr->run_id, status_str, score_str);
+        dir_listing_add(edl, entry_name, inode_code_make(INODE_KIND_RUN, cnts_id, epr->run_id, 0), S_IFDIR);
+    }
+    eprs->listing = edl;
+}
+
+void
+ejfuse_run_tests_listing(struct EjRunInfo *eri, struct EjContestState *ecs)
+{
+    if (!eri->ok || !eri->is_test_available) return;
+
+    int cnts_id = ecs->cnts_id;
+    struct EjDirListing *edl = dir_listing_create();
+    dir_listing_add(edl, ".", inode_code_make(INODE_KIND_TESTS, cnts_id, eri->run_id, 0), S_IFDIR);
+    dir_listing_add(edl, "..", inode_code_make(INODE_KIND_RUN, cnts_id, eri->run_id, 0), S_IFDIR);
+    for (int i = 0; i < eri->test_count; ++i) {
+        struct EjRunInfoTestResult *eritr = &eri->tests[i];
+        if (eritr->is_visibility_full) {
+            unsigned char entry_name[64];
+            snprintf(entry_name, sizeof(entry_name), "%d", eritr->num);
+            dir_listing_add(edl, entry_name, inode_code_make(INODE_KIND_TEST, cnts_id, eri->run_id, eritr->num), S_IFDIR);
+        }
+    }
+    eri->tests_listing = edl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+
+/*
+ * Pre-rendered directory listing: entry names, inodes and modes packed
+ * into one contiguous buffer, built once when the source object is
+ * fetched from the server, so readdir is a linear walk over the buffer.
+ */
+
+struct EjDirEntry
+{
+    unsigned long long inode;
+    unsigned short size;        // size of the whole entry, 8-byte aligned
+    unsigned short mode;        // S_IFDIR or S_IFREG
+    unsigned char name[];
+};
+
+struct EjDirListing
+{
+    int count;
+    size_t size;
+    size_t reserved;
+    unsigned char *data;
+};
+
+struct EjDirListing *dir_listing_create(void);
+void dir_listing_free(struct EjDirListing *edl);
+void dir_listing_add(struct EjDirListing *edl, const unsigned char *name, unsigned long long inode, unsigned mode);
+
+static inline const struct EjDirEntry *
+dir_listing_first(const struct EjDirListing *edl)
+{
+    return edl->size > 0 ? (const struct EjDirEntry *) edl->data : NULL;
+}
+
+static inline const struct EjDirEntry *
+dir_listing_next(const struct EjDirListing *edl, const struct EjDirEntry *ede)
+{
+    const unsigned char *next = (const unsigned char *) ede + ede->size;
+    return next < edl->data + edl->size ? (const struct EjDirEntry *) next : NULL;
+}
+
+struct EjContestInfo;
+struct EjContestState;
+struct EjProblemInfo;
+struct EjProblemRuns;
+struct EjRunInfo;
+
+// the listings are built only for successfully fetched objects
+void ejfuse_contest_problems_listing(struct EjContestInfo *eci);
+void ejfuse_problem_submit_listing(struct EjProblemInfo *epi, struct EjContestState *ecs);
+void ejfuse_problem_runs_listing(struct EjProblemRuns *eprs, struct EjContestState *ecs);
+void ejfuse_run_tests_listing(struct EjRunInfo *eri, struct EjContestState *ecs);
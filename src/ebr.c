@@ -0,0 +1,217 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ebr.h"
+#include "settings.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The state word of a thread is (epoch << 1) | active. The global epoch
+ * advances only when every active thread has observed it, so an object
+ * retired at epoch E cannot be seen by a reader once the epoch is E + 2.
+ */
+
+enum
+{
+    // bounds the work of a writer after a long read section ends
+    EBR_COLLECT_BATCH = 64,
+};
+
+// each record takes a cache line, as its owner writes it on every read section
+struct EjEbrThread
+{
+    _Alignas(EJFUSE_CACHE_LINE_SIZE) _Atomic unsigned long state;
+    struct EjEbrThread *next;
+    _Atomic _Bool in_use;
+    int nesting;                        // accessed by the owner only
+};
+
+struct EjEbrRetired
+{
+    struct EjEbrRetired *next;
+    unsigned long epoch;
+    void *obj;
+    void (*free_func)(void *);
+};
+
+static _Atomic unsigned long ebr_epoch;
+// thread records are never freed, the records of exited threads are reused
+static struct EjEbrThread *_Atomic ebr_threads;
+
+static pthread_mutex_t ebr_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct EjEbrRetired *ebr_limbo_first;    // oldest first
+static struct EjEbrRetired *ebr_limbo_last;
+static _Atomic int ebr_limbo_count;
+
+static pthread_once_t ebr_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ebr_key;
+static __thread struct EjEbrThread *ebr_self;
+
+static void
+ebr_thread_exit(void *arg)
+{
+    struct EjEbrThread *et = arg;
+    et->nesting = 0;
+    atomic_store_explicit(&et->state, 0, memory_order_release);
+    atomic_store_explicit(&et->in_use, 0, memory_order_release);
+}
+
+static void
+ebr_init_func(void)
+{
+    pthread_key_create(&ebr_key, ebr_thread_exit);
+}
+
+static struct EjEbrThread *
+ebr_thread_register(void)
+{
+    pthread_once(&ebr_once, ebr_init_func);
+
+    struct EjEbrThread *et = atomic_load_explicit(&ebr_threads, memory_order_acquire);
+    for (; et; et = et->next) {
+        _Bool expected = 0;
+        if (atomic_compare_exchange_strong_explicit(&et->in_use, &expected, 1, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (!et) {
+        et = aligned_alloc(_Alignof(struct EjEbrThread), sizeof(*et));
+        memset(et, 0, sizeof(*et));
+        et->in_use = 1;
+        et->next = atomic_load_explicit(&ebr_threads, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&ebr_threads, &et->next, et, memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    pthread_setspecific(ebr_key, et);
+    ebr_self = et;
+    return et;
+}
+
+void
+ebr_enter(void)
+{
+    struct EjEbrThread *et = ebr_self;
+    if (!et) et = ebr_thread_register();
+    if (et->nesting++ > 0) return;
+    unsigned long epoch = atomic_load_explicit(&ebr_epoch, memory_order_relaxed);
+    atomic_store_explicit(&et->state, (epoch << 1) | 1, memory_order_relaxed);
+    // the announcement must be visible before the slots are read
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void
+ebr_exit(void)
+{
+    struct EjEbrThread *et = ebr_self;
+    if (--et->nesting > 0) return;
+    atomic_store_explicit(&et->state, 0, memory_order_release);
+}
+
+void *
+ebr_slot_acquire(void *slot)
+{
+    ebr_enter();
+    void *obj = atomic_load_explicit((void *_Atomic *) slot, memory_order_acquire);
+    if (!obj) ebr_exit();
+    return obj;
+}
+
+void
+ebr_slot_release(const void *obj)
+{
+    if (obj) ebr_exit();
+}
+
+void *
+ebr_slot_exchange(void *slot, void *obj)
+{
+    return atomic_exchange_explicit((void *_Atomic *) slot, obj, memory_order_seq_cst);
+}
+
+// returns the global epoch after an attempt to advance it
+static unsigned long
+ebr_try_advance(void)
+{
+    unsigned long epoch = atomic_load_explicit(&ebr_epoch, memory_order_seq_cst);
+    for (struct EjEbrThread *et = atomic_load_explicit(&ebr_threads, memory_order_acquire); et; et = et->next) {
+        unsigned long state = atomic_load_explicit(&et->state, memory_order_seq_cst);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+    if (atomic_compare_exchange_strong_explicit(&ebr_epoch, &epoch, epoch + 1, memory_order_seq_cst, memory_order_seq_cst)) {
+        ++epoch;
+    }
+    return epoch;
+}
+
+void
+ebr_collect(void)
+{
+    if (!atomic_load_explicit(&ebr_limbo_count, memory_order_relaxed)) return;
+
+    unsigned long epoch = ebr_try_advance();
+    struct EjEbrRetired *list = NULL, **pp = &list;
+    int count = 0;
+    pthread_mutex_lock(&ebr_mutex);
+    while (ebr_limbo_first && ebr_limbo_first->epoch + 2 <= epoch && count < EBR_COLLECT_BATCH) {
+        *pp = ebr_limbo_first;
+        pp = &ebr_limbo_first->next;
+        ebr_limbo_first = ebr_limbo_first->next;
+        ++count;
+    }
+    *pp = NULL;
+    if (!ebr_limbo_first) ebr_limbo_last = NULL;
+    atomic_fetch_sub_explicit(&ebr_limbo_count, count, memory_order_relaxed);
+    pthread_mutex_unlock(&ebr_mutex);
+
+    while (list) {
+        struct EjEbrRetired *er = list;
+        list = er->next;
+        er->free_func(er->obj);
+        free(er);
+    }
+}
+
+void
+ebr_retire(void *obj, void (*free_func)(void *))
+{
+    if (obj) {
+        struct EjEbrRetired *er = malloc(sizeof(*er));
+        er->obj = obj;
+        er->free_func = free_func;
+        pthread_mutex_lock(&ebr_mutex);
+        // read under the mutex, so the limbo list is ordered by epoch
+        er->epoch = atomic_load_explicit(&ebr_epoch, memory_order_seq_cst);
+        er->next = NULL;
+        if (ebr_limbo_last) {
+            ebr_limbo_last->next = er;
+        } else {
+            ebr_limbo_first = er;
+        }
+        ebr_limbo_last = er;
+        atomic_fetch_add_explicit(&ebr_limbo_count, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&ebr_mutex);
+    }
+    ebr_collect();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Epoch-based reclamation of the objects published through atomic
+ * pointer slots. Readers announce the global epoch they run in, writers
+ * replace the object in the slot and retire the old one to a limbo list,
+ * it is freed two epoch advances later, when no reader can hold it.
+ * Writers never wait for readers. Read sections nest and must begin and
+ * end in the same thread.
+ *
+ * There is no shared reader counter: a reader writes only the record of
+ * its own thread (the nesting depth and the announced epoch), and the
+ * records are scanned by a writer only when it reclaims, so concurrent
+ * read sections do not contend with each other.
+ */
+
+void ebr_enter(void);
+void ebr_exit(void);
+
+/*
+ * Readers of a slot. 'slot' is the address of an (atomic) object
+ * pointer. The read section is left at once if the slot is empty,
+ * so the NULL result need not be released.
+ */
+void *ebr_slot_acquire(void *slot);
+void ebr_slot_release(const void *obj);
+
+/* writers are serialized by the caller, returns the previous object */
+void *ebr_slot_exchange(void *slot, void *obj);
+
+/* defers free_func(obj) until the current readers are gone, obj may be NULL */
+void ebr_retire(void *obj, void (*free_func)(void *));
+
+/* frees the retired objects which became unreachable */
+void ebr_collect(void);
@@ -24,7 +24,6 @@
 #include <string.h>
 #include <stdatomic.h>
 #include <pthread.h>
-#include <sched.h>
 #include <errno.h>
 #include <openssl/sha.h>
 #include <unistd.h>
@@ -33,15 +32,22 @@
 #include <termios.h>
 
 #include "cJSON.h"
+#include "inode_code.h"
 #include "inode_hash.h"
+#include "path_cache.h"
+#include "memfd_blob.h"
 #include "contests_state.h"
+#include "dir_listing.h"
+#include "ebr.h"
 #include "ejfuse.h"
+#include "settings.h"
 #include "ops_generic.h"
 #include "ops_root.h"
 #include "ops_cnts.h"
 #include "ops_cnts_info.h"
 #include "ops_cnts_log.h"
 #include "ops_fuse.h"
+#include "ops_lowlevel.h"
 #include "ops_cnts_probs.h"
 #include "ops_cnts_prob_dir.h"
 #include "ops_cnts_prob_files.h"
@@ -51,6 +57,10 @@
 #include "ejudge_client.h"
 #include "ejfuse_file.h"
 #include "submit_thread.h"
+#include "curl_pool.h"
+#include "http_engine.h"
+#include "single_flight.h"
+#include "refresh_thread.h"
 #include "ops_cnts_prob_runs.h"
 #include "ops_cnts_prob_runs_run.h"
 #include "ops_cnts_prob_runs_run_files.h"
@@ -115,98 +125,69 @@ request_free(struct EjFuseRequest *rq, int retval)
     return retval;
 }
 
+static void
+top_session_retire(void *ptr)
+{
+    top_session_free(ptr);
+}
+
+static void
+contest_list_retire(void *ptr)
+{
+    contest_list_free(ptr);
+}
+
 struct EjTopSession *
 top_session_read_lock(struct EjFuseState *efs)
 {
-    struct EjTopSession *top_session = NULL;
-
-    atomic_fetch_add_explicit(&efs->top_session_guard, 1, memory_order_acquire);
-    top_session = atomic_load_explicit(&efs->top_session, memory_order_relaxed);
-    atomic_fetch_add_explicit(&top_session->reader_count, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&efs->top_session_guard, 1, memory_order_release);
-    return top_session;
+    return ebr_slot_acquire(&efs->top_session.obj);
 }
 
 void
 top_session_read_unlock(struct EjTopSession *tls)
 {
-    if (tls) {
-        atomic_fetch_sub_explicit(&tls->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(tls);
 }
 
 int
 top_session_try_write_lock(struct EjFuseState *efs)
 {
-    return atomic_exchange_explicit(&efs->top_session_update, 1, memory_order_relaxed);
+    return atomic_exchange_explicit(&efs->top_session.update, 1, memory_order_acquire);
 }
 
 void
 top_session_set(struct EjFuseState *efs, struct EjTopSession *top_session)
 {
-    struct EjTopSession *old_session = atomic_exchange_explicit(&efs->top_session, top_session, memory_order_acquire);
-    int expected = 0;
-    // spinlock
-    while (!atomic_compare_exchange_weak_explicit(&efs->top_session_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&efs->top_session_update, 0, memory_order_release);
-
-    if (old_session) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old_session->reader_count, &expected, 0, memory_order_acquire, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        top_session_free(old_session);
-    }
+    struct EjTopSession *old_session = ebr_slot_exchange(&efs->top_session.obj, top_session);
+    single_flight_done(&efs->top_session.update);
+    ebr_retire(old_session, top_session_retire);
 }
 
 struct EjContestList *
 contest_list_read_lock(struct EjFuseState *efs)
 {
-    struct EjContestList *contests = NULL;
-
-    atomic_fetch_add_explicit(&efs->contests_guard, 1, memory_order_acquire);
-    contests = atomic_load_explicit(&efs->contests, memory_order_relaxed);
-    atomic_fetch_add_explicit(&contests->reader_count, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&efs->contests_guard, 1, memory_order_release);
-    return contests;
+    return ebr_slot_acquire(&efs->contests.obj);
 }
 
 void
 contest_list_read_unlock(struct EjContestList *contests)
 {
-    if (contests) {
-        atomic_fetch_sub_explicit(&contests->reader_count, 1, memory_order_relaxed);
-    }
+    ebr_slot_release(contests);
 }
 
 int
 contest_list_try_write_lock(struct EjFuseState *efs)
 {
-    return atomic_exchange_explicit(&efs->contests_update, 1, memory_order_relaxed);
+    return atomic_exchange_explicit(&efs->contests.update, 1, memory_order_acquire);
 }
 
 void
 contest_list_set(struct EjFuseState *efs, struct EjContestList *contests)
 {
-    struct EjContestList *old_contests = atomic_exchange_explicit(&efs->contests, contests, memory_order_acquire);
-    int expected = 0;
-    while (!atomic_compare_exchange_weak_explicit(&efs->contests_guard, &expected, 0, memory_order_release, memory_order_acquire)) {
-        expected = 0;
-    }
-    atomic_store_explicit(&efs->contests_update, 0, memory_order_release);
-
-    // spinlock
-    if (old_contests) {
-        expected = 0;
-        while (!atomic_compare_exchange_weak_explicit(&old_contests->reader_count, &expected, 0, memory_order_acquire, memory_order_acquire)) {
-            sched_yield();
-            expected = 0;
-        }
-        contest_list_free(old_contests);
-    }
+    struct EjContestList *old_contests = ebr_slot_exchange(&efs->contests.obj, contests);
+    atomic_fetch_add_explicit(&efs->contests_gen, 1, memory_order_release);
+    single_flight_done(&efs->contests.update);
+    ebr_retire(old_contests, contest_list_retire);
 }
 
 struct EjContestListItem *
@@ -244,31 +225,107 @@ contests_is_valid(struct EjFuseState *efs, int cnts_id)
     return cnts != NULL;
 }
 
+enum { UPDATE_NONE, UPDATE_SYNC, UPDATE_ASYNC };
+
+/* record the object access for the proactive refresh */
+static inline void
+access_touch(_Atomic long long *p_access_us, long long current_time_us)
+{
+    // do not dirty the shared cache line on every access
+    if (current_time_us - atomic_load_explicit(p_access_us, memory_order_relaxed) >= 1000000) {
+        atomic_store_explicit(p_access_us, current_time_us, memory_order_relaxed);
+    }
+}
+
+/*
+ * Sessions are renewed in background ahead of expiry, the renewal times
+ * are spread randomly over EJFUSE_SESSION_JITTER.
+ */
+static long long
+session_renew_time(long long current_time_us, long long expire_us, long long ahead_us)
+{
+    long long renew_us = expire_us - ahead_us - random() % EJFUSE_SESSION_JITTER;
+    // short-lived sessions are renewed in the middle of their lifetime
+    if (renew_us < current_time_us + (expire_us - current_time_us) / 2) {
+        renew_us = current_time_us + (expire_us - current_time_us) / 2;
+    }
+    return renew_us;
+}
+
+// the next attempt after a failed renewal of a still valid session
+static long long
+session_retry_time(long long current_time_us, long long expire_us)
+{
+    long long retry_us = current_time_us + EJFUSE_RETRY_TIME;
+    if (retry_us > expire_us - EJFUSE_SESSION_EXPIRE_MARGIN) {
+        retry_us = expire_us - EJFUSE_SESSION_EXPIRE_MARGIN;
+    }
+    return retry_us;
+}
+
+void
+top_session_refresh(struct EjFuseState *efs, long long current_time_us)
+{
+    struct EjTopSession *top_session = calloc(1, sizeof(*top_session));
+    ejudge_client_get_top_session_request(efs, current_time_us, top_session);
+
+    if (!top_session->ok) {
+        long long expire_us = 0;
+        struct EjTopSession *old_session = top_session_read_lock(efs);
+        if (old_session && old_session->ok) expire_us = old_session->expire_us;
+        top_session_read_unlock(old_session);
+        if (expire_us > current_time_us + EJFUSE_SESSION_EXPIRE_MARGIN) {
+            // keep using the current session until it expires
+            top_session_free(top_session);
+            single_flight_done(&efs->top_session.update);
+            refresh_thread_schedule(efs->refresh_thread,
+                                    refresh_item_create(REFRESH_TOP_SESSION, NULL, NULL, NULL, NULL, 0, 0),
+                                    expire_us, session_retry_time(current_time_us, expire_us));
+            return;
+        }
+    }
+
+    long long expire_us = 0;
+    if (top_session->ok) expire_us = top_session->expire_us;
+    top_session_set(efs, top_session);
+    if (expire_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread,
+                                refresh_item_create(REFRESH_TOP_SESSION, NULL, NULL, NULL, NULL, 0, 0),
+                                expire_us, session_renew_time(current_time_us, expire_us, EJFUSE_TOP_SESSION_RENEW_AHEAD));
+    }
+}
+
 void
 top_session_maybe_update(struct EjFuseState *efs, long long current_time_us)
 {
-    int update_needed = 0;
+    int update_needed = UPDATE_NONE;
     struct EjTopSession *top_session = top_session_read_lock(efs);
     if (top_session->ok) {
-        if (top_session->expire_us > 0 && current_time_us >= top_session->expire_us - 100000000) { // 100s
-            update_needed = 1;
-        }
-        if (top_session->recheck_time_us > 0 && current_time_us >= top_session->recheck_time_us) {
-            update_needed = 1;
+        if (top_session->expire_us > 0 && current_time_us >= top_session->expire_us - EJFUSE_SESSION_EXPIRE_MARGIN) {
+            update_needed = UPDATE_SYNC;
+        } else if (top_session->expire_us > 0 && current_time_us >= top_session->expire_us - 100000000) { // 100s
+            // the background renewal is late, but the session is still usable
+            update_needed = UPDATE_ASYNC;
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (top_session->recheck_time_us > 0 && current_time_us < top_session->recheck_time_us) {
-            update_needed = 0;
+            // fail fast while the login is failing
+            update_needed = UPDATE_NONE;
         }
     }
     top_session_read_unlock(top_session);
+    if (!update_needed) return;
 
-    if (update_needed) {
-        top_session = calloc(1, sizeof(*top_session));
-        ejudge_client_get_top_session_request(efs, current_time_us, top_session);
-        top_session_set(efs, top_session);
+    if (top_session_try_write_lock(efs)) {
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&efs->top_session.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_TOP_SESSION, NULL, NULL, NULL, NULL, 0, 0));
+        return;
     }
+    top_session_refresh(efs, current_time_us);
 }
 
 int
@@ -350,22 +407,47 @@ contest_log_format(
 }
 
 void
-ejudge_client_enter_contest(
+contest_session_refresh(
         struct EjFuseState *efs,
         struct EjContestState *ecs,
         long long current_time_us)
 {
     struct EjSessionValue esv = {};
 
-    int already = contest_session_try_write_lock(ecs);
-    if (already) return;
-
-    if (!top_session_copy_session(efs, &esv)) return;
+    top_session_maybe_update(efs, current_time_us);
+    if (!top_session_copy_session(efs, &esv)) {
+        single_flight_done(&ecs->session.update);
+        return;
+    }
 
     struct EjContestSession *ecc = calloc(1, sizeof(*ecc));
     ecc->cnts_id = ecs->cnts_id;
     ejudge_client_enter_contest_request(efs, ecs, &esv, current_time_us, ecc);
+
+    if (!ecc->ok) {
+        long long expire_us = 0;
+        struct EjContestSession *old_ecc = contest_session_read_lock(ecs);
+        if (old_ecc && old_ecc->ok) expire_us = old_ecc->expire_us;
+        contest_session_read_unlock(old_ecc);
+        if (expire_us > current_time_us + EJFUSE_SESSION_EXPIRE_MARGIN) {
+            // keep using the current session until it expires
+            contest_session_free(ecc);
+            single_flight_done(&ecs->session.update);
+            refresh_thread_schedule(efs->refresh_thread,
+                                    refresh_item_create(REFRESH_CONTEST_SESSION, ecs, NULL, NULL, NULL, 0, 0),
+                                    expire_us, session_retry_time(current_time_us, expire_us));
+            return;
+        }
+    }
+
+    long long expire_us = 0;
+    if (ecc->ok) expire_us = ecc->expire_us;
     contest_session_set(ecs, ecc);
+    if (expire_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread,
+                                refresh_item_create(REFRESH_CONTEST_SESSION, ecs, NULL, NULL, NULL, 0, 0),
+                                expire_us, session_renew_time(current_time_us, expire_us, EJFUSE_CONTEST_SESSION_RENEW_AHEAD));
+    }
 }
 
 void
@@ -374,44 +456,123 @@ contest_session_maybe_update(
         struct EjContestState *ecs,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&ecs->session.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjContestSession *ecc = contest_session_read_lock(ecs);
     if (ecc->ok) {
-        if (ecc->expire_us > 0 && current_time_us >= ecc->expire_us - 10000000) {
-            update_needed = 1;
-        }
-        if (ecc->recheck_time_us > 0 && current_time_us >= ecc->recheck_time_us) {
-            update_needed = 1;
+        if (ecc->expire_us > 0 && current_time_us >= ecc->expire_us - EJFUSE_SESSION_EXPIRE_MARGIN) {
+            update_needed = UPDATE_SYNC;
+        } else if (ecc->expire_us > 0 && current_time_us >= ecc->expire_us - 10000000) {
+            // the background renewal is late or the contest was idle
+            update_needed = UPDATE_ASYNC;
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (ecc->recheck_time_us > 0 && current_time_us < ecc->recheck_time_us) {
-            update_needed = 0;
+            // fail fast while entering the contest is failing
+            update_needed = UPDATE_NONE;
         }
     }
     contest_session_read_unlock(ecc);
     if (!update_needed) return;
 
-    top_session_maybe_update(efs, current_time_us);
-    ejudge_client_enter_contest(efs, ecs, current_time_us);
+    if (contest_session_try_write_lock(ecs)) {
+        // the session is being entered by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ecs->session.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_CONTEST_SESSION, ecs, NULL, NULL, NULL, 0, 0));
+        return;
+    }
+    contest_session_refresh(efs, ecs, current_time_us);
+}
+
+/*
+ * An expired, but valid object is served as is and refreshed in background,
+ * unless it is expired for more than stale_limit_us.
+ */
+static int
+expired_update_mode(const struct EjFuseState *efs, long long recheck_time_us, long long current_time_us)
+{
+    if (efs->stale_limit_us > 0 && current_time_us < recheck_time_us + efs->stale_limit_us) {
+        return UPDATE_ASYNC;
+    }
+    return UPDATE_SYNC;
+}
+
+/*
+ * A failed fetch does not replace a valid object while it may be served
+ * stale, the fetch is retried instead. old_recheck_time_us is the recheck
+ * time of the current object, -1 if it is not valid. Returns 1 if the new
+ * object must be dropped, ri is consumed in any case.
+ */
+static int
+keep_stale_object(
+        struct EjFuseState *efs,
+        _Atomic _Bool *update,
+        long long old_recheck_time_us,
+        long long current_time_us,
+        struct EjRefreshItem *ri)
+{
+    long long limit_us = old_recheck_time_us;
+    if (efs->stale_limit_us > 0) limit_us += efs->stale_limit_us;
+    if (old_recheck_time_us < 0 || (old_recheck_time_us > 0 && current_time_us >= limit_us)) {
+        refresh_item_free(ri);
+        return 0;
+    }
+
+    single_flight_done(update);
+    if (old_recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        long long retry_us = current_time_us + EJFUSE_RETRY_TIME;
+        if (retry_us > limit_us) retry_us = limit_us;
+        refresh_thread_schedule(efs->refresh_thread, ri, old_recheck_time_us, retry_us);
+    } else {
+        refresh_item_free(ri);
+    }
+    return 1;
 }
 
 void
-ejudge_client_contest_info(
+contest_info_refresh(
         struct EjFuseState *efs,
         struct EjContestState *ecs,
         long long current_time_us)
 {
-    int already = contest_info_try_write_lock(ecs);
-    if (already) return;
-
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&ecs->info.update);
+        return;
+    }
 
     struct EjContestInfo *eci = contest_info_create(ecs->cnts_id);
     ejudge_client_contest_info_request(efs, ecs, &esv, current_time_us, eci);
+    if (!eci->ok) {
+        struct EjContestInfo *old = contest_info_read_lock(ecs);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        contest_info_read_unlock(old);
+        if (keep_stale_object(efs, &ecs->info.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_CONTEST_INFO, ecs, NULL, NULL, NULL, 0, 0))) {
+            contest_info_free(eci);
+            return;
+        }
+    }
     ejfuse_contest_info_text(eci);
+    ejfuse_contest_problems_listing(eci);
+    long long recheck_time_us = 0;
+    if (eci->ok) recheck_time_us = eci->recheck_time_us;
+    // the cached paths stay valid unless the problem or compiler names changed
+    struct EjContestInfo *old = contest_info_read_lock(ecs);
+    int paths_changed = eci->ok && !contest_info_same_names(old, eci);
+    contest_info_read_unlock(old);
     contest_info_set(ecs, eci);
+    if (paths_changed) {
+        atomic_fetch_add_explicit(&ecs->path_gen, 1, memory_order_release);
+    }
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_CONTEST_INFO, ecs, NULL, NULL, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -420,23 +581,69 @@ contest_info_maybe_update(
         struct EjContestState *ecs,
         long long current_time_us)
 {
+    access_touch(&ecs->info.access_us, current_time_us);
     // contest session must be updated before
-    int update_needed = 0;
+    int update_needed = UPDATE_NONE;
     struct EjContestInfo *eci = contest_info_read_lock(ecs);
     if (eci->ok) {
         if (eci->recheck_time_us > 0 && current_time_us >= eci->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, eci->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
-        if (eci->recheck_time_us > 0 && current_time_us < eci->recheck_time_us){
-            update_needed = 0;
+        update_needed = UPDATE_SYNC;
+        if (eci->recheck_time_us > 0 && current_time_us < eci->recheck_time_us) {
+            update_needed = UPDATE_NONE;
         }
     }
     contest_info_read_unlock(eci);
     if (!update_needed) return;
 
-    ejudge_client_contest_info(efs, ecs, current_time_us);
+    if (contest_info_try_write_lock(ecs)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ecs->info.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_CONTEST_INFO, ecs, NULL, NULL, NULL, 0, 0));
+        return;
+    }
+    contest_info_refresh(efs, ecs, current_time_us);
+}
+
+void
+problem_info_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us)
+{
+    struct EjSessionValue esv;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&eps->info.update);
+        return;
+    }
+
+    struct EjProblemInfo *epi = problem_info_create(eps->prob_id);
+    ejudge_client_problem_info_request(efs, ecs, &esv, eps->prob_id, current_time_us, epi);
+    if (!epi->ok) {
+        struct EjProblemInfo *old = problem_info_read_lock(eps);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        problem_info_read_unlock(old);
+        if (keep_stale_object(efs, &eps->info.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_PROBLEM_INFO, ecs, eps, NULL, NULL, 0, 0))) {
+            problem_info_free(epi);
+            return;
+        }
+    }
+    ejfuse_problem_info_text(epi, ecs);
+    ejfuse_problem_submit_listing(epi, ecs);
+    long long recheck_time_us = 0;
+    if (epi->ok) recheck_time_us = epi->recheck_time_us;
+    problem_info_set(eps, epi);
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_INFO, ecs, eps, NULL, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -446,31 +653,69 @@ problem_info_maybe_update(
         struct EjProblemState *eps,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&eps->info.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjProblemInfo *epi = problem_info_read_lock(eps);
     if (epi && epi->ok) {
         if (epi->recheck_time_us > 0 && current_time_us >= epi->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, epi->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (epi && epi->recheck_time_us > 0 && current_time_us < epi->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     problem_info_read_unlock(epi);
     if (!update_needed) return;
 
-    int already = problem_info_try_write_lock(eps);
-    if (already) return;
+    if (problem_info_try_write_lock(eps)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&eps->info.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_INFO, ecs, eps, NULL, NULL, 0, 0));
+        return;
+    }
+    problem_info_refresh(efs, ecs, eps, current_time_us);
+}
 
+void
+problem_statement_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&eps->stmt.update);
+        return;
+    }
 
-    epi = problem_info_create(eps->prob_id);
-    ejudge_client_problem_info_request(efs, ecs, &esv, eps->prob_id, current_time_us, epi);
-    ejfuse_problem_info_text(epi, ecs);
-    problem_info_set(eps, epi);
+    struct EjProblemStatement *eph = problem_statement_create(eps->prob_id);
+    ejudge_client_problem_statement_request(efs, ecs, &esv, eps->prob_id, current_time_us, eph);
+    if (!eph->ok) {
+        struct EjProblemStatement *old = problem_statement_read_lock(eps);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        problem_statement_read_unlock(old);
+        if (keep_stale_object(efs, &eps->stmt.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_PROBLEM_STATEMENT, ecs, eps, NULL, NULL, 0, 0))) {
+            problem_statement_free(eph);
+            return;
+        }
+    }
+    long long recheck_time_us = 0;
+    if (eph->ok) {
+        recheck_time_us = eph->recheck_time_us;
+        eph->stmt_fd = memfd_blob_convert(&eph->stmt_text, eph->stmt_size);
+    }
+    problem_statement_set(eps, eph);
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_STATEMENT, ecs, eps, NULL, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -480,6 +725,8 @@ problem_statement_maybe_update(
         struct EjProblemState *eps,
         long long current_time_us)
 {
+    access_touch(&eps->stmt.access_us, current_time_us);
+
     struct EjProblemInfo *epi = problem_info_read_lock(eps);
     if (!epi || !epi->ok || !epi->is_viewable || !epi->is_statement_avaiable) {
         problem_info_read_unlock(epi);
@@ -487,30 +734,74 @@ problem_statement_maybe_update(
     }
     problem_info_read_unlock(epi);
 
-    int update_needed = 0;
+    int update_needed = UPDATE_NONE;
     struct EjProblemStatement *eph = problem_statement_read_lock(eps);
     if (eph && eph->ok) {
         if (eph->recheck_time_us > 0 && current_time_us >= eph->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, eph->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (eph && eph->recheck_time_us > 0 && current_time_us < eph->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     problem_statement_read_unlock(eph);
     if (!update_needed) return;
 
-    int already = problem_statement_try_write_lock(eps);
-    if (already) return;
+    if (problem_statement_try_write_lock(eps)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&eps->stmt.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_STATEMENT, ecs, eps, NULL, NULL, 0, 0));
+        return;
+    }
+    problem_statement_refresh(efs, ecs, eps, current_time_us);
+}
 
+void
+problem_runs_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&eps->runs.update);
+        return;
+    }
 
-    eph = problem_statement_create(eps->prob_id);
-    ejudge_client_problem_statement_request(efs, ecs, &esv, eps->prob_id, current_time_us, eph);
-    problem_statement_set(eps, eph);
+    struct EjProblemRuns *eprs = problem_runs_create(eps->prob_id);
+    ejudge_client_problem_runs_request(efs, ecs, &esv, eps->prob_id, current_time_us, eprs);
+    if (!eprs->ok) {
+        struct EjProblemRuns *old = problem_runs_read_lock(eps);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        problem_runs_read_unlock(old);
+        if (keep_stale_object(efs, &eps->runs.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_PROBLEM_RUNS, ecs, eps, NULL, NULL, 0, 0))) {
+            problem_runs_free(eprs);
+            return;
+        }
+    }
+    ejfuse_problem_runs_listing(eprs, ecs);
+    long long recheck_time_us = 0;
+    if (eprs->ok) recheck_time_us = eprs->recheck_time_us;
+    struct EjLowInvalidation *eli = ejf_lowlevel_runs_changes(efs, eps, eprs);
+    struct EjProblemRuns *old = problem_runs_read_lock(eps);
+    int paths_changed = eprs->ok && !problem_runs_same_runs(old, eprs);
+    problem_runs_read_unlock(old);
+    problem_runs_set(eps, eprs);
+    ejf_lowlevel_invalidate(efs, eli);
+    if (paths_changed) {
+        atomic_fetch_add_explicit(&ecs->path_gen, 1, memory_order_release);
+    }
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_RUNS, ecs, eps, NULL, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -520,30 +811,76 @@ problem_runs_maybe_update(
         struct EjProblemState *eps,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&eps->runs.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjProblemRuns *eprs = problem_runs_read_lock(eps);
     if (eprs && eprs->ok) {
         if (eprs->recheck_time_us > 0 && current_time_us >= eprs->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, eprs->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (eprs && eprs->recheck_time_us > 0 && current_time_us < eprs->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     problem_runs_read_unlock(eprs);
     if (!update_needed) return;
 
-    int already = problem_runs_try_write_lock(eps);
-    if (already) return;
+    if (problem_runs_try_write_lock(eps)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&eps->runs.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_PROBLEM_RUNS, ecs, eps, NULL, NULL, 0, 0));
+        return;
+    }
+    problem_runs_refresh(efs, ecs, eps, current_time_us);
+}
 
+void
+run_info_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&ers->info.update);
+        return;
+    }
 
-    eprs = problem_runs_create(eps->prob_id);
-    ejudge_client_problem_runs_request(efs, ecs, &esv, eps->prob_id, current_time_us, eprs);
-    problem_runs_set(eps, eprs);
+    struct EjRunInfo *eri = run_info_create(ers->run_id);
+    ejudge_client_run_info_request(efs, ecs, &esv, ers->run_id, current_time_us, eri);
+    if (!eri->ok) {
+        struct EjRunInfo *old = run_info_read_lock(ers);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        run_info_read_unlock(old);
+        if (keep_stale_object(efs, &ers->info.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_RUN_INFO, ecs, NULL, ers, NULL, 0, 0))) {
+            run_info_free(eri);
+            return;
+        }
+    }
+    ejfuse_run_info_text(eri, ecs);
+    ejfuse_run_tests_listing(eri, ecs);
+    long long recheck_time_us = 0;
+    if (eri->ok) recheck_time_us = eri->recheck_time_us;
+    struct EjLowInvalidation *eli = ejf_lowlevel_run_info_changes(efs, ecs, ers, eri);
+    struct EjRunInfo *old = run_info_read_lock(ers);
+    int paths_changed = eri->ok && !run_info_same_tests(old, eri);
+    run_info_read_unlock(old);
+    run_info_set(ers, eri);
+    ejf_lowlevel_invalidate(efs, eli);
+    if (paths_changed) {
+        atomic_fetch_add_explicit(&ecs->path_gen, 1, memory_order_release);
+    }
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_RUN_INFO, ecs, NULL, ers, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -553,30 +890,69 @@ run_info_maybe_update(
         struct EjRunState *ers,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&ers->info.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjRunInfo *eri = run_info_read_lock(ers);
     if (eri && eri->ok) {
         if (eri->recheck_time_us > 0 && current_time_us >= eri->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, eri->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (eri && eri->recheck_time_us > 0 && current_time_us < eri->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     run_info_read_unlock(eri);
     if (!update_needed) return;
 
-    if (run_info_try_write_lock(ers)) return;
+    if (run_info_try_write_lock(ers)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ers->info.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_RUN_INFO, ecs, NULL, ers, NULL, 0, 0));
+        return;
+    }
+    run_info_refresh(efs, ecs, ers, current_time_us);
+}
 
+void
+run_source_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&ers->src.update);
+        return;
+    }
 
-    eri = run_info_create(ers->run_id);
-    ejudge_client_run_info_request(efs, ecs, &esv, ers->run_id, current_time_us, eri);
-    ejfuse_run_info_text(eri, ecs);
-    run_info_set(ers, eri);
+    struct EjRunSource *ert = run_source_create(ers->run_id);
+    ejudge_client_run_source_request(efs, ecs, &esv, ers->run_id, current_time_us, ert);
+    if (!ert->ok) {
+        struct EjRunSource *old = run_source_read_lock(ers);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        run_source_read_unlock(old);
+        if (keep_stale_object(efs, &ers->src.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_RUN_SOURCE, ecs, NULL, ers, NULL, 0, 0))) {
+            run_source_free(ert);
+            return;
+        }
+    }
+    long long recheck_time_us = 0;
+    if (ert->ok) {
+        recheck_time_us = ert->recheck_time_us;
+        ert->data_fd = memfd_blob_convert(&ert->data, ert->size);
+    }
+    run_source_set(ers, ert);
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_RUN_SOURCE, ecs, NULL, ers, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -586,29 +962,67 @@ run_source_maybe_update(
         struct EjRunState *ers,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&ers->src.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjRunSource *ert = run_source_read_lock(ers);
     if (ert && ert->ok) {
         if (ert->recheck_time_us > 0 && current_time_us >= ert->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, ert->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (ert && ert->recheck_time_us > 0 && current_time_us < ert->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     run_source_read_unlock(ert);
     if (!update_needed) return;
 
-    if (run_source_try_write_lock(ers)) return;
+    if (run_source_try_write_lock(ers)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ers->src.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_RUN_SOURCE, ecs, NULL, ers, NULL, 0, 0));
+        return;
+    }
+    run_source_refresh(efs, ecs, ers, current_time_us);
+}
 
+void
+run_messages_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&ers->msg.update);
+        return;
+    }
 
-    ert = run_source_create(ers->run_id);
-    ejudge_client_run_source_request(efs, ecs, &esv, ers->run_id, current_time_us, ert);
-    run_source_set(ers, ert);
+    struct EjRunMessages *erms = run_messages_create(ers->run_id);
+    ejudge_client_run_messages_request(efs, ecs, &esv, ers->run_id, current_time_us, erms);
+    if (!erms->ok) {
+        struct EjRunMessages *old = run_messages_read_lock(ers);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        run_messages_read_unlock(old);
+        if (keep_stale_object(efs, &ers->msg.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_RUN_MESSAGES, ecs, NULL, ers, NULL, 0, 0))) {
+            run_messages_free(erms);
+            return;
+        }
+    }
+    ejfuse_run_messages_text(erms);
+    long long recheck_time_us = 0;
+    if (erms->ok) recheck_time_us = erms->recheck_time_us;
+    run_messages_set(ers, erms);
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_RUN_MESSAGES, ecs, NULL, ers, NULL, 0, 0),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -618,30 +1032,71 @@ run_messages_maybe_update(
         struct EjRunState *ers,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&ers->msg.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjRunMessages *erms = run_messages_read_lock(ers);
     if (erms && erms->ok) {
         if (erms->recheck_time_us > 0 && current_time_us >= erms->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, erms->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (erms && erms->recheck_time_us > 0 && current_time_us < erms->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     run_messages_read_unlock(erms);
     if (!update_needed) return;
 
-    if (run_messages_try_write_lock(ers)) return;
+    if (run_messages_try_write_lock(ers)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ers->msg.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_RUN_MESSAGES, ecs, NULL, ers, NULL, 0, 0));
+        return;
+    }
+    run_messages_refresh(efs, ecs, ers, current_time_us);
+}
 
+void
+run_test_data_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunTest *ert,
+        int run_id,
+        int index,
+        long long current_time_us)
+{
     struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
+    if (!contest_state_copy_session(ecs, &esv)) {
+        single_flight_done(&ert->parts[index].data.update);
+        return;
+    }
 
-    erms = run_messages_create(ers->run_id);
-    ejudge_client_run_messages_request(efs, ecs, &esv, ers->run_id, current_time_us, erms);
-    ejfuse_run_messages_text(erms);
-    run_messages_set(ers, erms);
+    struct EjRunTestData *ertd = run_test_data_create();
+    ejudge_client_run_test_request(efs, ecs, &esv, run_id, ert->num, index, current_time_us, ertd);
+    if (!ertd->ok) {
+        struct EjRunTestData *old = run_test_data_read_lock(ert, index);
+        long long old_recheck_time_us = (old && old->ok) ? old->recheck_time_us : -1;
+        run_test_data_read_unlock(old);
+        if (keep_stale_object(efs, &ert->parts[index].data.update, old_recheck_time_us, current_time_us,
+                              refresh_item_create(REFRESH_RUN_TEST_DATA, ecs, NULL, NULL, ert, run_id, index))) {
+            run_test_data_free(ertd);
+            return;
+        }
+    }
+    long long recheck_time_us = 0;
+    if (ertd->ok) {
+        recheck_time_us = ertd->recheck_time_us;
+        ertd->data_fd = memfd_blob_convert(&ertd->data, ertd->size);
+    }
+    run_test_data_set(ert, index, ertd);
+    if (recheck_time_us > 0 && efs->refresh_idle_us > 0) {
+        refresh_thread_schedule(efs->refresh_thread, refresh_item_create(REFRESH_RUN_TEST_DATA, ecs, NULL, NULL, ert, run_id, index),
+                                recheck_time_us, recheck_time_us - EJFUSE_REFRESH_AHEAD);
+    }
 }
 
 void
@@ -653,34 +1108,41 @@ run_test_data_maybe_update(
         int index,
         long long current_time_us)
 {
-    int update_needed = 0;
+    access_touch(&ert->parts[index].data.access_us, current_time_us);
+    int update_needed = UPDATE_NONE;
     struct EjRunTestData *ertd = run_test_data_read_lock(ert, index);
     if (ertd && ertd->ok) {
         if (ertd->recheck_time_us > 0 && current_time_us >= ertd->recheck_time_us) {
-            update_needed = 1;
+            update_needed = expired_update_mode(efs, ertd->recheck_time_us, current_time_us);
         }
     } else {
-        update_needed = 1;
+        update_needed = UPDATE_SYNC;
         if (ertd && ertd->recheck_time_us > 0 && current_time_us < ertd->recheck_time_us) {
-            update_needed = 0;
+            update_needed = UPDATE_NONE;
         }
     }
     run_test_data_read_unlock(ertd);
     if (!update_needed) return;
 
-    if (run_test_data_try_write_lock(ert, index)) return;
-
-    struct EjSessionValue esv;
-    if (!contest_state_copy_session(ecs, &esv)) return;
-
-    ertd = run_test_data_create();
-    ejudge_client_run_test_request(efs, ecs, &esv, run_id, ert->num, index, current_time_us, ertd);
-    run_test_data_set(ert, index, ertd);
+    if (run_test_data_try_write_lock(ert, index)) {
+        // the object is being fetched by another thread
+        if (update_needed == UPDATE_SYNC) single_flight_wait(&ert->parts[index].data.update, EJFUSE_FLIGHT_WAIT_TIME);
+        return;
+    }
+    if (update_needed == UPDATE_ASYNC) {
+        refresh_thread_enqueue(efs->refresh_thread, refresh_item_create(REFRESH_RUN_TEST_DATA, ecs, NULL, NULL, ert, run_id, index));
+        return;
+    }
+    run_test_data_refresh(efs, ecs, ert, run_id, index, current_time_us);
 }
 
-unsigned
+unsigned long long
 get_inode(struct EjFuseState *efs, const char *path)
 {
+    unsigned long long inode = inode_code_from_path(path);
+    if (inode) return inode;
+
+    // not a structured path, fall back to the path hash
     unsigned char digest[SHA256_DIGEST_LENGTH];
     size_t len = strlen(path);
 
@@ -689,7 +1151,7 @@ get_inode(struct EjFuseState *efs, const char *path)
     SHA256_Update(&ctx, path, len);
     SHA256_Final(digest, &ctx);
 
-    return inode_hash_insert(efs->inode_hash, digest)->inode;
+    return inode_code_make_serial(INODE_KIND_HASHED, inode_hash_insert(efs->inode_hash, digest));
 }
 
 unsigned char *
@@ -707,14 +1169,12 @@ static int
 find_problem(struct EjFuseRequest *efr, const unsigned char *name_or_id)
 {
     struct EjContestInfo *eci = contest_info_read_lock(efr->ecs);
-    for (int prob_id = 1; prob_id < eci->prob_size; ++prob_id) {
-        struct EjContestProblem *tmp = eci->probs[prob_id];
-        if (tmp && tmp->short_name && !strcmp(name_or_id, tmp->short_name)) {
-            efr->prob_id = prob_id;
-            contest_info_read_unlock(eci);
-            efr->eps = problem_states_get(efr->ecs->prob_states, efr->prob_id);
-            return prob_id;
-        }
+    int prob_id = contest_info_find_problem(eci, name_or_id);
+    if (prob_id > 0) {
+        efr->prob_id = prob_id;
+        contest_info_read_unlock(eci);
+        efr->eps = problem_states_get(efr->ecs->prob_states, efr->prob_id);
+        return prob_id;
     }
 
     errno = 0;
@@ -734,13 +1194,11 @@ static int
 find_compiler(struct EjFuseRequest *efr, const unsigned char *name_or_id)
 {
     struct EjContestInfo *eci = contest_info_read_lock(efr->ecs);
-    for (int lang_id = 1; lang_id < eci->compiler_size; ++lang_id) {
-        struct EjContestCompiler *ecl = eci->compilers[lang_id];
-        if (ecl && ecl->short_name && !strcmp(name_or_id, ecl->short_name)) {
-            efr->lang_id = lang_id;
-            contest_info_read_unlock(eci);
-            return lang_id;
-        }
+    int lang_id = contest_info_find_compiler(eci, name_or_id);
+    if (lang_id > 0) {
+        efr->lang_id = lang_id;
+        contest_info_read_unlock(eci);
+        return lang_id;
     }
 
     errno = 0;
@@ -795,6 +1253,49 @@ recognize_special_file_names(const unsigned char *file_name)
     return 0;
 }
 
+/* the run must be in the problem run list */
+static int
+lookup_run(struct EjFuseRequest *efr, int run_id)
+{
+    problem_runs_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
+    struct EjProblemRuns *eprs = problem_runs_read_lock(efr->eps);
+    if (!eprs || !eprs->ok || eprs->size <= 0) {
+        problem_runs_read_unlock(eprs);
+        return -ENOENT;
+    }
+    struct EjProblemRun *epr = problem_runs_find_unlocked(eprs, run_id);
+    if (!epr) {
+        problem_runs_read_unlock(eprs);
+        return -ENOENT;
+    }
+    efr->run_id = epr->run_id;
+    problem_runs_read_unlock(eprs);
+    return 0;
+}
+
+/* the test must be visible in the run info, efr->ers must be set */
+static int
+lookup_test(struct EjFuseRequest *efr, int num)
+{
+    struct EjRunInfo *eri = run_info_read_lock(efr->ers);
+    if (!eri || !eri->ok || !eri->is_test_available) {
+        run_info_read_unlock(eri);
+        return -ENOENT;
+    }
+    struct EjRunInfoTestResult *eritr = run_info_get_test_result_unlocked(eri, num);
+    if (!eritr || !eritr->is_visibility_full) {
+        run_info_read_unlock(eri);
+        return -ENOENT;
+    }
+    efr->num = num;
+    if (!(efr->ert = run_tests_get(efr->ers->tests, efr->num))) {
+        run_info_read_unlock(eri);
+        return -ENOENT;
+    }
+    run_info_read_unlock(eri);
+    return 0;
+}
+
 /*
  * /<CNTS>/problems/<PROB>/runs/...
  *                             ^ path
@@ -835,26 +1336,16 @@ ejf_process_path_runs(const char *path, struct EjFuseRequest *efr)
         return -ENOENT;
     }
 
-    errno = 0;
-    char *eptr = NULL;
-    long val = strtol(name_buf, &eptr, 10);
-    if (errno || *eptr || (unsigned char *) eptr == name_buf || val < 0 || (int) val != val) {
-        return -ENOENT;
-    }
-
-    problem_runs_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
-    struct EjProblemRuns *eprs = problem_runs_read_lock(efr->eps);
-    if (!eprs || !eprs->ok || eprs->size <= 0) {
-        problem_runs_read_unlock(eprs);
+    errno = 0;
+    char *eptr = NULL;
+    long val = strtol(name_buf, &eptr, 10);
+    if (errno || *eptr || (unsigned char *) eptr == name_buf || val < 0 || (int) val != val) {
         return -ENOENT;
     }
-    struct EjProblemRun *epr = problem_runs_find_unlocked(eprs, val);
-    if (!epr) {
-        problem_runs_read_unlock(eprs);
+
+    if (lookup_run(efr, val) < 0) {
         return -ENOENT;
     }
-    efr->run_id = epr->run_id;
-    problem_runs_read_unlock(eprs);
 
     if (!p1) {
         efr->ops = &ejfuse_contest_problem_runs_run_operations;
@@ -905,22 +1396,9 @@ ejf_process_path_runs(const char *path, struct EjFuseRequest *efr)
         return -ENOENT;
     }
 
-    struct EjRunInfo *eri = run_info_read_lock(efr->ers);
-    if (!eri || !eri->ok || !eri->is_test_available) {
-        run_info_read_unlock(eri);
-        return -ENOENT;
-    }
-    struct EjRunInfoTestResult *eritr = run_info_get_test_result_unlocked(eri, val);
-    if (!eritr || !eritr->is_visibility_full) {
-        run_info_read_unlock(eri);
+    if (lookup_test(efr, val) < 0) {
         return -ENOENT;
     }
-    efr->num = val;
-    if (!(efr->ert = run_tests_get(efr->ers->tests, efr->num))) {
-        run_info_read_unlock(eri);
-        return -ENOENT;
-    }
-    run_info_read_unlock(eri);
 
     if (!p3) {
         efr->ops = &ejfuse_contest_problem_runs_run_tests_test_operations;
@@ -1013,22 +1491,9 @@ ejf_process_path_submit(const char *path, struct EjFuseRequest *efr)
     return -ENOENT;
 }
 
-int
-ejf_process_path(const char *path, struct EjFuseRequest *efr)
+static int
+resolve_path(const char *path, struct EjFuseRequest *efr)
 {
-    memset(efr, 0, sizeof(*efr));
-    efr->fx = fuse_get_context();
-    efr->efs = (struct EjFuseState *) efr->fx->private_data;
-    efr->current_time_us = get_current_time();
-    // safety
-    if (!path || path[0] != '/') {
-        return -ENOENT;
-    }
-    // then process the path
-    if (!strcmp(path, "/")) {
-        efr->ops = &ejfuse_root_operations;
-        return 0;
-    }
     int len = strlen(path);
     if (path[len - 1] == '/') {
         return -ENOENT;
@@ -1063,6 +1528,7 @@ ejf_process_path(const char *path, struct EjFuseRequest *efr)
     if (!(efr->ecs = contests_state_get(efr->efs->contests_state, efr->contest_id))) {
         return -ENOENT;
     }
+    efr->path_gen = atomic_load_explicit(&efr->ecs->path_gen, memory_order_acquire);
     const char *p2 = strchr(p1 + 1, '/');
     if (!p2) {
         efr->file_name = p1 + 1;
@@ -1168,11 +1634,357 @@ ejf_process_path(const char *path, struct EjFuseRequest *efr)
     return -ENOENT;
 }
 
+/*
+ * Per-component resolution for the low-level front end. A node keeps the
+ * request resolved by ejf_process_child, ejf_process_bind re-acquires the
+ * object states for it without parsing any path.
+ */
+enum
+{
+    REQUEST_LEVEL_NONE,
+    REQUEST_LEVEL_ROOT,
+    REQUEST_LEVEL_CONTEST,
+    REQUEST_LEVEL_CONTEST_LOG,
+    REQUEST_LEVEL_CONTEST_FILE,     // INFO, info.json, problems
+    REQUEST_LEVEL_PROBLEM,
+    REQUEST_LEVEL_PROBLEM_FILE,     // INFO, info.json, statement.html
+    REQUEST_LEVEL_RUNS,
+    REQUEST_LEVEL_SUBMIT,
+    REQUEST_LEVEL_SUBMIT_COMP,
+    REQUEST_LEVEL_SUBMIT_FILE,
+    REQUEST_LEVEL_RUN,
+    REQUEST_LEVEL_RUN_FILE,
+    REQUEST_LEVEL_TESTS,
+    REQUEST_LEVEL_TEST,
+    REQUEST_LEVEL_TEST_FILE,
+};
+
+static int
+request_level(const struct EjFuseOperations *ops)
+{
+    if (ops == &ejfuse_root_operations) return REQUEST_LEVEL_ROOT;
+    if (ops == &ejfuse_contest_operations) return REQUEST_LEVEL_CONTEST;
+    if (ops == &ejfuse_contest_log_operations) return REQUEST_LEVEL_CONTEST_LOG;
+    if (ops == &ejfuse_contest_info_operations) return REQUEST_LEVEL_CONTEST_FILE;
+    if (ops == &ejfuse_contest_problems_operations) return REQUEST_LEVEL_CONTEST_FILE;
+    if (ops == &ejfuse_contest_problem_operations) return REQUEST_LEVEL_PROBLEM;
+    if (ops == &ejfuse_contest_problem_files_operations) return REQUEST_LEVEL_PROBLEM_FILE;
+    if (ops == &ejfuse_contest_problem_runs_operations) return REQUEST_LEVEL_RUNS;
+    if (ops == &ejfuse_contest_problem_submit_operations) return REQUEST_LEVEL_SUBMIT;
+    if (ops == &ejfuse_contest_problem_submit_compiler_operations) return REQUEST_LEVEL_SUBMIT_COMP;
+    if (ops == &ejfuse_contest_problem_submit_compiler_dir_operations) return REQUEST_LEVEL_SUBMIT_FILE;
+    if (ops == &ejfuse_contest_problem_runs_run_operations) return REQUEST_LEVEL_RUN;
+    if (ops == &ejfuse_contest_problem_runs_run_files_operations) return REQUEST_LEVEL_RUN_FILE;
+    if (ops == &ejfuse_contest_problem_runs_run_tests_operations) return REQUEST_LEVEL_TESTS;
+    if (ops == &ejfuse_contest_problem_runs_run_tests_test_operations) return REQUEST_LEVEL_TEST;
+    if (ops == &ejfuse_contest_problem_runs_run_tests_test_files_operations) return REQUEST_LEVEL_TEST_FILE;
+    return REQUEST_LEVEL_NONE;
+}
+
+/* copies the name up to the first ',' */
+static int
+copy_name_prefix(unsigned char *buf, size_t size, const unsigned char *name)
+{
+    const unsigned char *comma = strchr(name, ',');
+    size_t len = comma ? (size_t) (comma - name) : strlen(name);
+    if (len >= size) return -1;
+    memcpy(buf, name, len);
+    buf[len] = 0;
+    return len;
+}
+
+static int
+parse_name_id(const unsigned char *name, int min_val, int *p_val)
+{
+    errno = 0;
+    char *eptr = NULL;
+    long val = strtol(name, &eptr, 10);
+    if (errno || *eptr || (const unsigned char *) eptr == name || val < min_val || (int) val != val) {
+        return -1;
+    }
+    *p_val = val;
+    return 0;
+}
+
+/*
+ * efr is the bound request of a directory, on success it is turned into
+ * the request of its entry 'name'. efr->file_name points to 'name'.
+ */
+int
+ejf_process_child(struct EjFuseRequest *efr, const unsigned char *name)
+{
+    unsigned char name_buf[NAME_MAX + 1];
+    int val;
+
+    if (!name[0] || strchr(name, '/') || strlen(name) > NAME_MAX) {
+        return -ENOENT;
+    }
+    switch (request_level(efr->ops)) {
+    case REQUEST_LEVEL_ROOT: {
+        char *eptr = NULL;
+        errno = 0;
+        long cnts_id = strtol(name, &eptr, 10);
+        if ((const unsigned char *) eptr == name) return -ENOENT;
+        if (errno) return -ENOENT;
+        if (*eptr && *eptr != ',') return -ENOENT;
+        if (cnts_id <= 0 || (int) cnts_id != cnts_id) return -ENOENT;
+        efr->contest_id = cnts_id;
+        efr->ops = &ejfuse_contest_operations;
+        return 0;
+    }
+    case REQUEST_LEVEL_CONTEST:
+        if (!contests_is_valid(efr->efs, efr->contest_id)) {
+            return -ENOENT;
+        }
+        if (!(efr->ecs = contests_state_get(efr->efs->contests_state, efr->contest_id))) {
+            return -ENOENT;
+        }
+        efr->file_name = name;
+        efr->file_name_code = recognize_special_file_names(name);
+        if (efr->file_name_code == FILE_NAME_INFO || efr->file_name_code == FILE_NAME_INFO_JSON) {
+            efr->ops = &ejfuse_contest_info_operations;
+        } else if (!strcmp(name, "LOG")) {
+            efr->ops = &ejfuse_contest_log_operations;
+            return 0;
+        } else if (!strcmp(name, "problems")) {
+            efr->ops = &ejfuse_contest_problems_operations;
+        } else {
+            return -ENOENT;
+        }
+        contest_session_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+        contest_info_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+        return 0;
+    case REQUEST_LEVEL_CONTEST_FILE:
+        if (efr->ops != &ejfuse_contest_problems_operations) {
+            return -ENOTDIR;
+        }
+        if (copy_name_prefix(name_buf, MAX_PROB_SHORT_NAME_SIZE, name) < 0) {
+            return -ENOENT;
+        }
+        efr->file_name = NULL;
+        efr->file_name_code = 0;
+        if (find_problem(efr, name_buf) < 0) {
+            return -ENOENT;
+        }
+        efr->ops = &ejfuse_contest_problem_operations;
+        return 0;
+    case REQUEST_LEVEL_PROBLEM:
+        problem_info_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
+        efr->file_name = name;
+        efr->file_name_code = recognize_special_file_names(name);
+        if (efr->file_name_code == FILE_NAME_INFO
+            || efr->file_name_code == FILE_NAME_INFO_JSON
+            || efr->file_name_code == FILE_NAME_STATEMENT_HTML) {
+            efr->ops = &ejfuse_contest_problem_files_operations;
+            return 0;
+        } else if (!strcmp(name, "runs")) {
+            efr->ops = &ejfuse_contest_problem_runs_operations;
+            return 0;
+        } else if (!strcmp(name, "submit")) {
+            efr->ops = &ejfuse_contest_problem_submit_operations;
+            return 0;
+        }
+        return -ENOENT;
+    case REQUEST_LEVEL_RUNS:
+        copy_name_prefix(name_buf, sizeof(name_buf), name);
+        efr->file_name = NULL;
+        efr->file_name_code = recognize_special_file_names(name_buf);
+        if (efr->file_name_code == FILE_NAME_INFO || efr->file_name_code == FILE_NAME_INFO_JSON) {
+            // FIXME: handle these files
+            return -ENOENT;
+        }
+        if (parse_name_id(name_buf, 0, &val) < 0) {
+            return -ENOENT;
+        }
+        if (lookup_run(efr, val) < 0) {
+            return -ENOENT;
+        }
+        efr->ops = &ejfuse_contest_problem_runs_run_operations;
+        return 0;
+    case REQUEST_LEVEL_SUBMIT:
+        copy_name_prefix(name_buf, sizeof(name_buf), name);
+        efr->file_name = NULL;
+        efr->file_name_code = 0;
+        if (find_compiler(efr, name_buf) < 0) {
+            return -ENOENT;
+        }
+        efr->ops = &ejfuse_contest_problem_submit_compiler_operations;
+        return 0;
+    case REQUEST_LEVEL_SUBMIT_COMP:
+        efr->file_name = name;
+        efr->ops = &ejfuse_contest_problem_submit_compiler_dir_operations;
+        return 0;
+    case REQUEST_LEVEL_RUN:
+        if (!(efr->ers = run_states_get(efr->ecs->run_states, efr->run_id))) {
+            return -ENOENT;
+        }
+        run_info_maybe_update(efr->efs, efr->ecs, efr->ers, efr->current_time_us);
+        efr->file_name = name;
+        efr->file_name_code = recognize_special_file_names(name);
+        if (efr->file_name_code == FILE_NAME_TESTS) {
+            efr->ops = &ejfuse_contest_problem_runs_run_tests_operations;
+        } else {
+            efr->ops = &ejfuse_contest_problem_runs_run_files_operations;
+        }
+        return 0;
+    case REQUEST_LEVEL_TESTS:
+        efr->file_name = NULL;
+        efr->file_name_code = 0;
+        if (parse_name_id(name, 1, &val) < 0) {
+            return -ENOENT;
+        }
+        if (lookup_test(efr, val) < 0) {
+            return -ENOENT;
+        }
+        efr->ops = &ejfuse_contest_problem_runs_run_tests_test_operations;
+        return 0;
+    case REQUEST_LEVEL_TEST: {
+        int index = testing_info_parse(name);
+        if (index < 0) return -ENOENT;
+        efr->file_name = name;
+        efr->test_file_index = index;
+        efr->ops = &ejfuse_contest_problem_runs_run_tests_test_files_operations;
+        return 0;
+    }
+    case REQUEST_LEVEL_NONE:
+        return -ENOENT;
+    default:
+        return -ENOTDIR;
+    }
+}
+
+/*
+ * efr has the ops, the ids and the file name of a request resolved earlier,
+ * the object states are acquired and refreshed as ejf_process_path does.
+ */
+int
+ejf_process_bind(struct EjFuseRequest *efr)
+{
+    int level = request_level(efr->ops);
+    if (level == REQUEST_LEVEL_NONE) {
+        return -ENOENT;
+    }
+    if (level == REQUEST_LEVEL_ROOT || level == REQUEST_LEVEL_CONTEST) {
+        return 0;
+    }
+    if (!contests_is_valid(efr->efs, efr->contest_id)) {
+        return -ENOENT;
+    }
+    if (!(efr->ecs = contests_state_get(efr->efs->contests_state, efr->contest_id))) {
+        return -ENOENT;
+    }
+    if (level == REQUEST_LEVEL_CONTEST_LOG) {
+        return 0;
+    }
+    contest_session_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+    contest_info_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+    if (level == REQUEST_LEVEL_CONTEST_FILE) {
+        return 0;
+    }
+    if (!(efr->eps = problem_states_get(efr->ecs->prob_states, efr->prob_id))) {
+        return -ENOENT;
+    }
+    if (level == REQUEST_LEVEL_PROBLEM) {
+        return 0;
+    }
+    problem_info_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
+    if (level < REQUEST_LEVEL_RUN) {
+        return 0;
+    }
+    if (lookup_run(efr, efr->run_id) < 0) {
+        return -ENOENT;
+    }
+    if (level == REQUEST_LEVEL_RUN) {
+        return 0;
+    }
+    if (!(efr->ers = run_states_get(efr->ecs->run_states, efr->run_id))) {
+        return -ENOENT;
+    }
+    run_info_maybe_update(efr->efs, efr->ecs, efr->ers, efr->current_time_us);
+    if (level < REQUEST_LEVEL_TEST) {
+        return 0;
+    }
+    if (lookup_test(efr, efr->num) < 0) {
+        return -ENOENT;
+    }
+    return 0;
+}
+
+/* a cached resolution still checks the object states for expiration */
+static void
+request_maybe_update(struct EjFuseRequest *efr)
+{
+    int level = request_level(efr->ops);
+    if (level <= REQUEST_LEVEL_CONTEST_LOG) {
+        return;
+    }
+    contest_session_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+    contest_info_maybe_update(efr->efs, efr->ecs, efr->current_time_us);
+    if (level <= REQUEST_LEVEL_PROBLEM) {
+        return;
+    }
+    problem_info_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
+    if (level < REQUEST_LEVEL_RUN) {
+        return;
+    }
+    problem_runs_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
+    if (level == REQUEST_LEVEL_RUN) {
+        return;
+    }
+    run_info_maybe_update(efr->efs, efr->ecs, efr->ers, efr->current_time_us);
+}
+
+static void
+request_init(struct EjFuseRequest *efr)
+{
+    memset(efr, 0, sizeof(*efr));
+    efr->fx = fuse_get_context();
+    efr->efs = (struct EjFuseState *) efr->fx->private_data;
+    efr->current_time_us = get_current_time();
+}
+
+int
+ejf_process_path(const char *path, struct EjFuseRequest *efr)
+{
+    request_init(efr);
+    // safety
+    if (!path || path[0] != '/') {
+        return -ENOENT;
+    }
+    // then process the path
+    if (!strcmp(path, "/")) {
+        efr->ops = &ejfuse_root_operations;
+        return 0;
+    }
+
+    struct EjFuseState *efs = efr->efs;
+    if (efs->path_cache && path_cache_lookup(efs->path_cache, path, efr)) {
+        // the updates may replace the objects, so the generations are checked after them
+        request_maybe_update(efr);
+        if (efr->list_gen == atomic_load_explicit(&efs->contests_gen, memory_order_acquire)
+            && (!efr->ecs || efr->path_gen == atomic_load_explicit(&efr->ecs->path_gen, memory_order_acquire))) {
+            return 0;
+        }
+        request_init(efr);
+    }
+
+    efr->list_gen = atomic_load_explicit(&efs->contests_gen, memory_order_acquire);
+    int r = resolve_path(path, efr);
+    if (r >= 0 && efs->path_cache) {
+        path_cache_insert(efs->path_cache, path, efr);
+    }
+    return r;
+}
+
 int main(int argc, char *argv[])
 {
     unsigned char *ej_user = NULL;
     unsigned char *ej_password = NULL;
     const unsigned char *ej_url = NULL;
+    int ej_max_requests = 0;
+    long long ej_stale_limit_us = -1;
+    long long ej_refresh_idle_us = -1;
+    int ej_lowlevel = 0;
 
     int work = 0;
     do {
@@ -1212,6 +2024,59 @@ int main(int argc, char *argv[])
             memmove(&argv[1], &argv[3], (argc - 2) * sizeof(argv[0]));
             argc -= 2;
             work = 1;
+        } else if (argc >= 3 && !strcmp(argv[1], "--max-requests")) {
+            if (ej_max_requests) {
+                fprintf(stderr, "--max-requests specified more than once\n");
+                return 1;
+            }
+            char *eptr = NULL;
+            errno = 0;
+            long val = strtol(argv[2], &eptr, 10);
+            if (errno || *eptr || eptr == argv[2] || val <= 0 || val > EJFUSE_MAX_REQUESTS_LIMIT) {
+                fprintf(stderr, "--max-requests: invalid value\n");
+                return 1;
+            }
+            ej_max_requests = val;
+            memmove(&argv[1], &argv[3], (argc - 2) * sizeof(argv[0]));
+            argc -= 2;
+            work = 1;
+        } else if (argc >= 3 && !strcmp(argv[1], "--stale-limit")) {
+            if (ej_stale_limit_us >= 0) {
+                fprintf(stderr, "--stale-limit specified more than once\n");
+                return 1;
+            }
+            char *eptr = NULL;
+            errno = 0;
+            long val = strtol(argv[2], &eptr, 10);
+            if (errno || *eptr || eptr == argv[2] || val < 0 || val > 86400) {
+                fprintf(stderr, "--stale-limit: invalid value\n");
+                return 1;
+            }
+            ej_stale_limit_us = val * 1000000LL;
+            memmove(&argv[1], &argv[3], (argc - 2) * sizeof(argv[0]));
+            argc -= 2;
+            work = 1;
+        } else if (argc >= 3 && !strcmp(argv[1], "--refresh-idle")) {
+            if (ej_refresh_idle_us >= 0) {
+                fprintf(stderr, "--refresh-idle specified more than once\n");
+                return 1;
+            }
+            char *eptr = NULL;
+            errno = 0;
+            long val = strtol(argv[2], &eptr, 10);
+            if (errno || *eptr || eptr == argv[2] || val < 0 || val > 86400) {
+                fprintf(stderr, "--refresh-idle: invalid value\n");
+                return 1;
+            }
+            ej_refresh_idle_us = val * 1000000LL;
+            memmove(&argv[1], &argv[3], (argc - 2) * sizeof(argv[0]));
+            argc -= 2;
+            work = 1;
+        } else if (argc >= 2 && !strcmp(argv[1], "--lowlevel")) {
+            ej_lowlevel = 1;
+            memmove(&argv[1], &argv[2], (argc - 1) * sizeof(argv[0]));
+            --argc;
+            work = 1;
         }
     } while (work);
     if (!ej_user && isatty(0)) {
@@ -1264,6 +2129,15 @@ int main(int argc, char *argv[])
         fprintf(stderr, "--url not specified\n");
         return 1;
     }
+    if (!ej_max_requests) {
+        ej_max_requests = EJFUSE_MAX_REQUESTS;
+    }
+    if (ej_stale_limit_us < 0) {
+        ej_stale_limit_us = EJFUSE_STALE_LIMIT;
+    }
+    if (ej_refresh_idle_us < 0) {
+        ej_refresh_idle_us = EJFUSE_REFRESH_IDLE_TIME;
+    }
 
     CURLcode curle = curl_global_init(CURL_GLOBAL_ALL);
     if (curle != CURLE_OK) {
@@ -1271,35 +2145,49 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    struct EjFuseState *efs = calloc(1, sizeof(*efs));
+    struct EjFuseState *efs = aligned_alloc(_Alignof(struct EjFuseState), sizeof(*efs));
+    memset(efs, 0, sizeof(*efs));
     efs->url = strdup(ej_url);
     efs->login = strdup(ej_user);
     efs->password = strdup(ej_password);
     efs->owner_uid = getuid();
     efs->owner_gid = getgid();
+    efs->max_requests = ej_max_requests;
+    efs->stale_limit_us = ej_stale_limit_us;
+    efs->refresh_idle_us = ej_refresh_idle_us;
     efs->inode_hash = inode_hash_create();
+    efs->path_cache = path_cache_create();
     efs->contests_state = contests_state_create();
     efs->file_nodes = file_nodes_create(NODE_QUOTA, SIZE_QUOTA);
     efs->submit_thread = submit_thread_create();
+    efs->curl_pool = curl_pool_create();
+    efs->http_engine = http_engine_create(efs->curl_pool, efs->max_requests);
+    efs->refresh_thread = refresh_thread_create();
 
     //submit_thread_start(efs->submit_thread, efs);
 
     long long current_time_us = get_current_time();
     efs->start_time_us = current_time_us;
 
-    efs->top_session = calloc(1, sizeof(*efs->top_session));
-    ejudge_client_get_top_session_request(efs, current_time_us, efs->top_session);
-    if (!efs->top_session->ok) {
-        fprintf(stderr, "initial login failed: %s\n", efs->top_session->log_s);
+    efs->top_session.obj = calloc(1, sizeof(*efs->top_session.obj));
+    top_session_try_write_lock(efs);
+    top_session_refresh(efs, current_time_us);
+    if (!efs->top_session.obj->ok) {
+        fprintf(stderr, "initial login failed: %s\n", efs->top_session.obj->log_s);
         return 1;
     }
     ej_get_contest_list(efs, current_time_us);
-    if (!efs->contests->ok) {
-        fprintf(stderr, "initial contest list failed: %s\n", efs->top_session->log_s);
+    if (!efs->contests.obj->ok) {
+        fprintf(stderr, "initial contest list failed: %s\n", efs->top_session.obj->log_s);
         return 1;
     }
 
-    int retval = fuse_main(argc, argv, &ejf_fuse_operations, efs);
+    int retval;
+    if (ej_lowlevel) {
+        retval = ejf_lowlevel_main(argc, argv, efs);
+    } else {
+        retval = fuse_main(argc, argv, &ejf_fuse_operations, efs);
+    }
     free(efs);
     return retval;
 }
@@ -19,6 +19,8 @@
  * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "contests_state.h"
+
 #include <stdio.h>
 
 #define FUSE_USE_VERSION 26
@@ -26,8 +28,6 @@
 
 struct EjTopSession
 {
-    _Atomic int reader_count;   // readers count for RCU
-
     _Bool          ok;          // status is valid
     long long      recheck_time_us;
     unsigned char *log_s;
@@ -45,8 +45,6 @@ struct EjContestListItem
 
 struct EjContestList
 {
-    _Atomic int reader_count;   // readers count for RCU
-
     _Bool          ok;          // status is valid
     long long      recheck_time_us;
     unsigned char *log_s;
@@ -57,6 +55,11 @@ struct EjContestList
     struct EjContestListItem *entries;
 };
 
+struct EjCurlPool;
+struct EjHttpEngine;
+struct EjLowNodes;
+struct EjPathCache;
+struct EjRefreshThread;
 struct EjFileNodes;
 struct EjSubmitThread;
 struct EjRunState;
@@ -70,28 +73,43 @@ struct EjFuseState
     unsigned char *password;
     int owner_uid;
     int owner_gid;
+    int max_requests;           // max concurrent HTTP requests
+    long long stale_limit_us;   // max time to serve expired objects, 0 - never
+    long long refresh_idle_us;  // idle window for proactive refresh, 0 - disabled
     long long start_time_us;
 
     // the current time (microseconds)
     //_Atomic long long current_time_us;
 
     // top-level session info
-    _Atomic _Bool top_session_update;
-    _Atomic int top_session_guard;
-    struct EjTopSession *_Atomic top_session;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjTopSession) top_session;
 
     // top-level contest info
-    _Atomic _Bool contests_update;
-    _Atomic int contests_guard;
-    struct EjContestList *_Atomic contests;
+    EJ_CACHE_ALIGNED EJ_STATE_SLOT(struct EjContestList) contests;
+    _Atomic unsigned contests_gen;      // incremented when the contest list is replaced
 
     struct EjInodeHash *inode_hash;
 
+    // resolved paths of the high-level front end
+    struct EjPathCache *path_cache;
+
     struct EjContestsState *contests_state;
 
     struct EjFileNodes *file_nodes;
 
     struct EjSubmitThread *submit_thread;
+
+    // reusable CURL handles, one per thread
+    struct EjCurlPool *curl_pool;
+
+    // all HTTP requests go through this engine
+    struct EjHttpEngine *http_engine;
+
+    // background refresh of expired objects
+    struct EjRefreshThread *refresh_thread;
+
+    // nodes of the low-level front end
+    struct EjLowNodes *low_nodes;
 };
 
 struct EjFuseRequest
@@ -114,6 +132,10 @@ struct EjFuseRequest
     int num;
     struct EjRunTest *ert;
     int test_file_index;
+
+    // generations of the contest list and of ecs the request was resolved with
+    unsigned list_gen;
+    unsigned path_gen;
 };
 
 struct EjFuseRequest;
@@ -164,10 +186,17 @@ struct EjFuseOperations
 };
 
 int ejf_process_path(const char *path, struct EjFuseRequest *rq);
+int ejf_process_child(struct EjFuseRequest *rq, const unsigned char *name);
+int ejf_process_bind(struct EjFuseRequest *rq);
 
 int request_free(struct EjFuseRequest *rq, int retval);
 
-unsigned get_inode(struct EjFuseState *efs, const char *path);
+long long get_current_time(void);
+
+unsigned long long get_inode(struct EjFuseState *efs, const char *path);
+
+struct EjTopSession *top_session_read_lock(struct EjFuseState *efs);
+void top_session_read_unlock(struct EjTopSession *tls);
 
 struct EjContestList *contest_list_read_lock(struct EjFuseState *efs);
 void contest_list_read_unlock(struct EjContestList *contests);
@@ -235,6 +264,63 @@ run_test_data_maybe_update(
         int index,
         long long current_time_us);
 
+// fetch the object from the server, the object write lock must be held
+void top_session_refresh(struct EjFuseState *efs, long long current_time_us);
+void
+contest_session_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        long long current_time_us);
+void
+contest_info_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        long long current_time_us);
+void
+problem_info_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us);
+void
+problem_statement_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us);
+void
+problem_runs_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        long long current_time_us);
+void
+run_info_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us);
+void
+run_source_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us);
+void
+run_messages_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        long long current_time_us);
+void
+run_test_data_refresh(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunTest *ert,
+        int run_id,
+        int index,
+        long long current_time_us);
+
 /* special file names */
 enum
 {
@@ -27,12 +27,23 @@
 #include <sys/types.h>
 #include <stdio.h>
 #include <assert.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+enum { FILE_NODE_PAGE_SIZE = 4096 };
+
+enum
+{
+    FILE_NODES_BUCKETS = 64,    // initial number of hash buckets
+    DIR_NODES_BUCKETS = 16,
+};
 
 struct EjFileNode *
 file_node_create(int fnode)
 {
     struct EjFileNode *efn = calloc(1, sizeof(*efn));
     efn->fnode = fnode;
+    efn->fd = -1;
     pthread_mutex_init(&efn->m, NULL);
     return efn;
 }
@@ -42,11 +53,19 @@ file_node_free(struct EjFileNode *efn)
 {
     if (efn) {
         pthread_mutex_destroy(&efn->m);
-        free(efn->data);
+        if (efn->fd >= 0) close(efn->fd);
         free(efn);
     }
 }
 
+void
+file_node_unref(struct EjFileNode *efn)
+{
+    if (efn) {
+        atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_release);
+    }
+}
+
 struct EjFileNodes *
 file_nodes_create(int node_quota, int size_quota)
 {
@@ -55,6 +74,8 @@ file_nodes_create(int node_quota, int size_quota)
     efns->serial = 1;
     efns->node_quota = node_quota;
     efns->size_quota = size_quota;
+    efns->bucket_count = FILE_NODES_BUCKETS;
+    efns->buckets = calloc(efns->bucket_count, sizeof(efns->buckets[0]));
     return efns;
 }
 
@@ -63,10 +84,14 @@ file_nodes_free(struct EjFileNodes *efns)
 {
     if (efns) {
         pthread_rwlock_destroy(&efns->rwl);
-        for (int i = 0; i < efns->size; ++i) {
-            file_node_free(efns->nodes[i]);
+        for (int i = 0; i < efns->bucket_count; ++i) {
+            struct EjFileNode *p, *q;
+            for (p = efns->buckets[i]; p; p = q) {
+                q = p->hash_next;
+                file_node_free(p);
+            }
         }
-        free(efns->nodes);
+        free(efns->buckets);
         {
             struct EjFileNode *p, *q;
             for (p = efns->reclaim_first; p; p = q) {
@@ -78,20 +103,42 @@ file_nodes_free(struct EjFileNodes *efns)
     }
 }
 
+static void
+file_nodes_rehash_unlocked(struct EjFileNodes *efns)
+{
+    int new_count = efns->bucket_count * 2;
+    struct EjFileNode **new_buckets = calloc(new_count, sizeof(new_buckets[0]));
+    for (int i = 0; i < efns->bucket_count; ++i) {
+        struct EjFileNode *p, *q;
+        for (p = efns->buckets[i]; p; p = q) {
+            q = p->hash_next;
+            struct EjFileNode **pb = &new_buckets[p->fnode & (new_count - 1)];
+            p->hash_next = *pb;
+            *pb = p;
+        }
+    }
+    free(efns->buckets);
+    efns->buckets = new_buckets;
+    efns->bucket_count = new_count;
+}
+
 static struct EjFileNode *
 file_nodes_create_node(struct EjFileNodes *efns)
 {
     struct EjFileNode *retval = NULL;
     pthread_rwlock_wrlock(&efns->rwl);
     if (efns->node_quota <= 0 || efns->size < efns->node_quota) {
-        if (efns->size == efns->reserved) {
-            if (!(efns->reserved *= 2)) efns->reserved = 32;
-            efns->nodes = realloc(efns->nodes, efns->reserved * sizeof(efns->nodes[0]));
+        if (efns->size >= efns->bucket_count) {
+            file_nodes_rehash_unlocked(efns);
         }
-        efns->nodes[efns->size++] = retval = file_node_create(efns->serial++);
+        retval = file_node_create(efns->serial++);
+        struct EjFileNode **pb = &efns->buckets[retval->fnode & (efns->bucket_count - 1)];
+        retval->hash_next = *pb;
+        *pb = retval;
+        ++efns->size;
         atomic_fetch_add_explicit(&retval->refcnt, 1, memory_order_relaxed);
-        pthread_rwlock_unlock(&efns->rwl);
     }
+    pthread_rwlock_unlock(&efns->rwl);
     return retval;
 }
 
@@ -100,51 +147,42 @@ file_nodes_get_node(struct EjFileNodes *efns, int fnode)
 {
     struct EjFileNode *retval = NULL;
     pthread_rwlock_rdlock(&efns->rwl);
-    if (efns->size > 0 && fnode >= efns->nodes[0]->fnode && fnode <= efns->nodes[efns->size - 1]->fnode) {
-        int low = 0, high = efns->size;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            struct EjFileNode *tmp = efns->nodes[mid];
-            if (tmp->fnode == fnode) {
-                retval = tmp;
-                atomic_fetch_add_explicit(&retval->refcnt, 1, memory_order_relaxed);
-                break;
-            } else if (tmp->fnode < fnode) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
+    for (retval = efns->buckets[fnode & (efns->bucket_count - 1)]; retval; retval = retval->hash_next) {
+        if (retval->fnode == fnode) {
+            atomic_fetch_add_explicit(&retval->refcnt, 1, memory_order_relaxed);
+            break;
         }
     }
     pthread_rwlock_unlock(&efns->rwl);
     return retval;
 }
 
-void
-unused_file_nodes_remove_node(struct EjFileNodes *efns, int fnode)
+static void
+file_nodes_reclaim_push(struct EjFileNodes *efns, struct EjFileNode *efn)
 {
-    pthread_rwlock_wrlock(&efns->rwl);
-    if (efns->size > 0 && fnode >= efns->nodes[0]->fnode && fnode <= efns->nodes[efns->size - 1]->fnode) {
-        int low = 0, high = efns->size;
-        while (low < high) {
-            int mid = (low + high) / 2;
-            struct EjFileNode *tmp = efns->nodes[mid];
-            if (tmp->fnode == fnode) {
-                tmp->reclaim_next = efns->reclaim_first;
-                efns->reclaim_first = tmp;
-                if (mid < efns->size - 1) {
-                    memmove(&efns->nodes[mid], &efns->nodes[mid + 1], (efns->size - mid - 1) * sizeof(efns->nodes[0]));
-                }
-                --efns->size;
-                break;
-            } else if (tmp->fnode < fnode) {
-                low = mid + 1;
-            } else {
-                high = mid;
-            }
+    efn->reclaim_next = atomic_load_explicit(&efns->reclaim_first, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&efns->reclaim_first, &efn->reclaim_next, efn, memory_order_release, memory_order_relaxed)) {
+    }
+}
+
+/*
+ * Removed nodes cannot be referenced anew, so a node with zero refcnt
+ * is free to go. The whole stack is taken at once, the nodes still
+ * referenced are pushed back.
+ */
+static void
+file_nodes_reclaim(struct EjFileNodes *efns)
+{
+    struct EjFileNode *p = atomic_exchange_explicit(&efns->reclaim_first, NULL, memory_order_acquire);
+    while (p) {
+        struct EjFileNode *q = p->reclaim_next;
+        if (atomic_load_explicit(&p->refcnt, memory_order_acquire) <= 0) {
+            file_node_free(p);
+        } else {
+            file_nodes_reclaim_push(efns, p);
         }
+        p = q;
     }
-    pthread_rwlock_unlock(&efns->rwl);
 }
 
 // efn is an owned pointer
@@ -152,43 +190,39 @@ void
 file_nodes_maybe_remove(struct EjFileNodes *efns, struct EjFileNode *efn, long long current_time_us)
 {
     if (atomic_load_explicit(&efn->nlink, memory_order_relaxed) > 0
-        || atomic_load_explicit(&efn->opencnt, memory_order_relaxed) > 0) return;
+        || atomic_load_explicit(&efn->opencnt, memory_order_relaxed) > 0) {
+        file_node_unref(efn);
+        return;
+    }
 
     pthread_rwlock_wrlock(&efns->rwl);
-    int low = 0, high = efns->size;
-    struct EjFileNode *rmn = NULL;
-    while (low < high) {
-        int mid = (low + high) / 2;
-        struct EjFileNode *tmp = efns->nodes[mid];
-        if (tmp->fnode == efn->fnode) {
-            assert(tmp == efn);
-            low = mid;
-            rmn = tmp;
-            break;
-        } else if (tmp->fnode < efn->fnode) {
-            low = mid + 1;
-        } else {
-            high = mid;
-        }
+    struct EjFileNode **pp = &efns->buckets[efn->fnode & (efns->bucket_count - 1)];
+    while (*pp && *pp != efn) {
+        pp = &(*pp)->hash_next;
     }
-    if (!rmn) {
-        atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    if (!*pp) {
+        // removed by another thread
         pthread_rwlock_unlock(&efns->rwl);
+        file_node_unref(efn);
         return;
     }
-    if (low < efns->size - 1) {
-        memmove(&efns->nodes[low], &efns->nodes[low + 1], (efns->size - low - 1) * sizeof(efns->nodes[0]));
-    }
+    *pp = efn->hash_next;
+    efn->hash_next = NULL;
     --efns->size;
-    atomic_fetch_sub_explicit(&efns->total_size, rmn->size, memory_order_relaxed);
-    if (atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed) <= 1) {
-        file_node_free(rmn);
+    pthread_rwlock_unlock(&efns->rwl);
+
+    // a write racing with the removal must not charge the quota afterwards
+    pthread_mutex_lock(&efn->m);
+    atomic_fetch_sub_explicit(&efns->total_size, efn->allocated, memory_order_relaxed);
+    efn->removed = 1;
+    efn->dtime_us = current_time_us;
+    pthread_mutex_unlock(&efn->m);
+    if (atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_acq_rel) <= 1) {
+        file_node_free(efn);
     } else {
-        rmn->reclaim_next = efns->reclaim_first;
-        efns->reclaim_first = rmn;
-        rmn->dtime_us = current_time_us;
+        file_nodes_reclaim_push(efns, efn);
     }
-    pthread_rwlock_unlock(&efns->rwl);
+    file_nodes_reclaim(efns);
 }
 
 struct EjDirectoryNode *
@@ -218,6 +252,8 @@ dir_nodes_create(void)
 {
     struct EjDirectoryNodes *edns = calloc(1, sizeof(*edns));
     pthread_rwlock_init(&edns->rwl, NULL);
+    edns->bucket_count = DIR_NODES_BUCKETS;
+    edns->buckets = calloc(edns->bucket_count, sizeof(edns->buckets[0]));
     return edns;
 }
 
@@ -230,10 +266,83 @@ dir_nodes_free(struct EjDirectoryNodes *edns)
             dir_node_free(edns->nodes[i]);
         }
         free(edns->nodes);
+        free(edns->buckets);
         free(edns);
     }
 }
 
+/* FNV-1a */
+static unsigned
+dir_name_hash(const unsigned char *name, size_t len)
+{
+    unsigned hash = 2166136261U;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static struct EjDirectoryNode **
+dir_nodes_find_unlocked(
+        struct EjDirectoryNodes *edns,
+        const unsigned char *name,
+        size_t len,
+        unsigned hash)
+{
+    struct EjDirectoryNode **pp = &edns->buckets[hash & (edns->bucket_count - 1)];
+    for (; *pp; pp = &(*pp)->hash_next) {
+        struct EjDirectoryNode *tmp = *pp;
+        if (tmp->hash == hash && !memcmp(tmp->name, name, len) && !tmp->name[len]) {
+            break;
+        }
+    }
+    return pp;
+}
+
+static void
+dir_nodes_insert_unlocked(struct EjDirectoryNodes *edns, struct EjDirectoryNode *edn)
+{
+    if (edns->size >= edns->bucket_count) {
+        int new_count = edns->bucket_count * 2;
+        struct EjDirectoryNode **new_buckets = calloc(new_count, sizeof(new_buckets[0]));
+        for (int i = 0; i < edns->size; ++i) {
+            struct EjDirectoryNode *tmp = edns->nodes[i];
+            struct EjDirectoryNode **pb = &new_buckets[tmp->hash & (new_count - 1)];
+            tmp->hash_next = *pb;
+            *pb = tmp;
+        }
+        free(edns->buckets);
+        edns->buckets = new_buckets;
+        edns->bucket_count = new_count;
+    }
+    if (edns->size == edns->reserved) {
+        if (!(edns->reserved *= 2)) edns->reserved = 16;
+        edns->nodes = realloc(edns->nodes, edns->reserved * sizeof(edns->nodes[0]));
+    }
+    edn->index = edns->size;
+    edns->nodes[edns->size++] = edn;
+    struct EjDirectoryNode **pb = &edns->buckets[edn->hash & (edns->bucket_count - 1)];
+    edn->hash_next = *pb;
+    *pb = edn;
+}
+
+// pp points to the hash chain link of the node, the node is freed
+static void
+dir_nodes_remove_unlocked(struct EjDirectoryNodes *edns, struct EjDirectoryNode **pp)
+{
+    struct EjDirectoryNode *edn = *pp;
+    *pp = edn->hash_next;
+    int last = edns->size - 1;
+    if (edn->index < last) {
+        edns->nodes[edn->index] = edns->nodes[last];
+        edns->nodes[edn->index]->index = edn->index;
+    }
+    edns->nodes[last] = NULL;
+    --edns->size;
+    dir_node_free(edn);
+}
+
 int
 dir_nodes_get_node(
         struct EjDirectoryNodes *edns,
@@ -243,21 +352,12 @@ dir_nodes_get_node(
 {
     int retval = -ENOENT;
     if (len > NAME_MAX) return -ENAMETOOLONG;
+    unsigned hash = dir_name_hash(name, len);
     pthread_rwlock_rdlock(&edns->rwl);
-    int low = 0, high = edns->size;
-    while (low < high) {
-        int mid = (low + high) / 2;
-        struct EjDirectoryNode *tmp = edns->nodes[mid];
-        int r = strcmp(tmp->name, name);
-        if (!r) {
-            memcpy(res, tmp, sizeof(*res));
-            retval = 0;
-            break;
-        } else if (r < 0) {
-            low = mid + 1;
-        } else {
-            high = mid;
-        }
+    struct EjDirectoryNode *tmp = *dir_nodes_find_unlocked(edns, name, len, hash);
+    if (tmp) {
+        memcpy(res, tmp, sizeof(*res));
+        retval = 0;
     }
     pthread_rwlock_unlock(&edns->rwl);
     return retval;
@@ -299,25 +399,17 @@ dir_nodes_open_node(
     if (len > NAME_MAX) return -ENAMETOOLONG;
 
     int retval = -ENOENT;
+    unsigned hash = dir_name_hash(name, len);
     pthread_rwlock_wrlock(&edns->rwl);
-    int low = 0, high = edns->size;
-    while (low < high) {
-        int mid = (low + high) / 2;
-        struct EjDirectoryNode *tmp = edns->nodes[mid];
-        int r = strcmp(tmp->name, name);
-        if (!r) {
-            if (excl_mode > 0) {
-                retval = -EEXIST;
-            } else {
-                retval = 0;
-                memcpy(res, tmp, sizeof(*res));
-            }
-            goto done;
-        } else if (r < 0) {
-            low = mid + 1;
+    struct EjDirectoryNode *tmp = *dir_nodes_find_unlocked(edns, name, len, hash);
+    if (tmp) {
+        if (excl_mode > 0) {
+            retval = -EEXIST;
         } else {
-            high = mid;
+            retval = 0;
+            memcpy(res, tmp, sizeof(*res));
         }
+        goto done;
     }
     if (create_mode <= 0) {
         retval = -ENOENT;
@@ -333,18 +425,12 @@ dir_nodes_open_node(
     efn->ctime_us = current_time_us;
     efn->mtime_us = current_time_us;
 
-    if (edns->size == edns->reserved) {
-        if (!(edns->reserved *= 2)) edns->reserved = 16;
-        edns->nodes = realloc(edns->nodes, edns->reserved * sizeof(edns->nodes[0]));
-    }
-    if (low < edns->size) {
-        memmove(&edns->nodes[low + 1], &edns->nodes[low], (edns->size - low) * sizeof(edns->nodes[0]));
-    }
-    edns->nodes[low] = dir_node_create(efn->fnode, name, len);
-    ++edns->size;
+    tmp = dir_node_create(efn->fnode, name, len);
+    tmp->hash = hash;
+    dir_nodes_insert_unlocked(edns, tmp);
     atomic_fetch_add_explicit(&efn->nlink, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
-    memcpy(res, edns->nodes[low], sizeof(*res));
+    file_node_unref(efn);
+    memcpy(res, tmp, sizeof(*res));
     retval = 0;
 
 done:
@@ -362,30 +448,14 @@ dir_nodes_unlink_node(
     if (len > NAME_MAX) return -ENAMETOOLONG;
 
     int retval = -ENOENT;
+    unsigned hash = dir_name_hash(name, len);
     pthread_rwlock_wrlock(&edns->rwl);
-    int low = 0, high = edns->size;
-    while (low < high) {
-        int mid = (low + high) / 2;
-        struct EjDirectoryNode *tmp = edns->nodes[mid];
-        int r = strcmp(tmp->name, name);
-        if (!r) {
-            memcpy(res, tmp, sizeof(*res));
-            free(tmp);
-            edns->nodes[mid] = NULL;
-            if (mid < edns->size - 1) {
-                memmove(&edns->nodes[mid], &edns->nodes[mid + 1], (edns->size - mid - 1) * sizeof(edns->nodes[0]));
-            }
-            --edns->size;
-            retval = 0;
-            goto done;
-        } else if (r < 0) {
-            low = mid + 1;
-        } else {
-            high = mid;
-        }
+    struct EjDirectoryNode **pp = dir_nodes_find_unlocked(edns, name, len, hash);
+    if (*pp) {
+        memcpy(res, *pp, sizeof(*res));
+        dir_nodes_remove_unlocked(edns, pp);
+        retval = 0;
     }
-
-done:
     pthread_rwlock_unlock(&edns->rwl);
     return retval;
 }
@@ -402,12 +472,9 @@ dir_nodes_unlink_node_by_fnode(
         struct EjDirectoryNode *tmp = edns->nodes[i];
         if (tmp->fnode == fnode) {
             memcpy(res, tmp, sizeof(*res));
-            free(tmp);
-            edns->nodes[i] = NULL;
-            if (i < edns->size - 1) {
-                memmove(&edns->nodes[i], &edns->nodes[i + 1], (edns->size - i - 1) * sizeof(edns->nodes[0]));
-            }
-            --edns->size;
+            struct EjDirectoryNode **pp = &edns->buckets[tmp->hash & (edns->bucket_count - 1)];
+            while (*pp != tmp) pp = &(*pp)->hash_next;
+            dir_nodes_remove_unlocked(edns, pp);
             retval = 0;
             break;
         }
@@ -442,22 +509,108 @@ dir_nodes_read(struct EjDirectoryNodes *edns, int index, struct EjDirectoryNode
 }
 
 int
-file_node_reserve_unlocked(struct EjFileNode *efn, off_t offset)
+file_node_pread(int fd, unsigned char *buf, int size, int offset)
 {
-    if (offset < 0) return -EINVAL;
-    int ioff = offset;
-    if (ioff != offset) return -EINVAL;
-    if (ioff <= efn->reserved) return 0;
+    if (fd < 0) {
+        memset(buf, 0, size);
+        return size;
+    }
+    int done = 0;
+    while (done < size) {
+        ssize_t r = pread(fd, buf + done, size - done, offset + done);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -EIO;
+        if (!r) {
+            // truncated concurrently
+            memset(buf + done, 0, size - done);
+            break;
+        }
+        done += r;
+    }
+    return size;
+}
+
+int
+file_node_pwrite(int fd, const unsigned char *buf, int size, int offset)
+{
+    if (fd < 0) return -EIO;
+    int done = 0;
+    while (done < size) {
+        ssize_t r = pwrite(fd, buf + done, size - done, offset + done);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -EIO;
+        done += r;
+    }
+    return size;
+}
 
-    int new_reserved = efn->reserved * 2;
-    if (!new_reserved) new_reserved = 4096;
-    while (new_reserved < ioff) new_reserved *= 2;
-    unsigned char *new_data = realloc(efn->data, new_reserved);
-    if (!new_data) return -EIO;
-    efn->data = new_data;
-    memset(efn->data + efn->reserved, 0, new_reserved - efn->reserved);
-    efn->reserved = new_reserved;
+// updates efn->allocated and total_size from the pages of the memfd
+void
+file_node_account_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn)
+{
+    if (efn->removed) return;
+    long long bytes = 0;
+    if (efn->fd >= 0) {
+        struct stat stb;
+        if (fstat(efn->fd, &stb) < 0) return;
+        bytes = (long long) stb.st_blocks * 512;
+    }
+    int allocated = bytes > INT_MAX?INT_MAX:(int) bytes;
+    atomic_fetch_add_explicit(&efns->total_size, allocated - efn->allocated, memory_order_relaxed);
+    efn->allocated = allocated;
+}
 
+// bytes of the page range [begin, end) not backed by memfd pages
+static long long
+file_node_unallocated(struct EjFileNode *efn, off_t begin, off_t end)
+{
+    if (efn->fd < 0) return end - begin;
+
+    long long holes = 0;
+    off_t pos = begin;
+    while (pos < end) {
+        off_t hole = lseek(efn->fd, pos, SEEK_HOLE);
+        if (hole < 0) {
+            if (errno != ENXIO) goto fallback;
+            hole = pos;          // past the end of file
+        }
+        if (hole >= end) break;
+        off_t data = lseek(efn->fd, hole, SEEK_DATA);
+        if (data < 0) {
+            if (errno != ENXIO) goto fallback;
+            data = end;          // no data after the hole
+        }
+        if (data > end) data = end;
+        holes += data - hole;
+        pos = data;
+    }
+    return holes;
+
+fallback:
+    // no SEEK_HOLE support, only the growth past the current size is charged
+    if (end <= efn->size) return 0;
+    return end - (begin > efn->size ? begin : efn->size);
+}
+
+int
+file_node_reserve_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn, int offset, int size)
+{
+    if (efns->size_quota <= 0 || size <= 0 || efn->removed) return 0;
+
+    // only the pages of the range which are not allocated yet are charged
+    off_t begin = (off_t) (offset / FILE_NODE_PAGE_SIZE) * FILE_NODE_PAGE_SIZE;
+    off_t end = (((off_t) offset + size - 1) / FILE_NODE_PAGE_SIZE + 1) * FILE_NODE_PAGE_SIZE;
+    long long need = file_node_unallocated(efn, begin, end);
+    if (!need) return 0;
+    if (need > efns->size_quota) return -EIO;
+    // charged right away, so concurrent writers cannot overcommit together,
+    // file_node_account_unlocked settles the difference after the write
+    long long total = atomic_fetch_add_explicit(&efns->total_size, (int) need, memory_order_relaxed) + need;
+    if (total > efns->size_quota) {
+        atomic_fetch_sub_explicit(&efns->total_size, (int) need, memory_order_relaxed);
+        return -EIO;
+    }
+    efn->allocated += need;
     return 0;
 }
 
@@ -469,28 +622,25 @@ file_node_truncate_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn, of
     if (ioff != offset) return -EINVAL;
     if (ioff == efn->size) return 0;
     if (ioff < efn->size) {
-        int diff = efn->size - ioff;
-        atomic_fetch_sub_explicit(&efns->total_size, diff, memory_order_relaxed);
-        memset(efn->data + ioff, 0, efn->size - ioff);
+        // the pages past the new size are freed, the tail reads as zeros
+        if (efn->fd >= 0 && ftruncate(efn->fd, ioff) < 0) return -EIO;
         efn->size = ioff;
+        file_node_account_unlocked(efns, efn);
         return 0;
     }
 
-    // race condition on total_size between check and add
-    int diff = ioff - efn->size;
-    int new_size;
-    if (__builtin_add_overflow(efns->total_size, diff, &new_size)) {
-        return -EIO;
-    }
-    if (efns->size_quota > 0 && new_size > efns->size_quota) {
+    // extending creates a hole, the logical size is still limited by the quota
+    if (efns->size_quota > 0 && ioff > efns->size_quota) {
         return -EIO;
     }
 
-    int res = file_node_reserve_unlocked(efn, ioff);
-    if (res < 0) return res;
+    if (efn->fd < 0) {
+        efn->fd = memfd_create("ejfuse-file", MFD_CLOEXEC);
+        if (efn->fd < 0) return -EIO;
+    }
+    if (ftruncate(efn->fd, ioff) < 0) return -EIO;
 
     efn->size = ioff;
-    atomic_fetch_add_explicit(&efns->total_size, diff, memory_order_relaxed);
     return 0;
 }
 
@@ -502,12 +652,15 @@ file_nodes_list(struct EjFileNodes *efns)
     if (efns->size > 0 || efns->reclaim_first) {
         fprintf(stderr, "NODES: nodes: %d, size: %d\n", efns->size, efns->total_size);
     }
-    for (int i = 0; i < efns->size; ++i) {
-        struct EjFileNode *efn = efns->nodes[i];
-        fprintf(stderr, "[%d]: %d, %d, %d, %d, %d\n", i, efn->fnode, efn->refcnt, efn->opencnt, efn->nlink, efn->size);
+    int serial = 0;
+    for (int i = 0; i < efns->bucket_count; ++i) {
+        for (struct EjFileNode *efn = efns->buckets[i]; efn; efn = efn->hash_next) {
+            fprintf(stderr, "[%d]: %d, %d, %d, %d, %d, %d\n", serial++, efn->fnode, efn->refcnt, efn->opencnt, efn->nlink, efn->size, efn->allocated);
+        }
     }
+    // for debugging only, the reclaimed nodes may be freed concurrently
     if (efns->reclaim_first) {
-        int serial = 0;
+        serial = 0;
         fprintf(stderr, "RECLAIM:\n");
         for (struct EjFileNode *efn = efns->reclaim_first; efn; efn = efn->reclaim_next) {
             fprintf(stderr, "[%d]: %d, %d, %d, %d, %d, %lld\n", serial++, efn->fnode, efn->refcnt, efn->opencnt, efn->nlink, efn->size, efn->dtime_us);
@@ -27,11 +27,12 @@
 struct EjFileNode
 {
     int fnode;   // serial number, a component to "/fnone/<NUM>" path to generate an inode
-    struct EjFileNode *reclaim_next; // the list of nodes for reclaim
+    struct EjFileNode *hash_next;    // the chain of the fnode hash bucket
+    struct EjFileNode *reclaim_next; // the stack of nodes for reclaim
 
     pthread_mutex_t m;
     //pthread_rwlock_t rwl;
-    _Atomic int refcnt;   // reference counter for pointers outside of EjFileNodes
+    _Atomic int refcnt;   // reference counter for pointers outside of EjFileNodes, incl. ffi->fh
     _Atomic int opencnt;  // open file counter
     _Atomic int nlink;    // refcounter
 
@@ -43,8 +44,9 @@ struct EjFileNode
     long long dtime_us;
 
     int size;      // int - intentionally, we don't want too big files (>= 2G)
-    int reserved;  // int - intentionally, we don't want too big files (>= 2G)
-    unsigned char *data;
+    int fd;        // memfd holding the content, -1 until the file is extended
+    int allocated; // bytes charged to the size quota: memfd pages in use and reserved
+    _Bool removed; // removed from EjFileNodes, no longer charged to the quota
 };
 
 struct EjFileNodes
@@ -55,17 +57,23 @@ struct EjFileNodes
     int size_quota;
 
     int serial;
-    int reserved;
     int size;
-    struct EjFileNode **nodes;
-    struct EjFileNode *reclaim_first;
-    _Atomic int total_size;   // total size of files
+    int bucket_count;         // power of 2
+    struct EjFileNode **buckets;    // hash by fnode
+    // removed nodes still referenced, freed when refcnt drops to 0
+    struct EjFileNode * _Atomic reclaim_first;
+    _Atomic int total_size;   // total allocated size of files
 };
 
 struct EjDirectoryNode
 {
     int fnode;
     unsigned char name[NAME_MAX + 1];
+
+    // owned by EjDirectoryNodes, meaningless in copies
+    unsigned hash;
+    int index;
+    struct EjDirectoryNode *hash_next;
 };
 
 struct EjDirectoryNodes
@@ -74,7 +82,9 @@ struct EjDirectoryNodes
 
     int reserved;
     int size;
-    struct EjDirectoryNode **nodes;
+    struct EjDirectoryNode **nodes; // unordered, for readdir
+    int bucket_count;               // power of 2
+    struct EjDirectoryNode **buckets;   // hash by name
 };
 
 struct EjFileNode *file_node_create(int fnode);
@@ -83,8 +93,13 @@ void file_node_free(struct EjFileNode *efn);
 struct EjFileNodes *file_nodes_create(int node_quota, int size_quota);
 void file_nodes_free(struct EjFileNodes *efns);
 
+/*
+ * file_nodes_get_node returns a referenced node, the reference is dropped
+ * by file_node_unref or passed to file_nodes_maybe_remove. An open file
+ * keeps its reference in ffi->fh.
+ */
 struct EjFileNode *file_nodes_get_node(struct EjFileNodes *efns, int fnode);
-void file_nodes_remove_node(struct EjFileNodes *efns, int fnode);
+void file_node_unref(struct EjFileNode *efn);
 void file_nodes_maybe_remove(struct EjFileNodes *efns, struct EjFileNode *efn, long long current_time_us);
 
 struct EjDirectoryNode *
@@ -136,7 +151,21 @@ void dir_nodes_unlock(struct EjDirectoryNodes *edns);
 int dir_nodes_size(struct EjDirectoryNodes *edns);
 int dir_nodes_read(struct EjDirectoryNodes *edns, int index, struct EjDirectoryNode *res);
 
-int file_node_reserve_unlocked(struct EjFileNode *efn, off_t offset);
+/*
+ * The memfd is a paged store: holes left by truncate or sparse writes
+ * read as zeros and take no memory, so the quota is charged by the pages
+ * actually allocated. A writer charges the pages its range may need
+ * before the write (added to allocated) and settles the accounting after it.
+ */
 int file_node_truncate_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn, off_t offset);
+int file_node_reserve_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn, int offset, int size);
+void file_node_account_unlocked(struct EjFileNodes *efns, struct EjFileNode *efn);
+
+/*
+ * The content is accessed through the fd taken under efn->m, the data
+ * transfer itself does not need the mutex. A negative fd reads as zeros.
+ */
+int file_node_pread(int fd, unsigned char *buf, int size, int offset);
+int file_node_pwrite(int fd, const unsigned char *buf, int size, int offset);
 
 void file_nodes_list(struct EjFileNodes *efns);
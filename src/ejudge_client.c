@@ -20,8 +20,10 @@
 #include "ejudge_client.h"
 
 #include "settings.h"
+#include "http_engine.h"
 #include "contests_state.h"
 #include "ejfuse.h"
+#include "arena.h"
 
 #include <curl/curl.h>
 
@@ -51,14 +53,8 @@ ejudge_client_get_top_session_request(
     char *post_s = NULL;
     char *resp_s = NULL;
     CURLcode res;
-    CURL *curl = NULL;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -70,10 +66,10 @@ ejudge_client_get_top_session_request(
     {
         size_t post_z = 0;
         FILE *post_f = open_memstream(&post_s, &post_z);
-        char *s = curl_easy_escape(curl, efs->login, 0);
+        char *s = curl_easy_escape(NULL, efs->login, 0);
         fprintf(post_f, "login=%s", s);
         free(s);
-        s = curl_easy_escape(curl, efs->password, 0);
+        s = curl_easy_escape(NULL, efs->password, 0);
         fprintf(post_f, "&password=%s", s);
         free(s); s = NULL;
         fprintf(post_f, "&action=login-json");
@@ -83,16 +79,11 @@ ejudge_client_get_top_session_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_s);
-        curl_easy_setopt(curl, CURLOPT_POST, 1);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s, .post = post_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -105,7 +96,6 @@ ejudge_client_get_top_session_request(
 
     free(post_s); post_s = NULL;
     free(url_s); url_s = NULL;
-    curl_easy_cleanup(curl); curl = NULL;
 
     //fprintf(stdout, ">%s<\n", resp_s);
 
@@ -120,9 +110,6 @@ ejudge_client_get_top_session_request(
 
  cleanup:
     free(resp_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     free(url_s);
     free(post_s);
     if (err_f) {
@@ -147,7 +134,6 @@ ejudge_client_get_contest_list_request(
         long long current_time_us,
         struct EjContestList *contests)
 {
-    CURL *curl = NULL;
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
@@ -155,11 +141,6 @@ ejudge_client_get_contest_list_request(
     char *resp_s = NULL;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -167,8 +148,8 @@ ejudge_client_get_contest_list_request(
         char *s1, *s2;
         fprintf(url_f, "%sregister?action=user-contests-json&SID=%s&EJSID=%s&json=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)));
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)));
         free(s1);
         free(s2);
         fclose(url_f);
@@ -177,14 +158,11 @@ ejudge_client_get_contest_list_request(
     CURLcode res = 0;
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -215,9 +193,6 @@ ejudge_client_get_contest_list_request(
 
 cleanup:
     free(resp_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     free(url_s);
     if (err_f) {
         fclose(err_f); err_f = NULL;
@@ -242,7 +217,6 @@ ejudge_client_enter_contest_request(
         long long current_time_us,
         struct EjContestSession *ecc) // output
 {
-    CURL *curl = NULL;
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
@@ -252,11 +226,6 @@ ejudge_client_enter_contest_request(
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -268,10 +237,10 @@ ejudge_client_enter_contest_request(
     {
         size_t post_z = 0;
         FILE *post_f = open_memstream(&post_s, &post_z);
-        char *s = curl_easy_escape(curl, esv->session_id, 0);
+        char *s = curl_easy_escape(NULL, esv->session_id, 0);
         fprintf(post_f, "SID=%s", s);
         free(s);
-        s = curl_easy_escape(curl, esv->client_key, 0);
+        s = curl_easy_escape(NULL, esv->client_key, 0);
         fprintf(post_f, "&EJSID=%s", s);
         free(s); s = NULL;
         fprintf(post_f, "&contest_id=%d", ecs->cnts_id);
@@ -282,16 +251,11 @@ ejudge_client_enter_contest_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_s);
-        curl_easy_setopt(curl, CURLOPT_POST, 1);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s, .post = post_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -322,9 +286,6 @@ cleanup:
     }
     free(err_s);
     free(post_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     return;
 
 failed:
@@ -348,17 +309,11 @@ ejudge_client_contest_info_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -366,8 +321,8 @@ ejudge_client_contest_info_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=contest-status-json&SID=%s&EJSID=%s&json=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)));
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)));
         free(s1);
         free(s2);
         fclose(url_f);
@@ -375,14 +330,11 @@ ejudge_client_contest_info_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -411,9 +363,6 @@ ejudge_client_contest_info_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) fclose(err_f);
     free(err_s);
     return;
@@ -440,17 +389,11 @@ ejudge_client_problem_info_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -458,8 +401,8 @@ ejudge_client_problem_info_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=problem-status-json&SID=%s&EJSID=%s&problem=%d&json=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 prob_id);
         free(s1);
         free(s2);
@@ -468,14 +411,11 @@ ejudge_client_problem_info_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -504,9 +444,6 @@ ejudge_client_problem_info_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -535,18 +472,12 @@ ejudge_client_problem_statement_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
     char *stmt_s = NULL;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -554,8 +485,8 @@ ejudge_client_problem_statement_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=problem-statement-json&SID=%s&EJSID=%s&problem=%d&json=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 prob_id);
         free(s1);
         free(s2);
@@ -563,15 +494,10 @@ ejudge_client_problem_statement_request(
     }
 
     {
-        size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
     }
     if (res != CURLE_OK) {
         fprintf(err_f, "request failed: %s\n", curl_easy_strerror(res));
@@ -611,9 +537,6 @@ ejudge_client_problem_statement_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -645,7 +568,6 @@ ejudge_client_submit_run_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     struct curl_httppost *post_head = NULL;
     struct curl_httppost *post_tail = NULL;
@@ -655,11 +577,6 @@ ejudge_client_submit_run_request(
 
     err_f = open_memstream(&err_s, &err_z);
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -704,15 +621,11 @@ ejudge_client_submit_run_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post_head);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s, .httppost = post_head };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -737,9 +650,6 @@ cleanup:
     free(resp_s);
     curl_formfree(post_head);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -768,17 +678,11 @@ ejudge_client_problem_runs_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -786,8 +690,8 @@ ejudge_client_problem_runs_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=list-runs-json&SID=%s&EJSID=%s&prob_id=%d&json=1&mode=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 prob_id);
         free(s1);
         free(s2);
@@ -796,14 +700,11 @@ ejudge_client_problem_runs_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -832,9 +733,6 @@ ejudge_client_problem_runs_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -863,17 +761,11 @@ ejudge_client_run_info_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -881,8 +773,8 @@ ejudge_client_run_info_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=run-status-json&SID=%s&EJSID=%s&run_id=%d&json=1&mode=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 run_id);
         free(s1);
         free(s2);
@@ -891,14 +783,11 @@ ejudge_client_run_info_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -910,7 +799,7 @@ ejudge_client_run_info_request(
     }
 
     //fprintf(stdout, ">%s<\n", resp_s);
-    eri->info_json_text = strdup(resp_s);
+    eri->info_json_text = arena_strdup(eri->arena, resp_s);
     eri->info_json_size = strlen(resp_s);
 
     if (ejudge_json_parse_run_info(err_f, resp_s, eri) < 0) {
@@ -927,9 +816,6 @@ ejudge_client_run_info_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -940,7 +826,7 @@ failed:
     if (err_f) {
         fclose(err_f); err_f = NULL;
     }
-    eri->log_s = err_s; err_s = NULL;
+    eri->log_s = arena_strdup(eri->arena, err_s);
     eri->recheck_time_us = current_time_us + EJFUSE_RETRY_TIME;
     contest_log_format(current_time_us, ecs, "run-status-json", 0, NULL);
     goto cleanup;
@@ -958,18 +844,12 @@ ejudge_client_run_source_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
     size_t resp_z = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -977,8 +857,8 @@ ejudge_client_run_source_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=download-run&SID=%s&EJSID=%s&run_id=%d&json=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 run_id);
         free(s1);
         free(s2);
@@ -986,14 +866,11 @@ ejudge_client_run_source_request(
     }
 
     {
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
     }
     if (res != CURLE_OK) {
         fprintf(err_f, "request failed: %s\n", curl_easy_strerror(res));
@@ -1016,9 +893,6 @@ ejudge_client_run_source_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -1047,17 +921,11 @@ ejudge_client_run_messages_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -1065,8 +933,8 @@ ejudge_client_run_messages_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=run-messages-json&SID=%s&EJSID=%s&run_id=%d&json=1&mode=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 run_id);
         free(s1);
         free(s2);
@@ -1075,14 +943,11 @@ ejudge_client_run_messages_request(
 
     {
         size_t resp_z = 0;
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
         if (strlen(resp_s) != resp_z) {
             fprintf(err_f, "server reply contains NUL byte\n");
             goto failed;
@@ -1111,9 +976,6 @@ ejudge_client_run_messages_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
@@ -1145,18 +1007,12 @@ ejudge_client_run_test_request(
     char *err_s = NULL;
     size_t err_z = 0;
     FILE *err_f = NULL;
-    CURL *curl = NULL;
     char *url_s = NULL;
     char *resp_s = NULL;
     size_t resp_z = 0;
     CURLcode res = 0;
 
     err_f = open_memstream(&err_s, &err_z);
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(err_f, "curl_easy_init failed\n");
-        goto failed;
-    }
 
     {
         size_t url_z = 0;
@@ -1164,8 +1020,8 @@ ejudge_client_run_test_request(
         char *s1, *s2;
         fprintf(url_f, "%sclient?action=run-test-json&SID=%s&EJSID=%s&run_id=%d&num=%d&index=%d&json=1&mode=1",
                 efs->url,
-                (s1 = curl_easy_escape(curl, esv->session_id, 0)),
-                (s2 = curl_easy_escape(curl, esv->client_key, 0)),
+                (s1 = curl_easy_escape(NULL, esv->session_id, 0)),
+                (s2 = curl_easy_escape(NULL, esv->client_key, 0)),
                 run_id, num, index);
         free(s1);
         free(s2);
@@ -1173,14 +1029,11 @@ ejudge_client_run_test_request(
     }
 
     {
-        FILE *resp_f = open_memstream(&resp_s, &resp_z);
-        curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
-        curl_easy_setopt(curl, CURLOPT_URL, url_s);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp_f);
-        res = curl_easy_perform(curl);
-        fclose(resp_f);
+        struct EjHttpRequest ehr = { .url = url_s };
+        http_engine_perform(efs->http_engine, &ehr);
+        res = ehr.result;
+        resp_s = ehr.resp_s;
+        resp_z = ehr.resp_z;
     }
     if (res != CURLE_OK) {
         fprintf(err_f, "request failed: %s\n", curl_easy_strerror(res));
@@ -1200,9 +1053,6 @@ ejudge_client_run_test_request(
 cleanup:
     free(resp_s);
     free(url_s);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
     if (err_f) {
         fclose(err_f);
     }
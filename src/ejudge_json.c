@@ -22,6 +22,7 @@
 #include "ejfuse.h"
 #include "cJSON.h"
 #include "base64.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -473,6 +474,7 @@ ejudge_json_parse_contest_info(
                 }
             }
         }
+        contest_info_build_index(eci);
     } else if (jok->type == cJSON_False) {
         fprintf(err_f, "request failed at server side: <%s>\n", resp_s);
         goto failed;
@@ -1034,6 +1036,7 @@ failed:
 static int
 parse_json_content(
         cJSON *content,
+        struct EjArena *ea,           // allocate from ea if not NULL
         unsigned char **p_data,
         size_t *p_size)
 {
@@ -1049,13 +1052,13 @@ parse_json_content(
 
     if (!b64_size) {
         if (jsize->valueint != 0) return -1;
-        *p_data = malloc(1);
+        *p_data = ea?arena_alloc(ea, 1):malloc(1);
         *p_size = 0;
         **p_data = 0;
         return 1;
     }
 
-    unsigned char *buf = malloc(b64_size + 1);
+    unsigned char *buf = ea?arena_alloc(ea, b64_size + 1):malloc(b64_size + 1);
     if (!buf) {
         return -1;
     }
@@ -1063,7 +1066,7 @@ parse_json_content(
     int err = 0;
     int outlen = base64_decode(jdata->valuestring, b64_size, buf, &err);
     if (err || outlen < 0 || outlen != jsize->valueint) {
-        free(buf);
+        if (!ea) free(buf);
         return -1;
     }
     *p_data = buf;
@@ -1215,7 +1218,7 @@ ejudge_json_parse_run_info(
       jj = cJSON_GetObjectItem(jrun, "src_sfx");
       if (jj) {
         if (jj->type != cJSON_String) goto invalid_json;
-        eri->src_sfx = strdup(jj->valuestring);
+        eri->src_sfx = arena_strdup(eri->arena, jj->valuestring);
       }
       jj = cJSON_GetObjectItem(jrun, "is_report_enabled");
       if (jj && jj->type == cJSON_True) {
@@ -1251,7 +1254,7 @@ ejudge_json_parse_run_info(
       jj = cJSON_GetObjectItem(jrun, "score_str");
       if (jj) {
         if (jj->type != cJSON_String) goto invalid_json;
-        eri->score_str = strdup(jj->valuestring);
+        eri->score_str = arena_strdup(eri->arena, jj->valuestring);
       }
       jj = cJSON_GetObjectItem(jrun, "is_compiler_output_available");
       if (jj && jj->type == cJSON_True) {
@@ -1270,7 +1273,7 @@ ejudge_json_parse_run_info(
       cJSON *jco = cJSON_GetObjectItem(jresult, "compiler_output");
       if (jco) {
           if (jco->type != cJSON_Object) goto invalid_json;
-          if (parse_json_content(cJSON_GetObjectItem(jco, "content"), &eri->compiler_text, &eri->compiler_size) < 0) goto invalid_json;
+          if (parse_json_content(cJSON_GetObjectItem(jco, "content"), eri->arena, &eri->compiler_text, &eri->compiler_size) < 0) goto invalid_json;
       }
 
       cJSON *jtr = cJSON_GetObjectItem(jresult, "testing_report");
@@ -1280,7 +1283,7 @@ ejudge_json_parse_run_info(
           jj = cJSON_GetObjectItem(jtr, "valuer_comment");
           if (jj) {
               if (jj->type != cJSON_Object) goto invalid_json;
-              if (parse_json_content(cJSON_GetObjectItem(jj, "content"), &eri->valuer_text, &eri->valuer_size) < 0) goto invalid_json;
+              if (parse_json_content(cJSON_GetObjectItem(jj, "content"), eri->arena, &eri->valuer_text, &eri->valuer_size) < 0) goto invalid_json;
           }
 
           cJSON *jtests = cJSON_GetObjectItem(jtr, "tests");
@@ -1288,7 +1291,7 @@ ejudge_json_parse_run_info(
               if (jtests->type != cJSON_Array) goto invalid_json;
               int count = cJSON_GetArraySize(jtests);
               eri->test_count = count;
-              eri->tests = calloc(count, sizeof(eri->tests[0]));
+              eri->tests = arena_calloc(eri->arena, count, sizeof(eri->tests[0]));
               if (!eri->tests) goto invalid_json;
               for (int i = 0; i < count; ++i) {
                   cJSON *jtest = cJSON_GetArrayItem(jtests, i);
@@ -1415,7 +1418,7 @@ ejudge_json_parse_run_messages(
                     jj = cJSON_GetObjectItem(jm, "subject");
                     if (!jj || jj->type != cJSON_String) goto invalid_json;
                     erm->subject = strdup(jj->valuestring);
-                    if (parse_json_content(cJSON_GetObjectItem(jj, "content"), &erm->data, &erm->size) < 0) goto invalid_json;
+                    if (parse_json_content(cJSON_GetObjectItem(jj, "content"), NULL, &erm->data, &erm->size) < 0) goto invalid_json;
                 }
             }
         }
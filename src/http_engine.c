@@ -0,0 +1,490 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "http_engine.h"
+#include "curl_pool.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+enum { HTTP_ENGINE_MAX_EVENTS = 64 };
+
+struct EjHttpEngine
+{
+    pthread_t id;
+    _Bool started;           // the I/O thread must be joined
+    _Bool running;           // requests are queued, protected by qm
+
+    struct EjCurlPool *curl_pool;
+    int max_inflight;
+
+    CURLM *multi;
+    int epfd;
+    int wakefd;
+    long long deadline_us;   // curl timer, -1 if not set
+
+    _Atomic _Bool stop_request;
+
+    // submitted, but not yet seen by the I/O thread
+    pthread_mutex_t qm;
+    struct EjHttpRequest *qfirst, *qlast;
+
+    // owned by the I/O thread
+    struct EjHttpRequest *pfirst, *plast; // waiting for an in-flight slot
+    struct EjHttpRequest *active;         // in flight, linked through next
+    int inflight;
+};
+
+// used by http_engine_perform
+struct EjHttpWait
+{
+    pthread_mutex_t m;
+    pthread_cond_t c;
+    int done;
+};
+
+static long long
+get_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static int
+socket_func(CURL *curl, curl_socket_t s, int what, void *userp, void *socketp)
+{
+    struct EjHttpEngine *ehe = (struct EjHttpEngine *) userp;
+
+    if (what == CURL_POLL_REMOVE) {
+        if (socketp) {
+            epoll_ctl(ehe->epfd, EPOLL_CTL_DEL, s, NULL);
+            curl_multi_assign(ehe->multi, s, NULL);
+        }
+        return 0;
+    }
+
+    struct epoll_event ev = {};
+    if ((what & CURL_POLL_IN)) ev.events |= EPOLLIN;
+    if ((what & CURL_POLL_OUT)) ev.events |= EPOLLOUT;
+    ev.data.fd = s;
+    if (socketp) {
+        epoll_ctl(ehe->epfd, EPOLL_CTL_MOD, s, &ev);
+    } else {
+        epoll_ctl(ehe->epfd, EPOLL_CTL_ADD, s, &ev);
+        // any non-NULL pointer marks the socket as registered
+        curl_multi_assign(ehe->multi, s, ehe);
+    }
+    return 0;
+}
+
+static int
+timer_func(CURLM *multi, long timeout_ms, void *userp)
+{
+    struct EjHttpEngine *ehe = (struct EjHttpEngine *) userp;
+    if (timeout_ms < 0) {
+        ehe->deadline_us = -1;
+    } else {
+        ehe->deadline_us = get_time_us() + timeout_ms * 1000LL;
+    }
+    return 0;
+}
+
+struct EjHttpEngine *
+http_engine_create(struct EjCurlPool *curl_pool, int max_inflight)
+{
+    struct EjHttpEngine *ehe = calloc(1, sizeof(*ehe));
+    ehe->curl_pool = curl_pool;
+    ehe->max_inflight = max_inflight;
+    if (ehe->max_inflight <= 0) ehe->max_inflight = 1;
+    ehe->deadline_us = -1;
+    ehe->epfd = -1;
+    ehe->wakefd = -1;
+    pthread_mutex_init(&ehe->qm, NULL);
+
+    ehe->multi = curl_multi_init();
+    curl_multi_setopt(ehe->multi, CURLMOPT_SOCKETFUNCTION, socket_func);
+    curl_multi_setopt(ehe->multi, CURLMOPT_SOCKETDATA, ehe);
+    curl_multi_setopt(ehe->multi, CURLMOPT_TIMERFUNCTION, timer_func);
+    curl_multi_setopt(ehe->multi, CURLMOPT_TIMERDATA, ehe);
+    curl_multi_setopt(ehe->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long) ehe->max_inflight);
+
+    return ehe;
+}
+
+void
+http_engine_free(struct EjHttpEngine *ehe)
+{
+    if (ehe) {
+        http_engine_stop(ehe);
+        curl_multi_cleanup(ehe->multi);
+        pthread_mutex_destroy(&ehe->qm);
+        free(ehe);
+    }
+}
+
+static void
+setup_request(struct EjHttpRequest *ehr, CURL *curl)
+{
+    curl_easy_setopt(curl, CURLOPT_AUTOREFERER, 1);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1);
+    curl_easy_setopt(curl, CURLOPT_URL, ehr->url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, ehr->resp_f);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, ehr);
+    if (ehr->httppost) {
+        curl_easy_setopt(curl, CURLOPT_HTTPPOST, ehr->httppost);
+    } else if (ehr->post) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, ehr->post);
+        curl_easy_setopt(curl, CURLOPT_POST, 1);
+    }
+}
+
+static void
+finish_request(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr, CURLcode result)
+{
+    ehr->result = result;
+    if (ehr->curl) {
+        curl_easy_getinfo(ehr->curl, CURLINFO_RESPONSE_CODE, &ehr->http_code);
+        curl_pool_release(ehe->curl_pool, ehr->curl);
+        ehr->curl = NULL;
+    }
+    if (ehr->resp_f) {
+        fclose(ehr->resp_f);
+        ehr->resp_f = NULL;
+    }
+    ehr->next = NULL;
+    if (ehr->callback) {
+        ehr->callback(ehr);
+    }
+}
+
+// synchronous execution on the calling thread
+static void
+perform_inline(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr)
+{
+    ehr->resp_f = open_memstream(&ehr->resp_s, &ehr->resp_z);
+    if (!(ehr->curl = curl_pool_acquire(ehe->curl_pool))) {
+        finish_request(ehe, ehr, CURLE_FAILED_INIT);
+        return;
+    }
+    setup_request(ehr, ehr->curl);
+    finish_request(ehe, ehr, curl_easy_perform(ehr->curl));
+}
+
+// I/O thread: start the request or put it in the waiting list
+static void
+start_request(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr)
+{
+    if (ehe->inflight >= ehe->max_inflight) {
+        ehr->next = NULL;
+        if (ehe->plast) {
+            ehe->plast->next = ehr;
+        } else {
+            ehe->pfirst = ehr;
+        }
+        ehe->plast = ehr;
+        return;
+    }
+
+    if (!(ehr->curl = curl_pool_acquire(ehe->curl_pool))) {
+        finish_request(ehe, ehr, CURLE_FAILED_INIT);
+        return;
+    }
+    setup_request(ehr, ehr->curl);
+    if (curl_multi_add_handle(ehe->multi, ehr->curl) != CURLM_OK) {
+        finish_request(ehe, ehr, CURLE_FAILED_INIT);
+        return;
+    }
+    ehr->next = ehe->active;
+    ehe->active = ehr;
+    ++ehe->inflight;
+}
+
+static void
+start_waiting(struct EjHttpEngine *ehe)
+{
+    while (ehe->pfirst && ehe->inflight < ehe->max_inflight) {
+        struct EjHttpRequest *ehr = ehe->pfirst;
+        if (!(ehe->pfirst = ehr->next)) {
+            ehe->plast = NULL;
+        }
+        start_request(ehe, ehr);
+    }
+}
+
+static void
+read_queue(struct EjHttpEngine *ehe)
+{
+    uint64_t val;
+    if (read(ehe->wakefd, &val, sizeof(val)) < 0) {
+        // EAGAIN, nothing to read
+    }
+
+    pthread_mutex_lock(&ehe->qm);
+    struct EjHttpRequest *first = ehe->qfirst;
+    ehe->qfirst = ehe->qlast = NULL;
+    pthread_mutex_unlock(&ehe->qm);
+
+    while (first) {
+        struct EjHttpRequest *ehr = first;
+        first = ehr->next;
+        ehr->next = NULL;
+        start_request(ehe, ehr);
+    }
+}
+
+static void
+check_multi_info(struct EjHttpEngine *ehe)
+{
+    CURLMsg *msg;
+    int left = 0;
+
+    while ((msg = curl_multi_info_read(ehe->multi, &left))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        CURL *curl = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        struct EjHttpRequest *ehr = NULL;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **) &ehr);
+        curl_multi_remove_handle(ehe->multi, curl);
+        // the in-flight list is bounded by max_inflight
+        struct EjHttpRequest **pp = &ehe->active;
+        while (*pp && *pp != ehr) pp = &(*pp)->next;
+        if (*pp) *pp = ehr->next;
+        --ehe->inflight;
+        finish_request(ehe, ehr, result);
+    }
+    start_waiting(ehe);
+}
+
+// abort everything on the engine shutdown
+static void
+abort_requests(struct EjHttpEngine *ehe)
+{
+    while (ehe->active) {
+        struct EjHttpRequest *ehr = ehe->active;
+        ehe->active = ehr->next;
+        curl_multi_remove_handle(ehe->multi, ehr->curl);
+        --ehe->inflight;
+        finish_request(ehe, ehr, CURLE_ABORTED_BY_CALLBACK);
+    }
+    while (ehe->pfirst) {
+        struct EjHttpRequest *ehr = ehe->pfirst;
+        ehe->pfirst = ehr->next;
+        finish_request(ehe, ehr, CURLE_ABORTED_BY_CALLBACK);
+    }
+    ehe->plast = NULL;
+}
+
+// stop queueing, new requests are performed inline by the submitters
+static void
+abort_queue(struct EjHttpEngine *ehe)
+{
+    pthread_mutex_lock(&ehe->qm);
+    ehe->running = 0;
+    // requests queued but not seen by the I/O thread
+    struct EjHttpRequest *first = ehe->qfirst;
+    ehe->qfirst = ehe->qlast = NULL;
+    pthread_mutex_unlock(&ehe->qm);
+
+    while (first) {
+        struct EjHttpRequest *ehr = first;
+        first = ehr->next;
+        finish_request(ehe, ehr, CURLE_ABORTED_BY_CALLBACK);
+    }
+}
+
+static void *
+thread_func(void *arg)
+{
+    struct EjHttpEngine *ehe = (struct EjHttpEngine *) arg;
+    struct epoll_event events[HTTP_ENGINE_MAX_EVENTS];
+    int running_handles = 0;
+
+    pthread_setname_np(pthread_self(), "HTTP_THREAD");
+
+    while (!atomic_load_explicit(&ehe->stop_request, memory_order_acquire)) {
+        int timeout_ms = -1;
+        if (ehe->deadline_us >= 0) {
+            long long diff_us = ehe->deadline_us - get_time_us();
+            if (diff_us <= 0) {
+                timeout_ms = 0;
+            } else {
+                timeout_ms = (int) ((diff_us + 999) / 1000);
+            }
+        }
+
+        int n = epoll_wait(ehe->epfd, events, HTTP_ENGINE_MAX_EVENTS, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            fprintf(stderr, "HTTP engine failed, using synchronous requests\n");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == ehe->wakefd) {
+                read_queue(ehe);
+                continue;
+            }
+            int flags = 0;
+            if ((events[i].events & EPOLLIN)) flags |= CURL_CSELECT_IN;
+            if ((events[i].events & EPOLLOUT)) flags |= CURL_CSELECT_OUT;
+            if ((events[i].events & (EPOLLERR | EPOLLHUP))) flags |= CURL_CSELECT_ERR;
+            curl_multi_socket_action(ehe->multi, fd, flags, &running_handles);
+        }
+        if (ehe->deadline_us >= 0 && get_time_us() >= ehe->deadline_us) {
+            ehe->deadline_us = -1;
+            curl_multi_socket_action(ehe->multi, CURL_SOCKET_TIMEOUT, 0, &running_handles);
+        }
+        check_multi_info(ehe);
+    }
+
+    // also on a failure, so that the engine does not accept requests any more
+    abort_queue(ehe);
+    abort_requests(ehe);
+    return NULL;
+}
+
+int
+http_engine_start(struct EjHttpEngine *ehe)
+{
+    pthread_attr_t pa;
+
+    if (ehe->started) return 0;
+
+    if ((ehe->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        return -errno;
+    }
+    if ((ehe->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        int err = errno;
+        close(ehe->epfd); ehe->epfd = -1;
+        return -err;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = ehe->wakefd };
+    epoll_ctl(ehe->epfd, EPOLL_CTL_ADD, ehe->wakefd, &ev);
+    atomic_store_explicit(&ehe->stop_request, 0, memory_order_relaxed);
+
+    // set before the thread starts, so that its failure is not overwritten
+    pthread_mutex_lock(&ehe->qm);
+    ehe->running = 1;
+    pthread_mutex_unlock(&ehe->qm);
+
+    pthread_attr_init(&pa);
+    pthread_attr_setstacksize(&pa, 1024 * 1024);
+    int res = pthread_create(&ehe->id, &pa, thread_func, ehe);
+    pthread_attr_destroy(&pa);
+    if (res) {
+        abort_queue(ehe);
+        close(ehe->wakefd); ehe->wakefd = -1;
+        close(ehe->epfd); ehe->epfd = -1;
+        return -res;
+    }
+
+    ehe->started = 1;
+    return 0;
+}
+
+void
+http_engine_stop(struct EjHttpEngine *ehe)
+{
+    if (!ehe->started) return;
+
+    // the I/O thread aborts the queued and the in-flight requests on exit
+    atomic_store_explicit(&ehe->stop_request, 1, memory_order_release);
+    uint64_t val = 1;
+    if (write(ehe->wakefd, &val, sizeof(val)) < 0) {
+        // the counter is saturated, the thread is awake anyway
+    }
+    pthread_join(ehe->id, NULL);
+    ehe->started = 0;
+
+    close(ehe->wakefd); ehe->wakefd = -1;
+    close(ehe->epfd); ehe->epfd = -1;
+    ehe->deadline_us = -1;
+}
+
+void
+http_engine_submit(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr)
+{
+    ehr->next = NULL;
+    ehr->curl = NULL;
+    ehr->result = CURLE_OK;
+    ehr->http_code = 0;
+    ehr->resp_s = NULL;
+    ehr->resp_z = 0;
+
+    pthread_mutex_lock(&ehe->qm);
+    if (!ehe->running) {
+        pthread_mutex_unlock(&ehe->qm);
+        perform_inline(ehe, ehr);
+        return;
+    }
+    // the memory stream is written by the I/O thread only
+    ehr->resp_f = open_memstream(&ehr->resp_s, &ehr->resp_z);
+    if (ehe->qlast) {
+        ehe->qlast->next = ehr;
+    } else {
+        ehe->qfirst = ehr;
+    }
+    ehe->qlast = ehr;
+    pthread_mutex_unlock(&ehe->qm);
+
+    uint64_t val = 1;
+    if (write(ehe->wakefd, &val, sizeof(val)) < 0) {
+        // the counter is saturated, the thread is awake anyway
+    }
+}
+
+static void
+perform_callback(struct EjHttpRequest *ehr)
+{
+    struct EjHttpWait *ehw = (struct EjHttpWait *) ehr->user;
+    pthread_mutex_lock(&ehw->m);
+    ehw->done = 1;
+    pthread_cond_signal(&ehw->c);
+    pthread_mutex_unlock(&ehw->m);
+}
+
+void
+http_engine_perform(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr)
+{
+    struct EjHttpWait ehw = {};
+    pthread_mutex_init(&ehw.m, NULL);
+    pthread_cond_init(&ehw.c, NULL);
+
+    ehr->callback = perform_callback;
+    ehr->user = &ehw;
+    http_engine_submit(ehe, ehr);
+
+    pthread_mutex_lock(&ehw.m);
+    while (!ehw.done) {
+        pthread_cond_wait(&ehw.c, &ehw.m);
+    }
+    pthread_mutex_unlock(&ehw.m);
+
+    pthread_cond_destroy(&ehw.c);
+    pthread_mutex_destroy(&ehw.m);
+}
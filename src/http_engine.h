@@ -0,0 +1,74 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <curl/curl.h>
+
+/*
+ * Asynchronous HTTP engine: a dedicated I/O thread drives a curl_multi
+ * handle through epoll and curl_multi_socket_action. Requests are queued
+ * by any thread and completed by a callback invoked on the I/O thread.
+ * At most max_inflight requests are running at a time, the rest wait
+ * in the engine queue in the submission order. The ejudge client still
+ * blocks the calling thread in http_engine_perform, the engine only
+ * multiplexes the requests of all threads on one set of connections.
+ * If the I/O thread fails, requests are performed on the calling thread.
+ */
+
+struct EjCurlPool;
+struct EjHttpEngine;
+struct EjHttpRequest;
+
+typedef void (*ej_http_callback_t)(struct EjHttpRequest *ehr);
+
+struct EjHttpRequest
+{
+    // request description, must remain valid until completion
+    const unsigned char *url;
+    const unsigned char *post;          // POST fields, GET if NULL
+    struct curl_httppost *httppost;     // multipart POST, if not NULL
+
+    // completion callback, called on the I/O thread
+    ej_http_callback_t callback;
+    void *user;
+
+    // the result
+    CURLcode result;
+    long http_code;
+    char *resp_s;    // always allocated, the submitter must free it
+    size_t resp_z;
+
+    // private to the engine
+    struct EjHttpRequest *next;
+    CURL *curl;
+    FILE *resp_f;
+};
+
+struct EjHttpEngine *http_engine_create(struct EjCurlPool *curl_pool, int max_inflight);
+void http_engine_free(struct EjHttpEngine *ehe);
+
+int http_engine_start(struct EjHttpEngine *ehe);
+void http_engine_stop(struct EjHttpEngine *ehe);
+
+// queue a request, if the engine is not running, perform it immediately
+void http_engine_submit(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr);
+// submit a request and wait for its completion, callback must be NULL
+void http_engine_perform(struct EjHttpEngine *ehe, struct EjHttpRequest *ehr);
@@ -20,6 +20,7 @@
 #include "ejfuse.h"
 #include "contests_state.h"
 #include "ejudge.h"
+#include "arena.h"
 
 #include <string.h>
 #include <stdarg.h>
@@ -781,8 +782,9 @@ ejfuse_run_info_text(struct EjRunInfo *eri, struct EjContestState *ecs)
 
     kvv_generate(&kvv, text_f);
     fclose(text_f);
-    eri->info_text = text_s;
+    eri->info_text = arena_memdup(eri->arena, text_s, text_z + 1);
     eri->info_size = text_z;
+    free(text_s);
 }
 
 void
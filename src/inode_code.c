@@ -0,0 +1,165 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inode_code.h"
+#include "contests_state.h"
+#include "inode_hash.h"
+
+#include <openssl/sha.h>
+#include <pthread.h>
+#include <string.h>
+#include <limits.h>
+
+_Static_assert(INODE_KIND_TEST_PART + TESTING_REPORT_LAST <= INODE_KIND_FNODE, "too many test parts");
+_Static_assert(INODE_KIND_WIDE < 32, "too many inode kinds");
+
+// ids that do not fit the inode fields, never freed
+static struct EjInodeHash *wide_hash;
+static pthread_once_t wide_hash_once = PTHREAD_ONCE_INIT;
+
+static void
+wide_hash_init(void)
+{
+    wide_hash = inode_hash_create();
+}
+
+unsigned long long
+inode_code_make_wide(int kind, int cnts_id, int id, int num)
+{
+    pthread_once(&wide_hash_once, wide_hash_init);
+
+    int key[4] = { kind, cnts_id, id, num };
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char *) key, sizeof(key), digest);
+
+    return inode_code_make_serial(INODE_KIND_WIDE, inode_hash_insert(wide_hash, digest));
+}
+
+static int
+parse_id(const unsigned char **pp, int *p_val)
+{
+    const unsigned char *p = *pp;
+    if (*p != '/') return -1;
+    ++p;
+    if (*p < '0' || *p > '9') return -1;
+    long long val = 0;
+    while (*p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        if (val > INT_MAX) return -1;
+        ++p;
+    }
+    if (*p && *p != '/') return -1;
+    *pp = p;
+    *p_val = (int) val;
+    return 0;
+}
+
+/* matches "/name" followed by the end of the path or '/' */
+static int
+match_name(const unsigned char **pp, const unsigned char *name)
+{
+    const unsigned char *p = *pp;
+    if (*p != '/') return 0;
+    ++p;
+    size_t len = strlen(name);
+    if (strncmp(p, name, len) != 0) return 0;
+    p += len;
+    if (*p && *p != '/') return 0;
+    *pp = p;
+    return 1;
+}
+
+static unsigned long long
+make_leaf(const unsigned char *p, int kind, int cnts_id, int id, int num)
+{
+    if (*p) return 0;
+    return inode_code_make(kind, cnts_id, id, num);
+}
+
+static unsigned long long
+from_run_path(const unsigned char *p, int cnts_id, int run_id)
+{
+    if (!*p) return inode_code_make(INODE_KIND_RUN, cnts_id, run_id, 0);
+    if (match_name(&p, "INFO")) return make_leaf(p, INODE_KIND_RUN_INFO, cnts_id, run_id, 0);
+    if (match_name(&p, "info.json")) return make_leaf(p, INODE_KIND_RUN_INFO_JSON, cnts_id, run_id, 0);
+    if (match_name(&p, "compiler.txt")) return make_leaf(p, INODE_KIND_RUN_COMPILER, cnts_id, run_id, 0);
+    if (match_name(&p, "valuer.txt")) return make_leaf(p, INODE_KIND_RUN_VALUER, cnts_id, run_id, 0);
+    if (match_name(&p, "messages.txt")) return make_leaf(p, INODE_KIND_RUN_MESSAGES, cnts_id, run_id, 0);
+    if (!strcmp(p, "/source") || !strncmp(p, "/source.", 8)) {
+        if (strchr(p + 1, '/')) return 0;
+        return inode_code_make(INODE_KIND_RUN_SOURCE, cnts_id, run_id, 0);
+    }
+    if (!match_name(&p, "tests")) return 0;
+    if (!*p) return inode_code_make(INODE_KIND_TESTS, cnts_id, run_id, 0);
+    int num;
+    if (parse_id(&p, &num) < 0) return 0;
+    if (!*p) return inode_code_make(INODE_KIND_TEST, cnts_id, run_id, num);
+    for (int i = 0; i < TESTING_REPORT_LAST; ++i) {
+        if (match_name(&p, testing_info_unparse(i))) {
+            return make_leaf(p, INODE_KIND_TEST_PART + i, cnts_id, run_id, num);
+        }
+    }
+    return 0;
+}
+
+static unsigned long long
+from_problem_path(const unsigned char *p, int cnts_id, int prob_id)
+{
+    if (!*p) return inode_code_make(INODE_KIND_PROBLEM, cnts_id, prob_id, 0);
+    if (match_name(&p, "INFO")) return make_leaf(p, INODE_KIND_PROBLEM_INFO, cnts_id, prob_id, 0);
+    if (match_name(&p, "info.json")) return make_leaf(p, INODE_KIND_PROBLEM_INFO_JSON, cnts_id, prob_id, 0);
+    if (match_name(&p, "statement.html")) return make_leaf(p, INODE_KIND_PROBLEM_STATEMENT, cnts_id, prob_id, 0);
+    if (match_name(&p, "submit")) {
+        if (!*p) return inode_code_make(INODE_KIND_SUBMIT, cnts_id, prob_id, 0);
+        int lang_id;
+        if (parse_id(&p, &lang_id) < 0 || *p) return 0;
+        return inode_code_make(INODE_KIND_SUBMIT_COMP, cnts_id, prob_id, lang_id);
+    }
+    if (match_name(&p, "runs")) {
+        if (!*p) return inode_code_make(INODE_KIND_RUNS, cnts_id, prob_id, 0);
+        // a run belongs to exactly one problem, so the problem id is not encoded
+        int run_id;
+        if (parse_id(&p, &run_id) < 0) return 0;
+        return from_run_path(p, cnts_id, run_id);
+    }
+    return 0;
+}
+
+unsigned long long
+inode_code_from_path(const unsigned char *path)
+{
+    const unsigned char *p = path;
+    if (!strcmp(p, "/")) return inode_code_make(INODE_KIND_ROOT, 0, 0, 0);
+    if (match_name(&p, "fnode")) {
+        int fnode;
+        if (parse_id(&p, &fnode) < 0 || *p) return 0;
+        return inode_code_make_serial(INODE_KIND_FNODE, fnode);
+    }
+    int cnts_id;
+    if (parse_id(&p, &cnts_id) < 0) return 0;
+    if (!*p) return inode_code_make(INODE_KIND_CONTEST, cnts_id, 0, 0);
+    if (match_name(&p, "INFO")) return make_leaf(p, INODE_KIND_CONTEST_INFO, cnts_id, 0, 0);
+    if (match_name(&p, "info.json")) return make_leaf(p, INODE_KIND_CONTEST_INFO_JSON, cnts_id, 0, 0);
+    if (match_name(&p, "LOG")) return make_leaf(p, INODE_KIND_CONTEST_LOG, cnts_id, 0, 0);
+    if (!match_name(&p, "problems")) return 0;
+    if (!*p) return inode_code_make(INODE_KIND_PROBLEMS, cnts_id, 0, 0);
+    int prob_id;
+    if (parse_id(&p, &prob_id) < 0) return 0;
+    return from_problem_path(p, cnts_id, prob_id);
+}
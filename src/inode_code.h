@@ -0,0 +1,107 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Inode numbers of the filesystem nodes are computed from the node kind
+ * and the ids of the objects along the path, so no hashing and no lookup
+ * table is needed. The layout of the 64-bit inode number is:
+ *   bits 63..59 - node kind (INODE_KIND_*)
+ *   bits 58..39 - contest id
+ *   bits 38..15 - problem id (problem level nodes) or run id (run level nodes)
+ *   bits 14..0  - compiler id (submit directories) or test number
+ * fnode and hashed inodes keep the node kind and use the remaining 59 bits
+ * for the fnode id or the inode_hash serial number.
+ * Nodes with ids wider than their field (or negative) get an INODE_KIND_WIDE
+ * inode, a serial number assigned by a hash table of (kind, ids) tuples.
+ */
+
+enum
+{
+    INODE_KIND_NONE = 0,
+    INODE_KIND_ROOT,
+    INODE_KIND_CONTEST,
+    INODE_KIND_CONTEST_INFO,
+    INODE_KIND_CONTEST_INFO_JSON,
+    INODE_KIND_CONTEST_LOG,
+    INODE_KIND_PROBLEMS,
+    INODE_KIND_PROBLEM,
+    INODE_KIND_PROBLEM_INFO,
+    INODE_KIND_PROBLEM_INFO_JSON,
+    INODE_KIND_PROBLEM_STATEMENT,
+    INODE_KIND_RUNS,
+    INODE_KIND_SUBMIT,
+    INODE_KIND_SUBMIT_COMP,
+    INODE_KIND_RUN,
+    INODE_KIND_RUN_INFO,
+    INODE_KIND_RUN_INFO_JSON,
+    INODE_KIND_RUN_COMPILER,
+    INODE_KIND_RUN_VALUER,
+    INODE_KIND_RUN_SOURCE,
+    INODE_KIND_RUN_MESSAGES,
+    INODE_KIND_TESTS,
+    INODE_KIND_TEST,
+    INODE_KIND_TEST_PART,       // + TESTING_REPORT_* index
+    INODE_KIND_FNODE = INODE_KIND_TEST_PART + 6,
+    INODE_KIND_HASHED,
+    INODE_KIND_WIDE,
+
+    INODE_KIND_SHIFT = 59,
+    INODE_CNTS_SHIFT = 39,
+    INODE_CNTS_BITS = 20,
+    INODE_ID_SHIFT = 15,
+    INODE_ID_BITS = 24,
+    INODE_NUM_BITS = 15,
+};
+
+static inline int
+inode_code_fits(int cnts_id, int id, int num)
+{
+    return (unsigned) cnts_id < (1U << INODE_CNTS_BITS)
+        && (unsigned) id < (1U << INODE_ID_BITS)
+        && (unsigned) num < (1U << INODE_NUM_BITS);
+}
+
+unsigned long long inode_code_make_wide(int kind, int cnts_id, int id, int num);
+
+static inline unsigned long long
+inode_code_make(int kind, int cnts_id, int id, int num)
+{
+    if (!inode_code_fits(cnts_id, id, num)) return inode_code_make_wide(kind, cnts_id, id, num);
+    return ((unsigned long long) kind << INODE_KIND_SHIFT)
+        | ((unsigned long long) cnts_id << INODE_CNTS_SHIFT)
+        | ((unsigned long long) id << INODE_ID_SHIFT)
+        | (unsigned long long) num;
+}
+
+static inline unsigned long long
+inode_code_make_serial(int kind, unsigned long long serial)
+{
+    return ((unsigned long long) kind << INODE_KIND_SHIFT) | (serial & ((1ULL << INODE_KIND_SHIFT) - 1));
+}
+
+static inline int
+inode_code_kind(unsigned long long inode)
+{
+    return (int) (inode >> INODE_KIND_SHIFT);
+}
+
+/* returns 0 if the path is not a canonical structured path */
+unsigned long long inode_code_from_path(const unsigned char *path);
@@ -18,228 +18,255 @@
  */
 
 #include "inode_hash.h"
+#include "ebr.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include <pthread.h>
 
 #include <openssl/sha.h>
 
-enum { HASH_TABLE_OFFSET = 5 };
+#define INODE_TOMBSTONE (~0U)
 
-struct EjInodeHash
+enum
 {
-    struct EjInodeHashEntry *entries;
-    pthread_rwlock_t rwl;
-    int serial;
-    int size;
-    int used;
-    int size_idx;
+    INODE_HASH_SHARD_BITS = 6,
+    INODE_HASH_SHARDS = 1 << INODE_HASH_SHARD_BITS,
+    INODE_HASH_INITIAL_SIZE = 256,   // per shard, power of 2
+    INODE_HASH_MIGRATE_STEP = 32,    // old table slots moved on each insert
 };
 
-static const int primes[] =
-{
-    4099,
-    8209,
-    16411,
-    32771,
-    65537,
-    131101,
-    262147,
-    524309,
-    1048583,
-    2097169,
-    4194319,
-    8388617,
-    16777259,
-  0,
+struct EjInodeHashEntry
+{
+    _Atomic unsigned inode;          // 0 - empty, INODE_TOMBSTONE - deleted
+    unsigned char digest[SHA256_DIGEST_LENGTH];
 };
 
-struct EjInodeHash *
-inode_hash_create(void)
+struct EjInodeTable
 {
-    struct EjInodeHash *ejh = calloc(1, sizeof(*ejh));
-    ejh->size = primes[ejh->size_idx++];
-    ejh->serial = 1;
-    pthread_rwlock_init(&ejh->rwl, NULL);
-    ejh->entries = calloc(ejh->size, sizeof(ejh->entries[0]));
-    return ejh;
-}
+    size_t size;
+    size_t used;                     // live entries and tombstones
+    struct EjInodeHashEntry entries[];
+};
 
-void
-inode_hash_free(struct EjInodeHash *ejh)
+/*
+ * Readers load cur and old inside an EBR read section, a table unlinked
+ * after migration is retired to EBR, so lookups write only the reader
+ * record of their own thread and share no cache line with each other.
+ * Published entries never change their digest and tombstones are not
+ * reused, so readers may compare digests without locking.
+ */
+struct EjInodeShard
 {
-    if (ejh) {
-        free(ejh->entries);
-        pthread_rwlock_destroy(&ejh->rwl);
-        free(ejh);
-    }
+    struct EjInodeTable *_Atomic cur;
+    struct EjInodeTable *_Atomic old; // being migrated to cur
+    pthread_mutex_t m;
+    size_t live;
+    size_t migrate_pos;
+} __attribute__((aligned(64)));
+
+struct EjInodeHash
+{
+    struct EjInodeShard shards[INODE_HASH_SHARDS];
+    _Atomic unsigned serial;
+};
+
+static struct EjInodeTable *
+table_create(size_t size)
+{
+    struct EjInodeTable *t = calloc(1, sizeof(*t) + size * sizeof(t->entries[0]));
+    if (!t) abort();
+    t->size = size;
+    return t;
 }
 
-struct EjInodeHashEntry *
-inode_hash_find(struct EjInodeHash *ejh, const unsigned char *digest)
+static size_t
+digest_hash(const unsigned char *digest)
 {
     unsigned long long val;
     memcpy(&val, digest, sizeof(val));
-    struct EjInodeHashEntry *retval = NULL;
+    return (size_t) val;
+}
 
-    pthread_rwlock_rdlock(&ejh->rwl);
-    int i = (int)(val % ejh->size);
-    while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[i];
-        if (!entry->inode) {
-            // not found
+static struct EjInodeShard *
+digest_shard(struct EjInodeHash *ejh, const unsigned char *digest)
+{
+    return &ejh->shards[digest[sizeof(unsigned long long)] & (INODE_HASH_SHARDS - 1)];
+}
+
+static struct EjInodeHashEntry *
+table_lookup(struct EjInodeTable *t, const unsigned char *digest, unsigned *p_inode)
+{
+    size_t mask = t->size - 1;
+    size_t i = digest_hash(digest) & mask;
+    for (size_t n = 0; n < t->size; ++n, i = (i + 1) & mask) {
+        struct EjInodeHashEntry *entry = &t->entries[i];
+        unsigned inode = atomic_load_explicit(&entry->inode, memory_order_acquire);
+        if (!inode) {
             break;
         }
-        if (!memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
-            retval = entry;
-            break;
+        // a deleted digest may be inserted again further in the chain
+        if (inode != INODE_TOMBSTONE && !memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
+            *p_inode = inode;
+            return entry;
         }
-        i = (i + HASH_TABLE_OFFSET) % ejh->size;
     }
-    pthread_rwlock_unlock(&ejh->rwl);
-    return retval;
+    return NULL;
 }
 
-struct EjInodeHashEntry *
-inode_hash_insert(struct EjInodeHash *ejh, const unsigned char *digest)
+// the shard mutex must be held, the table must have a free slot
+static void
+table_put(struct EjInodeTable *t, const unsigned char *digest, unsigned inode)
 {
-    unsigned long long val;
-    memcpy(&val, digest, sizeof(val));
-    struct EjInodeHashEntry *retval = NULL;
+    size_t mask = t->size - 1;
+    size_t i = digest_hash(digest) & mask;
+    while (atomic_load_explicit(&t->entries[i].inode, memory_order_relaxed)) {
+        i = (i + 1) & mask;
+    }
+    struct EjInodeHashEntry *entry = &t->entries[i];
+    memcpy(entry->digest, digest, SHA256_DIGEST_LENGTH);
+    atomic_store_explicit(&entry->inode, inode, memory_order_release);
+    ++t->used;
+}
 
-    pthread_rwlock_rdlock(&ejh->rwl);
-    int i = (int)(val % ejh->size);
+/*
+ * A live entry is always in cur or old, but the migration may finish
+ * (old is unlinked) or a new grow may start between the two lookups,
+ * so the lookup is repeated until both pointers are observed unchanged.
+ * The tables cannot be freed and reused within the EBR read section.
+ */
+static unsigned
+shard_find(struct EjInodeShard *sh, const unsigned char *digest)
+{
+    unsigned inode = 0;
     while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[i];
-        if (!entry->inode) {
-            // not found
-            break;
-        }
-        if (!memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
-            retval = entry;
-            break;
-        }
-        i = (i + HASH_TABLE_OFFSET) % ejh->size;
+        struct EjInodeTable *cur = atomic_load(&sh->cur);
+        struct EjInodeTable *old = atomic_load(&sh->old);
+        if (table_lookup(cur, digest, &inode)) break;
+        // not migrated yet
+        if (old && table_lookup(old, digest, &inode)) break;
+        if (atomic_load(&sh->cur) == cur && atomic_load(&sh->old) == old) break;
     }
-    pthread_rwlock_unlock(&ejh->rwl);
-    if (retval) return retval;
-    // insert an entry
-    pthread_rwlock_wrlock(&ejh->rwl);
-    if ((ejh->used + 1) * 2 >= ejh->size) {
-        // create new hashtable and copy its content
-        int new_size = primes[ejh->size_idx++];
-        if (new_size <= 0) abort(); // oops
-        struct EjInodeHashEntry *entries = calloc(new_size, sizeof(entries[0]));
-        for (int i = 0; i < ejh->size; ++i) {
-            struct EjInodeHashEntry *src_entry = &ejh->entries[i];
-            if (src_entry->inode) {
-                unsigned long long src_val;
-                memcpy(&src_val, src_entry->digest, sizeof(src_val));
-
-                int j = (int)(src_val % new_size);
-                while (1) {
-                    struct EjInodeHashEntry *dst_entry = &entries[j];
-                    if (!dst_entry->inode) {
-                        *dst_entry = *src_entry;
-                        break;
-                    }
-                    // check
-                    if (!memcmp(src_entry->digest, dst_entry->digest, SHA256_DIGEST_LENGTH)) abort();
-                    j = (j + HASH_TABLE_OFFSET) % new_size;
-                }
-            }
+    return inode;
+}
+
+// the shard mutex must be held
+static void
+shard_migrate(struct EjInodeShard *sh, size_t count)
+{
+    struct EjInodeTable *old = atomic_load_explicit(&sh->old, memory_order_relaxed);
+    if (!old) return;
+    struct EjInodeTable *cur = atomic_load_explicit(&sh->cur, memory_order_relaxed);
+    for (; count > 0 && sh->migrate_pos < old->size; --count, ++sh->migrate_pos) {
+        struct EjInodeHashEntry *entry = &old->entries[sh->migrate_pos];
+        unsigned inode = atomic_load_explicit(&entry->inode, memory_order_relaxed);
+        if (inode && inode != INODE_TOMBSTONE) {
+            table_put(cur, entry->digest, inode);
         }
-        free(ejh->entries);
-        ejh->entries = entries;
-        ejh->size = new_size;
     }
-    // now insert new hash
-    i = (int)(val % ejh->size);
-    while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[i];
-        if (!entry->inode) {
-            memcpy(entry->digest, digest, SHA256_DIGEST_LENGTH);
-            entry->inode = ejh->serial++;
-            retval = entry;
-            ++ejh->used;
-            break;
-        }
-        if (!memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
-            retval = entry;
-            break;
-        }
-        i = (i + HASH_TABLE_OFFSET) % ejh->size;
+    if (sh->migrate_pos == old->size) {
+        atomic_store(&sh->old, NULL);
+        ebr_retire(old, free);
     }
-    pthread_rwlock_unlock(&ejh->rwl);
-    return retval;
 }
 
-void
-inode_hash_delete(struct EjInodeHash *ejh, const unsigned char *digest)
+// the shard mutex must be held
+static void
+shard_maybe_grow(struct EjInodeShard *sh)
 {
-    unsigned long long val;
-    memcpy(&val, digest, sizeof(val));
+    struct EjInodeTable *cur = atomic_load_explicit(&sh->cur, memory_order_relaxed);
+    if ((cur->used + 1) * 2 < cur->size) return;
+    // the previous migration did not keep up, finish it now
+    shard_migrate(sh, SIZE_MAX);
+    cur = atomic_load_explicit(&sh->cur, memory_order_relaxed);
+    if ((cur->used + 1) * 2 < cur->size) return;
 
-    pthread_rwlock_wrlock(&ejh->rwl);
-    int i = (int)(val % ejh->size);
-    while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[i];
-        if (!entry->inode) {
-            goto done;
-        }
-        if (!memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
-            break;
-        }
-        i = (i + HASH_TABLE_OFFSET) % ejh->size;
-    }
-    // count the number of chained entries
-    int j = (i + HASH_TABLE_OFFSET) % ejh->size;
-    int chained_count = 0;
-    while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[j];
-        if (!entry->inode) {
-            break;
-        }
-        ++chained_count;
-        j = (j + HASH_TABLE_OFFSET) % ejh->size;
+    // tombstones are dropped during migration, so the new table may be smaller
+    size_t new_size = INODE_HASH_INITIAL_SIZE;
+    while (new_size < (sh->live + 1) * 4) new_size *= 2;
+    sh->migrate_pos = 0;
+    atomic_store(&sh->old, cur);
+    atomic_store(&sh->cur, table_create(new_size));
+}
+
+struct EjInodeHash *
+inode_hash_create(void)
+{
+    struct EjInodeHash *ejh = aligned_alloc(64, sizeof(*ejh));
+    if (!ejh) abort();
+    memset(ejh, 0, sizeof(*ejh));
+    ejh->serial = 1;
+    for (int i = 0; i < INODE_HASH_SHARDS; ++i) {
+        struct EjInodeShard *sh = &ejh->shards[i];
+        pthread_mutex_init(&sh->m, NULL);
+        atomic_init(&sh->cur, table_create(INODE_HASH_INITIAL_SIZE));
     }
-    // clear entry
-    memset(&ejh->entries[i], 0, sizeof(ejh->entries[0]));
-    // save chained nodes
-    if (chained_count > 100) abort(); // oops
-    struct EjInodeHashEntry *saved = alloca(sizeof(*saved) * chained_count);
-    int k = 0;
-    j = (i + HASH_TABLE_OFFSET) % ejh->size;
-    while (1) {
-        struct EjInodeHashEntry *entry = &ejh->entries[j];
-        if (!entry->inode) {
-            break;
+    return ejh;
+}
+
+void
+inode_hash_free(struct EjInodeHash *ejh)
+{
+    if (ejh) {
+        for (int i = 0; i < INODE_HASH_SHARDS; ++i) {
+            struct EjInodeShard *sh = &ejh->shards[i];
+            free(atomic_load(&sh->cur));
+            free(atomic_load(&sh->old));
+            pthread_mutex_destroy(&sh->m);
         }
-        memcpy(&saved[k++], entry, sizeof(*entry));
-        memset(entry, 0, sizeof(*entry));
-        j = (j + HASH_TABLE_OFFSET) % ejh->size;
+        free(ejh);
     }
-    // rehash saved nodes
-    for (k = 0; k < chained_count; ++k) {
-        struct EjInodeHashEntry *src_entry = &saved[k];
-        unsigned long long src_val;
-        memcpy(&src_val, src_entry->digest, sizeof(src_val));
-        j = (int)(src_val % ejh->size);
-        while (1) {
-            struct EjInodeHashEntry *dst_entry = &ejh->entries[j];
-            if (!dst_entry->inode) {
-                *dst_entry = *src_entry;
-                break;
-            }
-            // check
-            if (!memcmp(src_entry->digest, dst_entry->digest, SHA256_DIGEST_LENGTH)) abort();
-            j = (j + HASH_TABLE_OFFSET) % ejh->size;
-        }
+}
+
+unsigned
+inode_hash_find(struct EjInodeHash *ejh, const unsigned char *digest)
+{
+    struct EjInodeShard *sh = digest_shard(ejh, digest);
+    ebr_enter();
+    unsigned inode = shard_find(sh, digest);
+    ebr_exit();
+    return inode;
+}
+
+unsigned
+inode_hash_insert(struct EjInodeHash *ejh, const unsigned char *digest)
+{
+    unsigned inode = inode_hash_find(ejh, digest);
+    if (inode) return inode;
+
+    struct EjInodeShard *sh = digest_shard(ejh, digest);
+    pthread_mutex_lock(&sh->m);
+    inode = shard_find(sh, digest);
+    if (!inode) {
+        shard_migrate(sh, INODE_HASH_MIGRATE_STEP);
+        shard_maybe_grow(sh);
+        inode = atomic_fetch_add_explicit(&ejh->serial, 1, memory_order_relaxed);
+        table_put(atomic_load_explicit(&sh->cur, memory_order_relaxed), digest, inode);
+        ++sh->live;
     }
+    pthread_mutex_unlock(&sh->m);
+    return inode;
+}
 
-    --ejh->used;
-done:
-    pthread_rwlock_unlock(&ejh->rwl);
+void
+inode_hash_delete(struct EjInodeHash *ejh, const unsigned char *digest)
+{
+    struct EjInodeShard *sh = digest_shard(ejh, digest);
+    pthread_mutex_lock(&sh->m);
+    unsigned inode = 0;
+    int found = 0;
+    struct EjInodeHashEntry *entry = table_lookup(atomic_load_explicit(&sh->cur, memory_order_relaxed), digest, &inode);
+    if (entry) {
+        atomic_store_explicit(&entry->inode, INODE_TOMBSTONE, memory_order_release);
+        found = 1;
+    }
+    struct EjInodeTable *old = atomic_load_explicit(&sh->old, memory_order_relaxed);
+    if (old && (entry = table_lookup(old, digest, &inode))) {
+        atomic_store_explicit(&entry->inode, INODE_TOMBSTONE, memory_order_release);
+        found = 1;
+    }
+    if (found) --sh->live;
+    pthread_mutex_unlock(&sh->m);
 }
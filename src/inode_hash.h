@@ -19,17 +19,20 @@
  * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-struct EjInodeHashEntry
-{
-    unsigned inode;
-    unsigned char digest[32]; // SHA256_DIGEST_LENGTH
-};
+/*
+ * Maps SHA256 digests of unstructured paths to inode serial numbers.
+ * The table is split into shards, lookups do not take locks and do not
+ * write shared memory (they run in an EBR read section), inserts and
+ * deletes lock only the shard of the digest. Shards grow incrementally:
+ * every insert moves a few entries from the previous table to the new one.
+ */
 
 struct EjInodeHash;
 
 struct EjInodeHash *inode_hash_create(void);
 void inode_hash_free(struct EjInodeHash *ejh);
 
-struct EjInodeHashEntry *inode_hash_find(struct EjInodeHash *ejh, const unsigned char *digest);
-struct EjInodeHashEntry *inode_hash_insert(struct EjInodeHash *ejh, const unsigned char *digest);
+/* return 0 if not found */
+unsigned inode_hash_find(struct EjInodeHash *ejh, const unsigned char *digest);
+unsigned inode_hash_insert(struct EjInodeHash *ejh, const unsigned char *digest);
 void inode_hash_delete(struct EjInodeHash *ejh, const unsigned char *digest);
@@ -0,0 +1,95 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memfd_blob.h"
+#include "settings.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/*
+ * Every memfd blob keeps its descriptor open while it is cached, so their
+ * number is bounded by a quarter of RLIMIT_NOFILE (at most
+ * EJFUSE_MEMFD_MAX_BLOBS), the rest stay on the heap and are read by copy.
+ */
+static _Atomic int blob_count;
+static int blob_limit;
+static pthread_once_t blob_limit_once = PTHREAD_ONCE_INIT;
+
+static void
+blob_limit_init_func(void)
+{
+    struct rlimit rl;
+
+    blob_limit = EJFUSE_MEMFD_MAX_BLOBS;
+    if (getrlimit(RLIMIT_NOFILE, &rl) >= 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur / 4 < blob_limit) {
+        blob_limit = rl.rlim_cur / 4;
+    }
+}
+
+int
+memfd_blob_convert(unsigned char **p_data, size_t size)
+{
+    int fd = -1;
+    void *ptr = MAP_FAILED;
+    int counted = 0;
+
+    if (!*p_data || size < EJFUSE_MEMFD_MIN_SIZE) goto fail;
+    pthread_once(&blob_limit_once, blob_limit_init_func);
+    counted = 1;
+    if (atomic_fetch_add_explicit(&blob_count, 1, memory_order_relaxed) >= blob_limit) goto fail;
+
+    fd = memfd_create("ejfuse", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) goto fail;
+    for (size_t off = 0; off < size; ) {
+        ssize_t r = pwrite(fd, *p_data + off, size - off, off);
+        if (r <= 0) goto fail;
+        off += r;
+    }
+    // the content never changes, so dups of fd stay valid after free
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) goto fail;
+    ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) goto fail;
+
+    free(*p_data);
+    *p_data = ptr;
+    return fd;
+
+fail:
+    if (fd >= 0) close(fd);
+    if (counted) atomic_fetch_sub_explicit(&blob_count, 1, memory_order_relaxed);
+    return -1;
+}
+
+void
+memfd_blob_free(unsigned char *data, size_t size, int fd)
+{
+    if (fd >= 0) {
+        if (data) munmap(data, size);
+        close(fd);
+        atomic_fetch_sub_explicit(&blob_count, 1, memory_order_relaxed);
+    } else {
+        free(data);
+    }
+}
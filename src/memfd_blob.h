@@ -0,0 +1,38 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Large cached payloads are moved into sealed memfd files and mapped back
+ * read-only, so they can be read by memcpy as before and handed to libfuse
+ * as file descriptors for splicing.
+ */
+
+#include <stddef.h>
+
+/*
+ * moves the heap buffer *p_data to a memfd if size is at least
+ * EJFUSE_MEMFD_MIN_SIZE, returns the memfd, or -1 if the buffer is kept,
+ * the buffer is also kept when too many memfds are in use
+ */
+int memfd_blob_convert(unsigned char **p_data, size_t size);
+
+/* frees the buffer, either mapped (fd >= 0) or allocated on the heap */
+void memfd_blob_free(unsigned char *data, size_t size, int fd);
@@ -23,6 +23,7 @@
 #include "ejfuse.h"
 #include "ops_generic.h"
 #include "contests_state.h"
+#include "inode_code.h"
 
 #include <errno.h>
 #include <string.h>
@@ -33,7 +34,6 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
     int retval = -ENOENT;
-    unsigned char fullpath[PATH_MAX];
 
     memset(stb, 0, sizeof(*stb));
 
@@ -41,10 +41,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     struct EjContestListItem *fcntx = contest_list_find(contests, efr->contest_id);
     if (!fcntx) goto done;
 
-    if (snprintf(fullpath, sizeof(fullpath), "/%d", fcntx->id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode_code_make(INODE_KIND_CONTEST, fcntx->id, 0, 0);
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -136,33 +133,20 @@ ejf_readdir(
         return -ENOENT;
     }
 
-    unsigned char contest_path[PATH_MAX];
-    if (snprintf(contest_path, sizeof(contest_path), "/%d", efr->contest_id) >= sizeof(contest_path)) {
-        abort();
-    }
+    int cnts_id = efr->contest_id;
     struct stat es;
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, contest_path);
+    es.st_ino = inode_code_make(INODE_KIND_CONTEST, cnts_id, 0, 0);
     filler(buf, ".", &es, 0);
-    es.st_ino = get_inode(efs, "/");
+    es.st_ino = inode_code_make(INODE_KIND_ROOT, 0, 0, 0);
     filler(buf, "..", &es, 0);
-
-    unsigned char entry_path[PATH_MAX];
-    int res = snprintf(entry_path, sizeof(entry_path), "%s/%s", contest_path, "INFO");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = inode_code_make(INODE_KIND_CONTEST_INFO, cnts_id, 0, 0);
     filler(buf, "INFO", &es, 0);
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", contest_path, "info.json");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = inode_code_make(INODE_KIND_CONTEST_INFO_JSON, cnts_id, 0, 0);
     filler(buf, "info.json", &es, 0);
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", contest_path, "LOG");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = inode_code_make(INODE_KIND_CONTEST_LOG, cnts_id, 0, 0);
     filler(buf, "LOG", &es, 0);
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", contest_path, "problems");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = inode_code_make(INODE_KIND_PROBLEMS, cnts_id, 0, 0);
     filler(buf, "problems", &es, 0);
 
     return 0;
@@ -34,8 +34,8 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     struct EjFuseState *efs = efr->efs;
     struct EjContestState *ecs = efr->ecs;
     int retval = -ENOENT;
-    unsigned char fullpath[PATH_MAX];
     off_t size = 0;
+    unsigned long long inode = 0;
 
     struct EjContestInfo *eci = contest_info_read_lock(ecs);
     if (!eci || !eci->ok) {
@@ -44,18 +44,17 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
     if (efr->file_name_code == FILE_NAME_INFO) {
         size = eci->info_size;
+        inode = ecs->info_inode;
     } else if (efr->file_name_code == FILE_NAME_INFO_JSON) {
         size = eci->info_json_size;
+        inode = ecs->info_json_inode;
     } else {
         abort();
     }
     contest_info_read_unlock(eci);
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/%s", efr->contest_id, efr->file_name) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode;
     stb->st_mode = S_IFREG | EJFUSE_FILE_PERMS;
     stb->st_size = size;
     stb->st_nlink = 1;
@@ -32,7 +32,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjContestInfo *eci = NULL;
 
     eci = contest_info_read_lock(efr->ecs);
@@ -42,10 +41,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d", efr->contest_id, efr->prob_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->eps->inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -128,7 +124,6 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
     problem_info_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
 
     struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
@@ -137,43 +132,26 @@ ejf_readdir(
         return -EIO;
     }
 
-    unsigned char p_path[PATH_MAX];
-    int res = snprintf(p_path, sizeof(p_path), "/%d/problems/%d", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(p_path)) { abort(); }
+    struct EjProblemState *eps = efr->eps;
     struct stat es;
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, p_path);
+    es.st_ino = eps->inode;
     filler(buf, ".", &es, 0);
-
-    unsigned char up_path[PATH_MAX];
-    res = snprintf(up_path, sizeof(up_path), "/%d/problems", efr->contest_id);
-    if (res >= sizeof(up_path)) { abort(); }
-    es.st_ino = get_inode(efs, up_path);
+    es.st_ino = efr->ecs->problems_inode;
     filler(buf, "..", &es, 0);
 
-    unsigned char entry_path[PATH_MAX];
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", p_path, "INFO");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = eps->info_inode;
     filler(buf, "INFO", &es, 0);
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", p_path, "info.json");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = eps->info_json_inode;
     filler(buf, "info.json", &es, 0);
     if (epi->is_viewable && epi->is_statement_avaiable) {
-        res = snprintf(entry_path, sizeof(entry_path), "%s/%s", p_path, "statement.html");
-        if (res >= sizeof(entry_path)) { abort(); }
-        es.st_ino = get_inode(efs, entry_path);
+        es.st_ino = eps->stmt_inode;
         filler(buf, "statement.html", &es, 0);
     }
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", p_path, "runs");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efs, entry_path);
+    es.st_ino = eps->runs_inode;
     filler(buf, "runs", &es, 0);
     if (epi->is_submittable) {
-        res = snprintf(entry_path, sizeof(entry_path), "%s/%s", p_path, "submit");
-        if (res >= sizeof(entry_path)) { abort(); }
-        es.st_ino = get_inode(efs, entry_path);
+        es.st_ino = eps->submit_inode;
         filler(buf, "submit", &es, 0);
     }
 
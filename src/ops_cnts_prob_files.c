@@ -34,6 +34,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     struct EjFuseState *efs = efr->efs;
     off_t file_size = 0;
     long long mtime_us = 0;
+    unsigned long long inode = 0;
 
     if (efr->file_name_code == FILE_NAME_INFO) {
         struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
@@ -44,6 +45,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
         file_size = epi->info_size;
         mtime_us = epi->update_time_us;
         problem_info_read_unlock(epi);
+        inode = efr->eps->info_inode;
     } else if (efr->file_name_code == FILE_NAME_INFO_JSON) {
         struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
         if (!epi || !epi->ok) {
@@ -53,6 +55,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
         file_size = epi->info_json_size;
         mtime_us = epi->update_time_us;
         problem_info_read_unlock(epi);
+        inode = efr->eps->info_json_inode;
     } else if (efr->file_name_code == FILE_NAME_STATEMENT_HTML) {
         // try to not request statement.html from server
         struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
@@ -73,18 +76,14 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
             mtime_us = eph->update_time_us;
         }
         problem_statement_read_unlock(eph);
+        inode = efr->eps->stmt_inode;
     } else {
         return -ENOENT;
     }
 
-    unsigned char fullpath[PATH_MAX];
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/%s", efr->contest_id, efr->prob_id, efr->file_name) >= sizeof(fullpath)) {
-        abort();
-    }
-
     memset(stb, 0, sizeof(*stb));
 
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode;
     stb->st_mode = S_IFREG | EJFUSE_FILE_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -148,6 +147,7 @@ ejf_access(struct EjFuseRequest *efr, const char *path, int mode)
 static int
 ejf_release(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi)
 {
+    ejf_memfd_handle_release(ffi);
     return 0;
 }
 
@@ -174,6 +174,9 @@ ejf_open(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi
             problem_statement_read_unlock(eph);
             return -ENOENT;
         }
+        if (efr->efs->owner_uid == efr->fx->uid && (ffi->flags & O_ACCMODE) == O_RDONLY) {
+            ejf_memfd_handle_open(ffi, eph->stmt_fd);
+        }
         problem_statement_read_unlock(eph);
     } else {
         return -ENOENT;
@@ -297,7 +300,7 @@ const struct EjFuseOperations ejfuse_contest_problem_files_operations =
     ejf_generic_ioctl, //int (*ioctl)(struct EjFuseRequest *, const char *, int cmd, void *arg, struct fuse_file_info *, unsigned int flags, void *data);
     ejf_generic_poll, //int (*poll)(struct EjFuseRequest *, const char *, struct fuse_file_info *, struct fuse_pollhandle *ph, unsigned *reventsp);
     ejf_generic_write_buf, //int (*write_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *);
-    ejf_generic_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
+    ejf_memfd_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
     ejf_generic_flock, //int (*flock)(struct EjFuseRequest *, const char *, struct fuse_file_info *, int op);
     ejf_generic_fallocate, //int (*fallocate)(struct EjFuseRequest *, const char *, int, off_t, off_t, struct fuse_file_info *);
 };
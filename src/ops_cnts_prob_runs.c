@@ -33,7 +33,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjProblemInfo *epi = NULL;
 
     epi = problem_info_read_lock(efr->eps);
@@ -43,10 +42,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs", efr->contest_id, efr->prob_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->eps->runs_inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -125,47 +121,14 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
-
     problem_runs_maybe_update(efr->efs, efr->ecs, efr->eps, efr->current_time_us);
     struct EjProblemRuns *eprs = problem_runs_read_lock(efr->eps);
-    if (!eprs || !eprs->ok) {
+    if (!eprs || !eprs->ok || !eprs->listing) {
         problem_runs_read_unlock(eprs);
         return -EIO;
     }
 
-    unsigned char dot_path[PATH_MAX];
-    int res = snprintf(dot_path, sizeof(dot_path), "/%d/problems/%d/runs", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(dot_path)) { abort(); }
-    struct stat es;
-    memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, dot_path);
-    filler(buf, ".", &es, 0);
-
-    unsigned char ddot_path[PATH_MAX];
-    res = snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(ddot_path)) { abort(); }
-    es.st_ino = get_inode(efs, ddot_path);
-    filler(buf, "..", &es, 0);
-
-    for (int i = 0; i < eprs->size; ++i) {
-        struct EjProblemRun *epr = &eprs->runs[i];
-        unsigned char entry_name[PATH_MAX];
-        unsigned char entry_path[PATH_MAX];
-        unsigned char status_str[128];
-        unsigned char score_str[128];
-        run_status_str(epr->status, status_str, sizeof(status_str), 0, 0);
-        score_str[0] = 0;
-        if (epr->score >= 0) {
-            snprintf(score_str, sizeof(score_str), ",%d", epr->score);
-        }
-        res = snprintf(entry_name, sizeof(entry_name), "%d,%s%s", epr->run_id, status_str, score_str);
-        if (res >= sizeof(entry_name)) { abort(); }
-        res = snprintf(entry_path, sizeof(entry_path), "%s/%d", dot_path, epr->run_id);
-        if (res >= sizeof(entry_path)) { abort(); }
-        es.st_ino = get_inode(efs, entry_path);
-        filler(buf, entry_name, &es, 0);
-    }
+    ejf_fill_dir_listing(eprs->listing, buf, filler);
 
     problem_runs_read_unlock(eprs);
     return 0;
@@ -23,6 +23,7 @@
 #include "ejfuse.h"
 #include "ops_generic.h"
 #include "contests_state.h"
+#include "inode_code.h"
 
 #include <errno.h>
 #include <limits.h>
@@ -31,8 +32,6 @@
 static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
-    unsigned char fullpath[PATH_MAX];
-
     struct EjProblemRuns *eprs = problem_runs_read_lock(efr->eps);
     if (!eprs || !eprs->ok || eprs->size <= 0) {
         problem_runs_read_unlock(eprs);
@@ -45,10 +44,8 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs/%d", efr->contest_id, efr->prob_id, efr->run_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efr->efs, fullpath);
+    // the run state may not exist yet
+    stb->st_ino = inode_code_make(INODE_KIND_RUN, efr->contest_id, efr->run_id, 0);
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efr->efs->owner_uid;
@@ -150,39 +147,24 @@ ejf_readdir(
         return -EIO;
     }
 
-    unsigned char ddot_path[PATH_MAX];
-    int res = snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d/runs", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(ddot_path)) { abort(); }
-    unsigned char dot_path[PATH_MAX];
-    res = snprintf(dot_path, sizeof(dot_path), "%s/%d", ddot_path, efr->run_id);
-    if (res >= sizeof(dot_path)) { abort(); }
-
+    struct EjRunState *ers = efr->ers;
     struct stat es;
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efr->efs, dot_path);
+    es.st_ino = ers->inode;
     filler(buf, ".", &es, 0);
-    es.st_ino = get_inode(efr->efs, ddot_path);
+    es.st_ino = efr->eps->runs_inode;
     filler(buf, "..", &es, 0);
 
-    unsigned char entry_path[PATH_MAX];
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "INFO");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efr->efs, entry_path);
+    es.st_ino = ers->info_inode;
     filler(buf, "INFO", &es, 0);
-    res = snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "info.json");
-    if (res >= sizeof(entry_path)) { abort(); }
-    es.st_ino = get_inode(efr->efs, entry_path);
+    es.st_ino = ers->info_json_inode;
     filler(buf, "info.json", &es, 0);
     if (eri->compiler_text && eri->compiler_size) {
-        res = snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "compiler.txt");
-        if (res >= sizeof(entry_path)) { abort(); }
-        es.st_ino = get_inode(efr->efs, entry_path);
+        es.st_ino = ers->compiler_inode;
         filler(buf, "compiler.txt", &es, 0);
     }
     if (eri->valuer_text && eri->valuer_size) {
-        res = snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "valuer.txt");
-        if (res >= sizeof(entry_path)) { abort(); }
-        es.st_ino = get_inode(efr->efs, entry_path);
+        es.st_ino = ers->valuer_inode;
         filler(buf, "valuer.txt", &es, 0);
     }
     if (eri->is_src_enabled) {
@@ -190,23 +172,17 @@ ejf_readdir(
         if (!src_sfx) src_sfx = "";
         unsigned char entry_name[NAME_MAX + 1];
         if (snprintf(entry_name, sizeof(entry_name), "source%s", src_sfx) < sizeof(entry_name)) {
-            if (snprintf(entry_path, sizeof(entry_path), "%s/source", dot_path) < sizeof(entry_path)) {
-                es.st_ino = get_inode(efr->efs, entry_path);
-                filler(buf, entry_name, &es, 0);
-            }
+            es.st_ino = ers->src_inode;
+            filler(buf, entry_name, &es, 0);
         }
     }
     if (eri->message_count > 0) {
-        if (snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "messages.txt") < sizeof(entry_path)) {
-            es.st_ino = get_inode(efr->efs, entry_path);
-            filler(buf, "messages.txt", &es, 0);
-        }
+        es.st_ino = ers->msg_inode;
+        filler(buf, "messages.txt", &es, 0);
     }
     if (eri->is_test_available) {
-        if (snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, "tests") < sizeof(entry_path)) {
-            es.st_ino = get_inode(efr->efs, entry_path);
-            filler(buf, "tests", &es, 0);
-        }
+        es.st_ino = ers->tests_inode;
+        filler(buf, "tests", &es, 0);
     }
 
     run_info_read_unlock(eri);
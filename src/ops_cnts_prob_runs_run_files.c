@@ -194,6 +194,28 @@ get_info(
     return 0;
 }
 
+static unsigned long long
+get_file_inode(struct EjRunState *ers, int file_name_code)
+{
+    switch (file_name_code) {
+    case FILE_NAME_INFO:
+        return ers->info_inode;
+    case FILE_NAME_INFO_JSON:
+        return ers->info_json_inode;
+    case FILE_NAME_COMPILER_TXT:
+        return ers->compiler_inode;
+    case FILE_NAME_VALUER_TXT:
+        return ers->valuer_inode;
+    case FILE_NAME_SOURCE:
+        return ers->src_inode;
+    case FILE_NAME_MESSAGES_TXT:
+        return ers->msg_inode;
+    default:
+        abort();
+    }
+    return 0;
+}
+
 // INFO info.json compiler.txt valuer.txt messages.txt source*
 static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
@@ -208,14 +230,10 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     long long mtime_us = 0;
     int err = get_info(efr, NULL, &file_size, &mtime_us, NULL, NULL);
     if (err < 0) return err;
-    unsigned char fullpath[PATH_MAX];
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs/%d/%s", efr->contest_id, efr->prob_id, efr->run_id, efr->file_name) >= sizeof(fullpath)) {
-        return -ENAMETOOLONG;
-    }
 
     memset(stb, 0, sizeof(*stb));
 
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = get_file_inode(efr->ers, efr->file_name_code);
     stb->st_mode = S_IFREG | EJFUSE_FILE_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -259,6 +277,7 @@ ejf_access(struct EjFuseRequest *efr, const char *path, int mode)
 static int
 ejf_release(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi)
 {
+    ejf_memfd_handle_release(ffi);
     return 0;
 }
 
@@ -272,14 +291,36 @@ ejf_open(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi
 
     int res = get_info(efr, &file_data, &file_size, NULL, &unlocker, &unlock_data);
     if (res < 0) return res;
-    unlocker(unlock_data);
 
     if (efr->efs->owner_uid != efr->fx->uid) {
+        unlocker(unlock_data);
         return -EPERM;
     }
     if ((ffi->flags & O_ACCMODE) != O_RDONLY) {
+        unlocker(unlock_data);
         return -EPERM;
     }
+
+    // the content generation of the blob and where its last open is kept
+    unsigned gen = 0;
+    _Atomic unsigned *p_open_gen = NULL;
+    if (efr->file_name_code == FILE_NAME_SOURCE) {
+        struct EjRunSource *ert = unlock_data;
+        gen = ert->gen;
+        p_open_gen = &efr->ers->src_open_gen;
+        ejf_memfd_handle_open(ffi, ert->data_fd);
+    } else if (efr->file_name_code == FILE_NAME_COMPILER_TXT) {
+        gen = ((struct EjRunInfo *) unlock_data)->compiler_gen;
+        p_open_gen = &efr->ers->compiler_open_gen;
+    } else if (efr->file_name_code == FILE_NAME_VALUER_TXT) {
+        gen = ((struct EjRunInfo *) unlock_data)->valuer_gen;
+        p_open_gen = &efr->ers->valuer_open_gen;
+    }
+    unlocker(unlock_data);
+
+    if (p_open_gen && content_gen_keep_cache(p_open_gen, gen)) {
+        ffi->keep_cache = 1;
+    }
     return 0;
 }
 
@@ -345,7 +386,7 @@ const struct EjFuseOperations ejfuse_contest_problem_runs_run_files_operations =
     ejf_generic_ioctl, //int (*ioctl)(struct EjFuseRequest *, const char *, int cmd, void *arg, struct fuse_file_info *, unsigned int flags, void *data);
     ejf_generic_poll, //int (*poll)(struct EjFuseRequest *, const char *, struct fuse_file_info *, struct fuse_pollhandle *ph, unsigned *reventsp);
     ejf_generic_write_buf, //int (*write_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *);
-    ejf_generic_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
+    ejf_memfd_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
     ejf_generic_flock, //int (*flock)(struct EjFuseRequest *, const char *, struct fuse_file_info *, int op);
     ejf_generic_fallocate, //int (*fallocate)(struct EjFuseRequest *, const char *, int, off_t, off_t, struct fuse_file_info *);
 };
@@ -32,7 +32,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjRunInfo *eri = NULL;
 
     eri = run_info_read_lock(efr->ers);
@@ -42,10 +41,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs/%d/tests", efr->contest_id, efr->prob_id, efr->run_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->ers->tests_inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -125,47 +121,16 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
     struct EjRunInfo *eri = run_info_read_lock(efr->ers);
-    if (!eri || !eri->ok || !eri->is_test_available) {
+    if (!eri || !eri->ok || !eri->is_test_available || !eri->tests_listing) {
         run_info_read_unlock(eri);
         return -ENOENT;
     }
 
-    int retval = 0;
-    unsigned char ddot_path[PATH_MAX];
-    if (snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d/runs/%d", efr->contest_id, efr->prob_id, efr->run_id) >= sizeof(ddot_path)) {
-        retval = -EIO;
-        goto done;
-    }
-    unsigned char dot_path[PATH_MAX];
-    if (snprintf(dot_path, sizeof(dot_path), "%s/tests", ddot_path) >= sizeof(dot_path)) {
-        retval = -EIO;
-        goto done;
-    }
-    struct stat es;
-    memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, dot_path);
-    filler(buf, ".", &es, 0);
-    es.st_ino = get_inode(efs, ddot_path);
-    filler(buf, "..", &es, 0);
-
-    for (int i = 0; i < eri->test_count; ++i) {
-        struct EjRunInfoTestResult *eritr = &eri->tests[i];
-        if (eritr->is_visibility_full) {
-            unsigned char entry_name[PATH_MAX];
-            unsigned char entry_path[PATH_MAX];
-            if (snprintf(entry_name, sizeof(entry_name), "%d", eritr->num) < sizeof(entry_name)
-                && snprintf(entry_path, sizeof(entry_path), "%s/%d", dot_path, eritr->num) < sizeof(entry_path)) {
-                es.st_ino = get_inode(efs, entry_path);
-                filler(buf, entry_name, &es, 0);
-            }
-        }
-    }
+    ejf_fill_dir_listing(eri->tests_listing, buf, filler);
 
-done:
     run_info_read_unlock(eri);
-    return retval;
+    return 0;
 }
 
 const struct EjFuseOperations ejfuse_contest_problem_runs_run_tests_operations =
@@ -32,7 +32,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjRunInfo *eri = NULL;
 
     eri = run_info_read_lock(efr->ers);
@@ -42,11 +41,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs/%d/tests/%d", efr->contest_id, efr->prob_id, efr->run_id, efr->num) >= sizeof(fullpath)) {
-        run_info_read_unlock(eri);
-        return -ENOENT;
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->ert->inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -127,7 +122,6 @@ ejf_readdir(
         struct fuse_file_info *ffi)
 {
     int retval = -EIO;
-    struct EjFuseState *efs = efr->efs;
 
     struct EjRunInfo *eri = run_info_read_lock(efr->ers);
     if (!eri || !eri->ok || !eri->is_test_available) {
@@ -138,29 +132,17 @@ ejf_readdir(
         goto done;
     }
 
-    unsigned char ddot_path[PATH_MAX];
-    if (snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d/runs/%d/tests", efr->contest_id, efr->prob_id, efr->run_id) >= sizeof(ddot_path)) {
-        goto done;
-    }
-    unsigned char dot_path[PATH_MAX];
-    if (snprintf(dot_path, sizeof(dot_path), "%s/%d", ddot_path, efr->num) >= sizeof(dot_path)) {
-        goto done;
-    }
     struct stat es;
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, dot_path);
+    es.st_ino = efr->ert->inode;
     filler(buf, ".", &es, 0);
-    es.st_ino = get_inode(efs, ddot_path);
+    es.st_ino = efr->ers->tests_inode;
     filler(buf, "..", &es, 0);
 
     for (int i = 0; i < TESTING_REPORT_LAST; ++i) {
         if (eritr->data[i].is_defined) {
-            unsigned char entry_path[PATH_MAX];
-            const unsigned char *entry_name = testing_info_unparse(i);
-            if (snprintf(entry_path, sizeof(entry_path), "%s/%s", dot_path, entry_name) < sizeof(entry_path)) {
-                es.st_ino = get_inode(efs, entry_path);
-                filler(buf, entry_name, &es, 0);
-            }
+            es.st_ino = efr->ert->parts[i].inode;
+            filler(buf, testing_info_unparse(i), &es, 0);
         }
     }
     retval = 0;
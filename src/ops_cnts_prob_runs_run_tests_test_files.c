@@ -37,12 +37,6 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
         return -EPERM;
     }
 
-    unsigned char fullpath[PATH_MAX];
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/runs/%d/tests/%d/%s",
-                 efr->contest_id, efr->prob_id, efr->run_id, efr->num, efr->file_name) >= sizeof(fullpath)) {
-        return -ENAMETOOLONG;
-    }
-
     struct EjRunInfo *eri = run_info_read_lock(efr->ers);
     struct EjRunInfoTestResult *eritr = run_info_get_test_result_unlocked(eri, efr->num);
     struct EjRunInfoTestResultData *eritrd = &eritr->data[efr->test_file_index];
@@ -71,7 +65,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 
     memset(stb, 0, sizeof(*stb));
 
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->ert->parts[efr->test_file_index].inode;
     stb->st_mode = S_IFREG | perms;
     stb->st_nlink = 1;
     stb->st_uid = efs->owner_uid;
@@ -133,6 +127,7 @@ ejf_access(struct EjFuseRequest *efr, const char *path, int mode)
 static int
 ejf_release(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi)
 {
+    ejf_memfd_handle_release(ffi);
     return 0;
 }
 
@@ -152,8 +147,13 @@ ejf_open(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi
         run_test_data_read_unlock(ertd);
         return -ENOENT;
     }
-
+    unsigned gen = ertd->gen;
+    ejf_memfd_handle_open(ffi, ertd->data_fd);
     run_test_data_read_unlock(ertd);
+
+    if (content_gen_keep_cache(&efr->ert->parts[efr->test_file_index].open_gen, gen)) {
+        ffi->keep_cache = 1;
+    }
     return 0;
 }
 
@@ -218,7 +218,7 @@ const struct EjFuseOperations ejfuse_contest_problem_runs_run_tests_test_files_o
     ejf_generic_ioctl, //int (*ioctl)(struct EjFuseRequest *, const char *, int cmd, void *arg, struct fuse_file_info *, unsigned int flags, void *data);
     ejf_generic_poll, //int (*poll)(struct EjFuseRequest *, const char *, struct fuse_file_info *, struct fuse_pollhandle *ph, unsigned *reventsp);
     ejf_generic_write_buf, //int (*write_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *);
-    ejf_generic_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
+    ejf_memfd_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
     ejf_generic_flock, //int (*flock)(struct EjFuseRequest *, const char *, struct fuse_file_info *, int op);
     ejf_generic_fallocate, //int (*fallocate)(struct EjFuseRequest *, const char *, int, off_t, off_t, struct fuse_file_info *);
 };
@@ -33,7 +33,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjProblemInfo *epi = NULL;
 
     epi = problem_info_read_lock(efr->eps);
@@ -43,10 +42,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/submit", efr->contest_id, efr->prob_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->eps->submit_inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -125,88 +121,16 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
-
     //problem_info_maybe_update(efr->ejs, efr->ecs, efr->eps);
 
     struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
-    if (!epi || !epi->ok || !epi->is_submittable) {
+    if (!epi || !epi->ok || !epi->is_submittable || !epi->submit_listing) {
         problem_info_read_unlock(epi);
         return -EIO;
     }
 
-    unsigned char dot_path[PATH_MAX];
-    int res = snprintf(dot_path, sizeof(dot_path), "/%d/problems/%d/submit", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(dot_path)) { abort(); }
-    struct stat es;
-    memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, dot_path);
-    filler(buf, ".", &es, 0);
-
-    unsigned char ddot_path[PATH_MAX];
-    res = snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(ddot_path)) { abort(); }
-    es.st_ino = get_inode(efs, ddot_path);
-    filler(buf, "..", &es, 0);
+    ejf_fill_dir_listing(epi->submit_listing, buf, filler);
 
-    if (epi->type != 0) {
-        unsigned char entry_path[PATH_MAX];
-        unsigned char entry_name[PATH_MAX];
-        res = snprintf(entry_path, sizeof(entry_path), "%s/0", dot_path);
-        if (res >= sizeof(entry_path)) { abort(); }
-        snprintf(entry_name, sizeof(entry_name), "%d", 0);
-        es.st_ino = get_inode(efs, entry_path);
-        filler(buf, entry_name, &es, 0);
-
-        problem_info_read_unlock(epi);
-        return 0;
-    }
-
-    struct EjContestInfo *eci = contest_info_read_lock(efr->ecs);
-    if (eci && eci->ok) {
-        if (epi->compilers && epi->compiler_size > 0) {
-            for (int lang_id = 1; lang_id < epi->compiler_size; ++lang_id) {
-                struct EjContestCompiler *ecl = NULL;
-                if (epi->compilers[lang_id] && lang_id < eci->compiler_size && (ecl = eci->compilers[lang_id])) {
-                    unsigned char entry_path[PATH_MAX];
-                    unsigned char entry_name[PATH_MAX];
-                    res = snprintf(entry_path, sizeof(entry_path), "%s/%d", dot_path, lang_id);
-                    if (res >= sizeof(entry_path)) { abort(); }
-                    es.st_ino = get_inode(efs, entry_path);
-                    if (ecl->short_name && ecl->short_name[0] && ecl->long_name && ecl->long_name[0]) {
-                        res = snprintf(entry_name, sizeof(entry_name), "%s,%s", ecl->short_name, ecl->long_name);
-                    } else if (ecl->short_name && ecl->short_name[0]) {
-                        res = snprintf(entry_name, sizeof(entry_name), "%s", ecl->short_name);
-                    } else {
-                        res = snprintf(entry_name, sizeof(entry_name), "%d", lang_id);
-                    }
-                    if (res >= sizeof(entry_name)) { abort(); }
-                    filler(buf, entry_name, &es, 0);
-                }
-            }
-        } else if (eci->compiler_size > 0 && eci->compilers) {
-            for (int lang_id = 1; lang_id < eci->compiler_size; ++lang_id){
-                struct EjContestCompiler *ecl = eci->compilers[lang_id];
-                if (ecl) {
-                    unsigned char entry_path[PATH_MAX];
-                    unsigned char entry_name[PATH_MAX];
-                    res = snprintf(entry_path, sizeof(entry_path), "%s/%d", dot_path, lang_id);
-                    if (res >= sizeof(entry_path)) { abort(); }
-                    es.st_ino = get_inode(efs, entry_path);
-                    if (ecl->short_name && ecl->short_name[0] && ecl->long_name && ecl->long_name[0]) {
-                        res = snprintf(entry_name, sizeof(entry_name), "%s,%s", ecl->short_name, ecl->long_name);
-                    } else if (ecl->short_name && ecl->short_name[0]) {
-                        res = snprintf(entry_name, sizeof(entry_name), "%s", ecl->short_name);
-                    } else {
-                        res = snprintf(entry_name, sizeof(entry_name), "%d", lang_id);
-                    }
-                    if (res >= sizeof(entry_name)) { abort(); }
-                    filler(buf, entry_name, &es, 0);
-                }
-            }
-        }
-    }
-    contest_info_read_unlock(eci);
     problem_info_read_unlock(epi);
     return 0;
 }
@@ -25,6 +25,7 @@
 #include "ops_generic.h"
 #include "contests_state.h"
 #include "ejfuse_file.h"
+#include "inode_code.h"
 
 #include <string.h>
 #include <errno.h>
@@ -34,7 +35,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     struct EjProblemInfo *epi = NULL;
 
     epi = problem_info_read_lock(efr->eps);
@@ -62,10 +62,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     }
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems/%d/submit/%d", efr->contest_id, efr->prob_id, efr->lang_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode_code_make(INODE_KIND_SUBMIT_COMP, efr->contest_id, efr->prob_id, efr->lang_id);
     // non-standard permissions: -wx------
     //stb->st_mode = S_IFDIR | 0300;
     stb->st_mode = S_IFDIR | 0700; // debug
@@ -179,7 +176,6 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
     struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
     if (!epi || !epi->ok || !epi->is_submittable) {
         problem_info_read_unlock(epi);
@@ -205,18 +201,11 @@ ejf_readdir(
     }
     problem_info_read_unlock(epi);
 
-    unsigned char dot_path[PATH_MAX];
-    int res = snprintf(dot_path, sizeof(dot_path), "/%d/problems/%d/submit/%d", efr->contest_id, efr->prob_id, efr->lang_id);
-    if (res >= sizeof(dot_path)) { abort(); }
     struct stat es;
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, dot_path);
+    es.st_ino = inode_code_make(INODE_KIND_SUBMIT_COMP, efr->contest_id, efr->prob_id, efr->lang_id);
     filler(buf, ".", &es, 0);
-
-    unsigned char ddot_path[PATH_MAX];
-    res = snprintf(ddot_path, sizeof(ddot_path), "/%d/problems/%d/submit", efr->contest_id, efr->prob_id);
-    if (res >= sizeof(ddot_path)) { abort(); }
-    es.st_ino = get_inode(efs, ddot_path);
+    es.st_ino = efr->eps->submit_inode;
     filler(buf, "..", &es, 0);
 
     struct EjProblemCompilerSubmits *epcs = problem_submits_get(efr->eps->submits, efr->lang_id);
@@ -224,11 +213,8 @@ ejf_readdir(
     int size = dir_nodes_size(epcs->dir_nodes);
     for (int i = 0; i < size; ++i) {
         struct EjDirectoryNode dn;
-        unsigned char path[PATH_MAX];
         dir_nodes_read(epcs->dir_nodes, i, &dn);
-        res = snprintf(path, sizeof(path), "/fnode/%d", dn.fnode);
-        if (res >= sizeof(path)) { abort(); }
-        es.st_ino = get_inode(efs, path);
+        es.st_ino = inode_code_make_serial(INODE_KIND_FNODE, dn.fnode);
         filler(buf, dn.name, &es, 0);
     }
     dir_nodes_unlock(epcs->dir_nodes);
@@ -24,6 +24,7 @@
 #include "ops_generic.h"
 #include "contests_state.h"
 #include "ejfuse_file.h"
+#include "inode_code.h"
 #include "submit_thread.h"
 
 #include <string.h>
@@ -53,6 +54,8 @@ check_perms(struct EjFuseRequest *efr, int file_perms, int req_perms)
 static int
 check_lang(struct EjFuseRequest *efr)
 {
+    // release may be called for a request which no longer resolves
+    if (!efr->eps) return -ENOENT;
     struct EjProblemInfo *epi = problem_info_read_lock(efr->eps);
     if (!epi || !epi->ok || !epi->is_submittable) {
         problem_info_read_unlock(epi);
@@ -84,7 +87,6 @@ static int
 ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
     size_t name_len = strlen(efr->file_name);
 
     if (name_len > NAME_MAX) return -ENAMETOOLONG;
@@ -109,10 +111,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     pthread_mutex_lock(&efn->m);
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/fnode/%d", dn.fnode) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode_code_make_serial(INODE_KIND_FNODE, dn.fnode);
     stb->st_mode = S_IFREG | (efn->mode & 07777);
     stb->st_nlink = efn->nlink;
     stb->st_uid = efs->owner_uid;
@@ -126,7 +125,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     stb->st_ctim.tv_nsec = (efn->ctime_us % 1000000) * 1000;
 
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    file_node_unref(efn);
     return 0;
 }
 
@@ -134,18 +133,13 @@ static int
 ejf_fgetattr(struct EjFuseRequest *efr, const char *path, struct stat *stb, struct fuse_file_info *ffi)
 {
     struct EjFuseState *efs = efr->efs;
-    unsigned char fullpath[PATH_MAX];
 
-    struct EjFileNode *efn = file_nodes_get_node(efs->file_nodes, ffi->fh);
-    if (!efn) return -ENOENT;
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
 
     pthread_mutex_lock(&efn->m);
 
     memset(stb, 0, sizeof(*stb));
-    if (snprintf(fullpath, sizeof(fullpath), "/fnode/%d", (int) ffi->fh) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = inode_code_make_serial(INODE_KIND_FNODE, efn->fnode);
     stb->st_mode = S_IFREG | (efn->mode & 07777);
     stb->st_nlink = efn->nlink;
     stb->st_uid = efs->owner_uid;
@@ -159,7 +153,6 @@ ejf_fgetattr(struct EjFuseRequest *efr, const char *path, struct stat *stb, stru
     stb->st_ctim.tv_nsec = (efn->ctime_us % 1000000) * 1000;
 
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
     return 0;
 }
 
@@ -212,7 +205,7 @@ ejf_access(struct EjFuseRequest *efr, const char *path, int mode)
     int perms = efn->mode;
 
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    file_node_unref(efn);
 
     return check_perms(efr, perms, mode);
 }
@@ -252,22 +245,22 @@ ejf_open(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi
 
     if ((res = check_perms(efr, efn->mode, req_bits)) < 0) {
         pthread_mutex_unlock(&efn->m);
-        atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+        file_node_unref(efn);
         return res;
     }
 
     if ((open_mode == O_WRONLY || open_mode == O_RDWR) && (ffi->flags & O_TRUNC)) {
         // truncate output
-        efn->size = 0;
+        file_node_truncate_unlocked(efr->efs->file_nodes, efn, 0);
         efn->mtime_us = efr->current_time_us;
     }
 
     efn->atime_us = efr->current_time_us;
     atomic_fetch_add_explicit(&efn->opencnt, 1, memory_order_relaxed);
-    ffi->fh = dn.fnode;
+    // the node reference is kept in ffi->fh until release
+    ffi->fh = (uintptr_t) efn;
 
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
 
     return 0;
 }
@@ -313,22 +306,22 @@ ejf_create(struct EjFuseRequest *efr, const char *path, mode_t mode, struct fuse
 
     if ((res = check_perms(efr, efn->mode, req_bits)) < 0) {
         pthread_mutex_unlock(&efn->m);
-        atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+        file_node_unref(efn);
         return res;
     }
 
     if ((open_mode == O_WRONLY || open_mode == O_RDWR) && (ffi->flags & O_TRUNC)) {
         // truncate output
-        efn->size = 0;
+        file_node_truncate_unlocked(efr->efs->file_nodes, efn, 0);
         efn->mtime_us = efr->current_time_us;
     }
 
     efn->atime_us = efr->current_time_us;
     atomic_fetch_add_explicit(&efn->opencnt, 1, memory_order_relaxed);
-    ffi->fh = dn.fnode;
+    // the node reference is kept in ffi->fh until release
+    ffi->fh = (uintptr_t) efn;
 
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
 
     return 0;
 }
@@ -368,7 +361,7 @@ ejf_truncate(struct EjFuseRequest *efr, const char *path, off_t offset)
 
 out:
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    file_node_unref(efn);
     return res;
 }
 
@@ -378,8 +371,7 @@ ejf_ftruncate(struct EjFuseRequest *efr, const char *path, off_t offset, struct
     int res = check_lang(efr);
     if (res < 0) return res;
 
-    struct EjFileNode *efn = file_nodes_get_node(efr->efs->file_nodes, ffi->fh);
-    if (!efn) return -ENOENT;
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
 
     pthread_mutex_lock(&efn->m);
 
@@ -391,7 +383,6 @@ ejf_ftruncate(struct EjFuseRequest *efr, const char *path, off_t offset, struct
 
 out:
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
     return res;
 }
 
@@ -443,25 +434,83 @@ ejf_read(
     if (isize < 0) return -EINVAL;
     if (!isize) return 0;
 
-    struct EjFileNode *efn = file_nodes_get_node(efr->efs->file_nodes, ffi->fh);
-    if (!efn) return -ENOENT;
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
 
     pthread_mutex_lock(&efn->m);
+    if (ioff >= efn->size) {
+        isize = 0;
+    } else if (efn->size - ioff < isize) {
+        isize = efn->size - ioff;
+    }
+    int fd = efn->fd;
+    efn->atime_us = efr->current_time_us;
+    pthread_mutex_unlock(&efn->m);
 
     res = 0;
-    if (ioff >= efn->size) goto out;
-    if (efn->size - ioff < isize) isize = efn->size - ioff;
-    if (isize <= 0) goto out;
-    memcpy(buf, efn->data + ioff, isize);
-    res = isize;
+    if (isize > 0) {
+        res = file_node_pread(fd, (unsigned char *) buf, isize, ioff);
+    }
+    return res;
+}
+
+// extends the file under efn->m, the data is copied by the caller to *p_fd
+static int
+write_begin(
+        struct EjFuseRequest *efr,
+        struct EjFileNode *efn,
+        int ioff,
+        int isize,
+        int *p_fd,
+        int *p_old_size)
+{
+    int res = 0;
+    pthread_mutex_lock(&efn->m);
+    *p_old_size = efn->size;
+
+    int new_size;
+    if (__builtin_add_overflow(ioff, isize, &new_size)) {
+        res = -EIO;
+        goto out;
+    }
+    if ((res = file_node_reserve_unlocked(efr->efs->file_nodes, efn, ioff, isize)) < 0)
+        goto out;
+    if (new_size > efn->size) {
+        if ((res = file_node_truncate_unlocked(efr->efs->file_nodes, efn, new_size)) < 0) {
+            // drops the reservation
+            file_node_account_unlocked(efr->efs->file_nodes, efn);
+            goto out;
+        }
+    }
+    *p_fd = efn->fd;
 
 out:
-    efn->atime_us = efr->current_time_us;
+    efn->mtime_us = efr->current_time_us;
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
     return res;
 }
 
+/*
+ * cuts the extension made by write_begin back to the data actually written
+ * (res is the result of the copy), charges the pages allocated by the write
+ * to the quota
+ */
+static void
+write_end(struct EjFuseRequest *efr, struct EjFileNode *efn, int ioff, int isize, int old_size, int res)
+{
+    pthread_mutex_lock(&efn->m);
+    int new_size = ioff + isize;
+    if (new_size > old_size && efn->size == new_size) {
+        int end = ioff;
+        if (res > 0) end += res;
+        if (end < old_size) end = old_size;
+        if (end < new_size) {
+            file_node_truncate_unlocked(efr->efs->file_nodes, efn, end);
+        }
+    }
+    file_node_account_unlocked(efr->efs->file_nodes, efn);
+    pthread_mutex_unlock(&efn->m);
+}
+
 static int
 ejf_write(
         struct EjFuseRequest *efr,
@@ -485,51 +534,76 @@ ejf_write(
     if (isize < 0) return -EINVAL;
     if (!isize) return 0;
 
-    struct EjFileNode *efn = file_nodes_get_node(efr->efs->file_nodes, ffi->fh);
-    if (!efn) return -ENOENT;
-
-    pthread_mutex_lock(&efn->m);
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
 
-    int new_size;
-    if (__builtin_add_overflow(ioff, isize, &new_size)) {
-        res = -EIO;
-        goto out;
+    int fd = -1;
+    int old_size = 0;
+    if ((res = write_begin(efr, efn, ioff, isize, &fd, &old_size)) >= 0) {
+        res = file_node_pwrite(fd, (const unsigned char *) buf, isize, ioff);
+        write_end(efr, efn, ioff, isize, old_size, res);
     }
-    if (new_size > efn->size) {
-        if ((res = file_node_truncate_unlocked(efr->efs->file_nodes, efn, new_size)) < 0)
-            goto out;
-    }
-
-    memcpy(efn->data + ioff, buf, isize);
-    res = isize;
-
-out:
-    efn->mtime_us = efr->current_time_us;
-    pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
     return res;
 }
 
 static int
-ejf_release(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi)
+ejf_write_buf(
+        struct EjFuseRequest *efr,
+        const char *path,
+        struct fuse_bufvec *bufv,
+        off_t offset,
+        struct fuse_file_info *ffi)
 {
     int res = check_lang(efr);
     if (res < 0) return res;
 
-    struct EjFileNode *efn = file_nodes_get_node(efr->efs->file_nodes, ffi->fh);
-    if (!efn) return -ENOENT;
+    int open_mode = (ffi->flags & O_ACCMODE);
+    if (open_mode != O_WRONLY && open_mode != O_RDWR) return -EBADF;
+
+    size_t size = fuse_buf_size(bufv);
+    if (offset < 0) return -EINVAL;
+    int ioff = offset;
+    if (ioff != offset) return -EINVAL;
+    int isize = size;
+    if (isize != size) return -EINVAL;
+    if (isize < 0) return -EINVAL;
+    if (!isize) return 0;
+
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
+
+    int fd = -1;
+    int old_size = 0;
+    if ((res = write_begin(efr, efn, ioff, isize, &fd, &old_size)) >= 0) {
+        // a pipe from the kernel (FUSE_CAP_SPLICE_READ) is spliced into the memfd
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+        dst.buf[0].flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+        dst.buf[0].fd = fd;
+        dst.buf[0].pos = offset;
+        res = fuse_buf_copy(&dst, bufv, 0);
+        write_end(efr, efn, ioff, isize, old_size, res);
+    }
+    return res;
+}
 
-    submit_thread_enqueue(efr->efs->submit_thread,
-                          submit_item_create(efr->current_time_us,
-                                             efr->contest_id,
-                                             efr->prob_id,
-                                             efr->lang_id,
-                                             ffi->fh,
-                                             efr->file_name));
+static int
+ejf_release(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi)
+{
+    struct EjFileNode *efn = (struct EjFileNode *) (uintptr_t) ffi->fh;
+    int res = check_lang(efr);
+    if (res >= 0) {
+        submit_thread_enqueue(efr->efs->submit_thread,
+                              submit_item_create(efr->current_time_us,
+                                                 efr->contest_id,
+                                                 efr->prob_id,
+                                                 efr->lang_id,
+                                                 efn->fnode,
+                                                 efr->file_name));
+    }
 
     atomic_fetch_sub_explicit(&efn->opencnt, 1, memory_order_relaxed);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
-    return 0;
+    // the reference held by ffi->fh is passed on, the node is never left open
+    file_nodes_maybe_remove(efr->efs->file_nodes, efn, efr->current_time_us);
+    ffi->fh = 0;
+    return res < 0 ? res : 0;
 }
 
 static int
@@ -571,7 +645,7 @@ ejf_utimens(struct EjFuseRequest *efr, const char *path, const struct timespec t
 
 out:
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    file_node_unref(efn);
     return res;
 }
 
@@ -599,7 +673,7 @@ ejf_chmod(struct EjFuseRequest *efr, const char *path, mode_t mode)
     pthread_mutex_lock(&efn->m);
     efn->mode = mode & 07777;
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed);
+    file_node_unref(efn);
 
     return 0;
 }
@@ -642,7 +716,7 @@ const struct EjFuseOperations ejfuse_contest_problem_submit_compiler_dir_operati
     ejf_generic_bmap, //int (*bmap)(struct EjFuseRequest *, const char *, size_t blocksize, uint64_t *idx);
     ejf_generic_ioctl, //int (*ioctl)(struct EjFuseRequest *, const char *, int cmd, void *arg, struct fuse_file_info *, unsigned int flags, void *data);
     ejf_generic_poll, //int (*poll)(struct EjFuseRequest *, const char *, struct fuse_file_info *, struct fuse_pollhandle *ph, unsigned *reventsp);
-    ejf_generic_write_buf, //int (*write_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *);
+    ejf_write_buf, //int (*write_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *);
     ejf_generic_read_buf, //int (*read_buf)(struct EjFuseRequest *, const char *, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *);
     ejf_generic_flock, //int (*flock)(struct EjFuseRequest *, const char *, struct fuse_file_info *, int op);
     ejf_generic_fallocate, //int (*fallocate)(struct EjFuseRequest *, const char *, int, off_t, off_t, struct fuse_file_info *);
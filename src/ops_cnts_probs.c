@@ -33,7 +33,6 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 {
     struct EjFuseState *efs = efr->efs;
     int retval = -ENOENT;
-    unsigned char fullpath[PATH_MAX];
 
     struct EjContestInfo *eci = contest_info_read_lock(efr->ecs);
     if (!eci || !eci->ok) {
@@ -44,10 +43,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
 
     memset(stb, 0, sizeof(*stb));
 
-    if (snprintf(fullpath, sizeof(fullpath), "/%d/problems", efr->ecs->cnts_id) >= sizeof(fullpath)) {
-        abort();
-    }
-    stb->st_ino = get_inode(efs, fullpath);
+    stb->st_ino = efr->ecs->problems_inode;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
     stb->st_uid = efs->owner_uid;
@@ -130,46 +126,13 @@ ejf_readdir(
         off_t offset,
         struct fuse_file_info *ffi)
 {
-    struct EjFuseState *efs = efr->efs;
     struct EjContestInfo *eci = contest_info_read_lock(efr->ecs);
-    if (!eci || !eci->ok) {
+    if (!eci || !eci->ok || !eci->probs_listing) {
         contest_info_read_unlock(eci);
         return -ENOENT;
     }
 
-    unsigned char cp_path[PATH_MAX];
-    int res = snprintf(cp_path, sizeof(cp_path), "/%d/problems", efr->contest_id);
-    if (res >= sizeof(cp_path)) { abort(); }
-    struct stat es;
-    memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, cp_path);
-    filler(buf, ".", &es, 0);
-    unsigned char p_path[PATH_MAX];
-    res = snprintf(p_path, sizeof(p_path), "/%d", efr->contest_id);
-    if (res >= sizeof(p_path)) { abort(); }
-    es.st_ino = get_inode(efs, p_path);
-    filler(buf, "..", &es, 0);
-
-    for (int prob_id = 1; prob_id < eci->prob_size; ++prob_id) {
-        struct EjContestProblem *ecp = eci->probs[prob_id];
-        if (ecp) {
-            unsigned char dpath[PATH_MAX];
-            unsigned char ipath[PATH_MAX];
-
-            int res = snprintf(ipath, sizeof(ipath), "%s/%d", cp_path, prob_id);
-            if (res >= sizeof(ipath)) { abort(); }
-            if (ecp->short_name && ecp->long_name) {
-                res = snprintf(dpath, sizeof(dpath), "%s,%s", ecp->short_name, ecp->long_name);
-            } else if (ecp->short_name) {
-                res = snprintf(dpath, sizeof(dpath), "%s", ecp->short_name);
-            } else {
-                res = snprintf(dpath, sizeof(dpath), "%d", prob_id);
-            }
-            if (res >= sizeof(dpath)) { abort(); }
-            es.st_ino = get_inode(efs, ipath);
-            filler(buf, fix_name(dpath), &es, 0);
-        }
-    }
+    ejf_fill_dir_listing(eci->probs_listing, buf, filler);
 
     contest_info_read_unlock(eci);
     return 0;
@@ -20,8 +20,12 @@
 #include "ops_fuse.h"
 #include "ejfuse.h"
 #include "submit_thread.h"
+#include "http_engine.h"
+#include "curl_pool.h"
+#include "refresh_thread.h"
 
 #include <errno.h>
+#include <stdlib.h>
 
 /*
 Generic handling of FUSE requests
@@ -382,16 +386,45 @@ ejf_entry_fsyncdir(const char *path, int datasync, struct fuse_file_info *ffi)
     }
     return request_free(&rq, rq.ops->fsyncdir(&rq, path, datasync, ffi));
 }
+void
+ejf_entry_start(struct EjFuseState *efs)
+{
+    // the I/O thread is started here, as fuse_main may fork
+    if (http_engine_start(efs->http_engine) < 0) {
+        fprintf(stderr, "failed to start HTTP engine, using synchronous requests\n");
+    }
+    submit_thread_start(efs->submit_thread, efs);
+    refresh_thread_start(efs->refresh_thread, efs);
+}
+void
+ejf_entry_stop(struct EjFuseState *efs)
+{
+    // the threads may be waiting for HTTP requests, so the engine goes last
+    submit_thread_stop(efs->submit_thread);
+    refresh_thread_stop(efs->refresh_thread);
+    http_engine_free(efs->http_engine);
+    efs->http_engine = NULL;
+    curl_pool_free(efs->curl_pool);
+    efs->curl_pool = NULL;
+    refresh_thread_free(efs->refresh_thread);
+    efs->refresh_thread = NULL;
+    submit_thread_free(efs->submit_thread);
+    efs->submit_thread = NULL;
+}
 static void *
 ejf_entry_init(struct fuse_conn_info *conn)
 {
     struct EjFuseState *efs = fuse_get_context()->private_data;
-    submit_thread_start(efs->submit_thread, efs);
+    ejf_entry_start(efs);
+    // without -o splice_write/splice_move libfuse copies the read data from the memfd,
+    // without -o splice_read write_buf gets the written data in memory
+    conn->want |= conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_READ);
     return efs;
 }
 static void
 ejf_entry_destroy(void *user)
 {
+    ejf_entry_stop(user);
 }
 static int
 ejf_entry_access(const char *path, int mode)
@@ -520,7 +553,7 @@ ejf_entry_poll(
     }
     return request_free(&rq, rq.ops->poll(&rq, path, ffi, ph, reventsp));
 }
-static int __attribute__((unused))
+static int
 ejf_entry_write_buf(
         const char *path,
         struct fuse_bufvec *buf,
@@ -532,12 +565,36 @@ ejf_entry_write_buf(
     if (r < 0) {
         return request_free(&rq, r);
     }
-    if (!rq.ops || !rq.ops->write_buf) {
+    if (!rq.ops) {
+        return request_free(&rq, -ENOSYS);
+    }
+    r = -ENOSYS;
+    if (rq.ops->write_buf) {
+        r = rq.ops->write_buf(&rq, path, buf, off, ffi);
+    }
+    if (r != -ENOSYS) {
+        return request_free(&rq, r);
+    }
+    if (!rq.ops->write) {
         return request_free(&rq, -ENOSYS);
     }
-    return request_free(&rq, rq.ops->write_buf(&rq, path, buf, off, ffi));
+
+    // copy into a memory buffer as libfuse does without write_buf
+    size_t size = fuse_buf_size(buf);
+    struct fuse_bufvec mem = FUSE_BUFVEC_INIT(size);
+    if (!(mem.buf[0].mem = malloc(size + 1))) {
+        return request_free(&rq, -ENOMEM);
+    }
+    ssize_t copied = fuse_buf_copy(&mem, buf, 0);
+    if (copied < 0) {
+        r = copied;
+    } else {
+        r = rq.ops->write(&rq, path, mem.buf[0].mem, copied, off, ffi);
+    }
+    free(mem.buf[0].mem);
+    return request_free(&rq, r);
 }
-static int __attribute__((unused))
+static int
 ejf_entry_read_buf(
         const char *path,
         struct fuse_bufvec **bufp,
@@ -550,10 +607,38 @@ ejf_entry_read_buf(
     if (r < 0) {
         return request_free(&rq, r);
     }
-    if (!rq.ops || !rq.ops->read_buf) {
+    if (!rq.ops) {
         return request_free(&rq, -ENOSYS);
     }
-    return request_free(&rq, rq.ops->read_buf(&rq, path, bufp, size, off, ffi));
+    r = -ENOSYS;
+    if (rq.ops->read_buf) {
+        r = rq.ops->read_buf(&rq, path, bufp, size, off, ffi);
+    }
+    if (r != -ENOSYS) {
+        return request_free(&rq, r);
+    }
+    if (!rq.ops->read) {
+        return request_free(&rq, -ENOSYS);
+    }
+
+    // copy into a memory buffer as libfuse does without read_buf
+    struct fuse_bufvec *bufv = malloc(sizeof(*bufv));
+    char *mem = malloc(size + 1);
+    if (!bufv || !mem) {
+        free(bufv);
+        free(mem);
+        return request_free(&rq, -ENOMEM);
+    }
+    r = rq.ops->read(&rq, path, mem, size, off, ffi);
+    if (r < 0) {
+        free(bufv);
+        free(mem);
+        return request_free(&rq, r);
+    }
+    *bufv = FUSE_BUFVEC_INIT(r);
+    bufv->buf[0].mem = mem;
+    *bufp = bufv;
+    return request_free(&rq, 0);
 }
 static int __attribute__((unused))
 ejf_entry_flock(const char *path, struct fuse_file_info *ffi, int op)
@@ -1053,7 +1138,7 @@ const struct fuse_operations ejf_fuse_operations =
      *
      * Introduced in version 2.9
      */
-    NULL, //ejf_entry_write_buf,
+    ejf_entry_write_buf,
 
     /**
      * Store data from an open file in a buffer
@@ -1072,7 +1157,7 @@ const struct fuse_operations ejf_fuse_operations =
      *
      * Introduced in version 2.9
      */
-    NULL, //ejf_entry_read_buf,
+    ejf_entry_read_buf,
 
     /**
      * Perform BSD file locking operation
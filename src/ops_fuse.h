@@ -23,3 +23,9 @@
 #include <fuse.h>
 
 extern const struct fuse_operations ejf_fuse_operations;
+
+struct EjFuseState;
+
+/* starts the background threads, called when the file system is mounted */
+void ejf_entry_start(struct EjFuseState *efs);
+void ejf_entry_stop(struct EjFuseState *efs);
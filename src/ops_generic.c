@@ -18,9 +18,12 @@
  */
 
 #include "ops_generic.h"
+#include "dir_listing.h"
 
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 int
 ejf_generic_readlink(struct EjFuseRequest *efr, const char *path, char *buf, size_t size)
@@ -214,12 +217,14 @@ ejf_generic_poll(struct EjFuseRequest *efr, const char *path, struct fuse_file_i
 int
 ejf_generic_write_buf(struct EjFuseRequest *efr, const char *path, struct fuse_bufvec *buf, off_t off, struct fuse_file_info *ffi)
 {
-    return -EIO;
+    // the front ends fall back to write
+    return -ENOSYS;
 }
 int
 ejf_generic_read_buf(struct EjFuseRequest *efr, const char *path, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *ffi)
 {
-    return -EIO;
+    // the front ends fall back to read
+    return -ENOSYS;
 }
 int
 ejf_generic_flock(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi, int op)
@@ -232,6 +237,63 @@ ejf_generic_fallocate(struct EjFuseRequest *efr, const char *path, int arg3, off
     return -EOPNOTSUPP;
 }
 
+void
+ejf_fill_dir_listing(const struct EjDirListing *edl, void *buf, fuse_fill_dir_t filler)
+{
+    struct stat es;
+    memset(&es, 0, sizeof(es));
+    for (const struct EjDirEntry *ede = dir_listing_first(edl); ede; ede = dir_listing_next(edl, ede)) {
+        es.st_ino = ede->inode;
+        es.st_mode = ede->mode;
+        filler(buf, ede->name, &es, 0);
+    }
+}
+
+void
+ejf_memfd_handle_open(struct fuse_file_info *ffi, int fd)
+{
+    ffi->fh = 0;
+    if (fd < 0) return;
+    // the memfd is sealed, so the dup outlives a refetch of the blob
+    int dfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dfd >= 0) {
+        ffi->fh = (uint64_t) dfd + 1;
+    }
+}
+
+void
+ejf_memfd_handle_release(struct fuse_file_info *ffi)
+{
+    if (ffi->fh) {
+        close((int) (ffi->fh - 1));
+        ffi->fh = 0;
+    }
+}
+
+int
+ejf_memfd_read_buf(struct EjFuseRequest *efr, const char *path, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *ffi)
+{
+    if (!ffi || !ffi->fh) return -ENOSYS;
+    int fd = (int) (ffi->fh - 1);
+    struct stat stb;
+    if (fstat(fd, &stb) < 0) return -EIO;
+    if (off < 0 || off >= stb.st_size) {
+        size = 0;
+    } else if (stb.st_size - off < size) {
+        size = stb.st_size - off;
+    }
+    struct fuse_bufvec *bufv = malloc(sizeof(*bufv));
+    if (!bufv) return -ENOMEM;
+    *bufv = FUSE_BUFVEC_INIT(size);
+    if (size > 0) {
+        bufv->buf[0].flags = FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK;
+        bufv->buf[0].fd = fd;
+        bufv->buf[0].pos = off;
+    }
+    *bufp = bufv;
+    return 0;
+}
+
 // generic operations
 const struct EjFuseOperations __attribute__((unused)) ejfuse_generic_operations =
 {
@@ -69,5 +69,15 @@ int ejf_generic_read_buf(struct EjFuseRequest *efr, const char *path, struct fus
 int ejf_generic_flock(struct EjFuseRequest *efr, const char *path, struct fuse_file_info *ffi, int op);
 int ejf_generic_fallocate(struct EjFuseRequest *efr, const char *path, int arg3, off_t arg4, off_t arg5, struct fuse_file_info *ffi);
 
+struct EjDirListing;
+/* pass a pre-rendered directory listing to filler */
+void ejf_fill_dir_listing(const struct EjDirListing *edl, void *buf, fuse_fill_dir_t filler);
+
+/* file handles holding a dup of a memfd-backed blob, ffi->fh is 0 otherwise */
+void ejf_memfd_handle_open(struct fuse_file_info *ffi, int fd);
+void ejf_memfd_handle_release(struct fuse_file_info *ffi);
+/* read_buf for such handles, returns -ENOSYS if ffi->fh holds no memfd */
+int ejf_memfd_read_buf(struct EjFuseRequest *efr, const char *path, struct fuse_bufvec **bufp, size_t size, off_t off, struct fuse_file_info *ffi);
+
 // generic operations
 extern const struct EjFuseOperations ejfuse_generic_operations;
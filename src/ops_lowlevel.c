@@ -0,0 +1,1221 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ops_lowlevel.h"
+#include "ops_fuse.h"
+#include "ops_root.h"
+#include "ops_cnts_log.h"
+#include "ops_cnts_prob_runs.h"
+#include "ops_cnts_prob_runs_run.h"
+#include "ops_cnts_prob_runs_run_files.h"
+#include "ops_cnts_prob_runs_run_tests.h"
+#include "ops_cnts_prob_runs_run_tests_test.h"
+#include "ops_cnts_prob_runs_run_tests_test_files.h"
+#include "ejfuse.h"
+#include "ejudge.h"
+#include "contests_state.h"
+#include "dir_listing.h"
+#include "inode_code.h"
+#include "settings.h"
+
+#include <fuse_lowlevel.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+
+/*
+ * A node is created by the first lookup of a path and lives until the
+ * kernel forgets all its lookups. The request kept in the node has the
+ * ops and the ids resolved by ejf_process_child, the object states are
+ * re-acquired by ejf_process_bind for each request. The kernel does not
+ * send requests for a node after forgetting it, so a node found in the
+ * table stays valid until the request completes.
+ */
+struct EjLowNode
+{
+    struct EjLowNode *next;         // hash chain
+    unsigned long long ino;
+    unsigned long long nlookup;
+    struct EjFuseRequest rq;        // no object states, file_name points to name
+    const unsigned char *name;      // the last path component
+    unsigned char path[];
+};
+
+/* a pending kernel cache invalidation */
+struct EjLowInvalItem
+{
+    struct EjLowInvalItem *next;
+    unsigned long long ino;         // the node or the parent directory of name
+    unsigned char *name;            // NULL - invalidate the node
+};
+
+struct EjLowInvalidation
+{
+    struct EjLowInvalItem *first;
+    struct EjLowInvalItem *last;
+};
+
+struct EjLowNodes
+{
+    pthread_mutex_t m;
+    size_t size;                    // power of 2
+    size_t count;
+    struct EjLowNode **table;
+
+    // invalidations are sent from a separate thread, as sending them
+    // from a request handler may deadlock with the kernel
+    struct fuse_chan *ch;
+    pthread_mutex_t inval_m;
+    pthread_cond_t inval_c;
+    struct EjLowInvalidation inval;
+    _Bool inval_stop;
+    _Bool inval_started;
+    pthread_t inval_thread;
+};
+
+enum { LOW_NODES_INITIAL_SIZE = 1024 };
+
+static size_t
+low_nodes_bucket(size_t size, unsigned long long ino)
+{
+    return (size_t) ((ino * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+}
+
+static struct EjLowNode *
+low_node_create(unsigned long long ino, const struct EjFuseRequest *rq, const unsigned char *path)
+{
+    size_t len = strlen(path);
+    struct EjLowNode *eln = calloc(1, sizeof(*eln) + len + 1);
+    memcpy(eln->path, path, len + 1);
+    const unsigned char *slash = strrchr(eln->path, '/');
+    eln->name = slash ? slash + 1 : eln->path;
+    eln->ino = ino;
+    eln->nlookup = 1;
+    eln->rq.ops = rq->ops;
+    eln->rq.contest_id = rq->contest_id;
+    eln->rq.file_name = rq->file_name ? eln->name : NULL;
+    eln->rq.file_name_code = rq->file_name_code;
+    eln->rq.prob_id = rq->prob_id;
+    eln->rq.lang_id = rq->lang_id;
+    eln->rq.run_id = rq->run_id;
+    eln->rq.num = rq->num;
+    eln->rq.test_file_index = rq->test_file_index;
+    return eln;
+}
+
+static void
+low_inval_free(struct EjLowInvalidation *eli)
+{
+    struct EjLowInvalItem *item = eli->first;
+    while (item) {
+        struct EjLowInvalItem *next = item->next;
+        free(item->name);
+        free(item);
+        item = next;
+    }
+    eli->first = eli->last = NULL;
+}
+
+static void
+low_inval_add(struct EjLowInvalidation *eli, unsigned long long ino, const unsigned char *name)
+{
+    struct EjLowInvalItem *item = calloc(1, sizeof(*item));
+    item->ino = ino;
+    if (name) item->name = strdup(name);
+    if (eli->last) {
+        eli->last->next = item;
+    } else {
+        eli->first = item;
+    }
+    eli->last = item;
+}
+
+static struct EjLowNodes *
+low_nodes_create(void)
+{
+    struct EjLowNodes *elns = calloc(1, sizeof(*elns));
+    pthread_mutex_init(&elns->m, NULL);
+    pthread_mutex_init(&elns->inval_m, NULL);
+    pthread_cond_init(&elns->inval_c, NULL);
+    elns->size = LOW_NODES_INITIAL_SIZE;
+    elns->table = calloc(elns->size, sizeof(elns->table[0]));
+
+    struct EjFuseRequest rq = { .ops = &ejfuse_root_operations };
+    struct EjLowNode *root = low_node_create(FUSE_ROOT_ID, &rq, "/");
+    elns->table[low_nodes_bucket(elns->size, root->ino)] = root;
+    elns->count = 1;
+    return elns;
+}
+
+static void
+low_nodes_free(struct EjLowNodes *elns)
+{
+    if (!elns) return;
+    for (size_t i = 0; i < elns->size; ++i) {
+        struct EjLowNode *eln = elns->table[i];
+        while (eln) {
+            struct EjLowNode *next = eln->next;
+            free(eln);
+            eln = next;
+        }
+    }
+    free(elns->table);
+    low_inval_free(&elns->inval);
+    pthread_cond_destroy(&elns->inval_c);
+    pthread_mutex_destroy(&elns->inval_m);
+    pthread_mutex_destroy(&elns->m);
+    free(elns);
+}
+
+static struct EjLowNode *
+low_nodes_find_unlocked(struct EjLowNodes *elns, unsigned long long ino)
+{
+    struct EjLowNode *eln = elns->table[low_nodes_bucket(elns->size, ino)];
+    while (eln && eln->ino != ino) eln = eln->next;
+    return eln;
+}
+
+static struct EjLowNode *
+low_nodes_get(struct EjLowNodes *elns, unsigned long long ino)
+{
+    pthread_mutex_lock(&elns->m);
+    struct EjLowNode *eln = low_nodes_find_unlocked(elns, ino);
+    pthread_mutex_unlock(&elns->m);
+    return eln;
+}
+
+static void
+low_nodes_grow_unlocked(struct EjLowNodes *elns)
+{
+    size_t new_size = elns->size * 2;
+    struct EjLowNode **new_table = calloc(new_size, sizeof(new_table[0]));
+    if (!new_table) return;
+    for (size_t i = 0; i < elns->size; ++i) {
+        struct EjLowNode *eln = elns->table[i];
+        while (eln) {
+            struct EjLowNode *next = eln->next;
+            size_t b = low_nodes_bucket(new_size, eln->ino);
+            eln->next = new_table[b];
+            new_table[b] = eln;
+            eln = next;
+        }
+    }
+    free(elns->table);
+    elns->table = new_table;
+    elns->size = new_size;
+}
+
+/* a successful lookup of 'path' resolved to 'rq' */
+static void
+low_nodes_ref(
+        struct EjLowNodes *elns,
+        unsigned long long ino,
+        const struct EjFuseRequest *rq,
+        const unsigned char *path)
+{
+    pthread_mutex_lock(&elns->m);
+    struct EjLowNode *eln = low_nodes_find_unlocked(elns, ino);
+    if (eln) {
+        ++eln->nlookup;
+        pthread_mutex_unlock(&elns->m);
+        return;
+    }
+    eln = low_node_create(ino, rq, path);
+    size_t b = low_nodes_bucket(elns->size, ino);
+    eln->next = elns->table[b];
+    elns->table[b] = eln;
+    if (++elns->count > elns->size) {
+        low_nodes_grow_unlocked(elns);
+    }
+    pthread_mutex_unlock(&elns->m);
+}
+
+static void
+low_nodes_forget(struct EjLowNodes *elns, unsigned long long ino, unsigned long long nlookup)
+{
+    if (ino == FUSE_ROOT_ID) return;
+
+    pthread_mutex_lock(&elns->m);
+    struct EjLowNode **pp = &elns->table[low_nodes_bucket(elns->size, ino)];
+    while (*pp && (*pp)->ino != ino) pp = &(*pp)->next;
+    struct EjLowNode *eln = *pp;
+    if (!eln) {
+        pthread_mutex_unlock(&elns->m);
+        return;
+    }
+    if (eln->nlookup > nlookup) {
+        eln->nlookup -= nlookup;
+        pthread_mutex_unlock(&elns->m);
+        return;
+    }
+    *pp = eln->next;
+    --elns->count;
+    pthread_mutex_unlock(&elns->m);
+    free(eln);
+}
+
+/*
+Request handling
+ */
+struct EjLowRequest
+{
+    struct EjFuseRequest rq;
+    struct fuse_context fx;
+    struct EjLowNode *node;
+};
+
+static int
+low_request_init(fuse_req_t req, fuse_ino_t ino, struct EjLowRequest *elr)
+{
+    struct EjFuseState *efs = fuse_req_userdata(req);
+    const struct fuse_ctx *ctx = fuse_req_ctx(req);
+
+    memset(elr, 0, sizeof(*elr));
+    if (!(elr->node = low_nodes_get(efs->low_nodes, ino))) {
+        return -ENOENT;
+    }
+    elr->rq = elr->node->rq;
+    elr->fx.uid = ctx->uid;
+    elr->fx.gid = ctx->gid;
+    elr->fx.pid = ctx->pid;
+    elr->fx.umask = ctx->umask;
+    elr->fx.private_data = efs;
+    elr->rq.fx = &elr->fx;
+    elr->rq.efs = efs;
+    elr->rq.current_time_us = get_current_time();
+    return ejf_process_bind(&elr->rq);
+}
+
+/* resolves the entry 'name' of the directory 'parent', path receives its full path */
+static int
+low_request_init_child(
+        fuse_req_t req,
+        fuse_ino_t parent,
+        const char *name,
+        struct EjLowRequest *elr,
+        unsigned char *path,
+        size_t size)
+{
+    int r = low_request_init(req, parent, elr);
+    if (r < 0) return r;
+    const unsigned char *dir = elr->node->ino == FUSE_ROOT_ID ? (const unsigned char *) "" : elr->node->path;
+    int len = snprintf(path, size, "%s/%s", dir, name);
+    if (len < 0 || (size_t) len >= size) return -ENAMETOOLONG;
+    return ejf_process_child(&elr->rq, name);
+}
+
+static _Bool
+run_is_final(struct EjRunState *ers)
+{
+    if (!ers) return 0;
+    struct EjRunInfo *eri = run_info_read_lock(ers);
+    _Bool retval = eri && eri->ok
+        && eri->status < RUN_TRANSIENT_FIRST
+        && eri->status != RUN_PENDING
+        && eri->status != RUN_PENDING_REVIEW;
+    run_info_read_unlock(eri);
+    return retval;
+}
+
+/*
+ * Nodes which may change without an invalidation get the short timeout.
+ * The nodes of finished runs change only on rejudge, then run_info_set
+ * invalidates them, so they get the long timeout.
+ */
+static double
+low_request_timeout(const struct EjFuseRequest *efr)
+{
+    const struct EjFuseOperations *ops = efr->ops;
+    long long timeout_ms = EJFUSE_LL_TIMEOUT_MS;
+    if (ops == &ejfuse_contest_log_operations || ops == &ejfuse_contest_problem_runs_operations) {
+        timeout_ms = EJFUSE_LL_SHORT_TIMEOUT_MS;
+    } else if (ops == &ejfuse_contest_problem_runs_run_files_operations && efr->file_name_code == FILE_NAME_SOURCE) {
+        timeout_ms = EJFUSE_LL_LONG_TIMEOUT_MS;
+    } else if (ops == &ejfuse_contest_problem_runs_run_operations) {
+        if (efr->ecs && run_is_final(run_states_get(efr->ecs->run_states, efr->run_id))) {
+            timeout_ms = EJFUSE_LL_LONG_TIMEOUT_MS;
+        }
+    } else if (ops == &ejfuse_contest_problem_runs_run_files_operations
+               || ops == &ejfuse_contest_problem_runs_run_tests_operations
+               || ops == &ejfuse_contest_problem_runs_run_tests_test_operations
+               || ops == &ejfuse_contest_problem_runs_run_tests_test_files_operations) {
+        if (run_is_final(efr->ers)) {
+            timeout_ms = EJFUSE_LL_LONG_TIMEOUT_MS;
+        }
+    }
+    return timeout_ms / 1000.0;
+}
+
+/* fills the entry reply for a resolved child and references its node */
+static int
+low_make_entry(
+        struct EjLowRequest *elr,
+        const unsigned char *path,
+        struct fuse_file_info *ffi,
+        struct fuse_entry_param *e)
+{
+    int r;
+
+    memset(e, 0, sizeof(*e));
+    if (ffi && elr->rq.ops->fgetattr) {
+        r = elr->rq.ops->fgetattr(&elr->rq, path, &e->attr, ffi);
+    } else if (elr->rq.ops->getattr) {
+        r = elr->rq.ops->getattr(&elr->rq, path, &e->attr);
+    } else {
+        r = -ENOSYS;
+    }
+    if (r < 0) return r;
+
+    // the node id is the inode number of the object, so the nodes can be
+    // invalidated by the inode numbers kept in the object states
+    unsigned long long ino = e->attr.st_ino;
+    if (!ino) ino = get_inode(elr->rq.efs, path);
+    low_nodes_ref(elr->rq.efs->low_nodes, ino, &elr->rq, path);
+    e->ino = ino;
+    e->attr_timeout = low_request_timeout(&elr->rq);
+    e->entry_timeout = e->attr_timeout;
+    return 0;
+}
+
+static void
+low_reply_entry(fuse_req_t req, const struct fuse_entry_param *e)
+{
+    if (fuse_reply_entry(req, e) != 0) {
+        // the kernel did not get the reply, so it will not forget the node
+        struct EjFuseState *efs = fuse_req_userdata(req);
+        low_nodes_forget(efs->low_nodes, e->ino, 1);
+    }
+}
+
+/* the directory contents are rendered on the first readdir and kept in ffi->fh */
+struct EjLowDirBuf
+{
+    fuse_req_t req;
+    size_t size;
+    size_t reserved;
+    char *data;
+};
+
+static int
+low_dir_filler(void *buf, const char *name, const struct stat *stb, off_t off)
+{
+    struct EjLowDirBuf *eldb = buf;
+    size_t entsize = fuse_add_direntry(eldb->req, NULL, 0, name, NULL, 0);
+    if (eldb->size + entsize > eldb->reserved) {
+        size_t new_reserved = eldb->reserved ? eldb->reserved * 2 : 4096;
+        while (new_reserved < eldb->size + entsize) new_reserved *= 2;
+        char *new_data = realloc(eldb->data, new_reserved);
+        if (!new_data) return 1;
+        eldb->data = new_data;
+        eldb->reserved = new_reserved;
+    }
+    fuse_add_direntry(eldb->req, eldb->data + eldb->size, entsize, name, stb, eldb->size + entsize);
+    eldb->size += entsize;
+    return 0;
+}
+
+static void
+low_dir_buf_free(struct EjLowDirBuf *eldb)
+{
+    if (eldb) {
+        free(eldb->data);
+        free(eldb);
+    }
+}
+
+/*
+Low-level FUSE requests
+ */
+static void *
+low_inval_thread_func(void *arg)
+{
+    struct EjLowNodes *elns = arg;
+
+    pthread_mutex_lock(&elns->inval_m);
+    while (1) {
+        while (!elns->inval_stop && !elns->inval.first) {
+            pthread_cond_wait(&elns->inval_c, &elns->inval_m);
+        }
+        if (elns->inval_stop) break;
+        struct EjLowInvalidation eli = elns->inval;
+        elns->inval.first = elns->inval.last = NULL;
+        pthread_mutex_unlock(&elns->inval_m);
+
+        for (struct EjLowInvalItem *item = eli.first; item; item = item->next) {
+            // nodes the kernel does not know need no invalidation
+            if (!low_nodes_get(elns, item->ino)) continue;
+            if (item->name) {
+                fuse_lowlevel_notify_inval_entry(elns->ch, item->ino, item->name, strlen(item->name));
+            } else {
+                fuse_lowlevel_notify_inval_inode(elns->ch, item->ino, 0, 0);
+            }
+        }
+        low_inval_free(&eli);
+
+        pthread_mutex_lock(&elns->inval_m);
+    }
+    pthread_mutex_unlock(&elns->inval_m);
+    return NULL;
+}
+
+static void
+ejf_ll_init(void *userdata, struct fuse_conn_info *conn)
+{
+    struct EjFuseState *efs = userdata;
+    struct EjLowNodes *elns = efs->low_nodes;
+    ejf_entry_start(efs);
+    // without -o splice_write/splice_move libfuse copies the read data from the memfd,
+    // without -o splice_read write_buf gets the written data in memory
+    conn->want |= conn->capable & (FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE | FUSE_CAP_SPLICE_READ);
+    if (!pthread_create(&elns->inval_thread, NULL, low_inval_thread_func, elns)) {
+        elns->inval_started = 1;
+    } else {
+        fprintf(stderr, "failed to start the invalidation thread\n");
+    }
+}
+
+static void
+ejf_ll_destroy(void *userdata)
+{
+    struct EjFuseState *efs = userdata;
+    struct EjLowNodes *elns = efs->low_nodes;
+    // the refresh threads queue invalidations, so they are stopped first
+    ejf_entry_stop(efs);
+    if (!elns->inval_started) return;
+    pthread_mutex_lock(&elns->inval_m);
+    elns->inval_stop = 1;
+    pthread_cond_signal(&elns->inval_c);
+    pthread_mutex_unlock(&elns->inval_m);
+    pthread_join(elns->inval_thread, NULL);
+    elns->inval_started = 0;
+}
+
+static void
+ejf_ll_lookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    struct fuse_entry_param e;
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0) {
+        r = low_make_entry(&elr, path, NULL, &e);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        low_reply_entry(req, &e);
+    }
+}
+
+static void
+ejf_ll_forget(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+{
+    struct EjFuseState *efs = fuse_req_userdata(req);
+    low_nodes_forget(efs->low_nodes, ino, nlookup);
+    fuse_reply_none(req);
+}
+
+static void
+ejf_ll_forget_multi(fuse_req_t req, size_t count, struct fuse_forget_data *forgets)
+{
+    struct EjFuseState *efs = fuse_req_userdata(req);
+    for (size_t i = 0; i < count; ++i) {
+        low_nodes_forget(efs->low_nodes, forgets[i].ino, forgets[i].nlookup);
+    }
+    fuse_reply_none(req);
+}
+
+static int
+low_getattr(struct EjLowRequest *elr, struct stat *stb, struct fuse_file_info *ffi)
+{
+    memset(stb, 0, sizeof(*stb));
+    if (ffi && elr->rq.ops->fgetattr) {
+        return elr->rq.ops->fgetattr(&elr->rq, elr->node->path, stb, ffi);
+    }
+    if (!elr->rq.ops->getattr) {
+        return -ENOSYS;
+    }
+    return elr->rq.ops->getattr(&elr->rq, elr->node->path, stb);
+}
+
+static void
+ejf_ll_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    struct stat stb;
+    double timeout = 0;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0) {
+        r = low_getattr(&elr, &stb, ffi);
+        timeout = low_request_timeout(&elr.rq);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        fuse_reply_attr(req, &stb, timeout);
+    }
+}
+
+static int
+low_setattr(struct EjLowRequest *elr, const struct stat *attr, int to_set, struct fuse_file_info *ffi)
+{
+    const struct EjFuseOperations *ops = elr->rq.ops;
+    const unsigned char *path = elr->node->path;
+    int r;
+
+    if ((to_set & FUSE_SET_ATTR_MODE)) {
+        if (!ops->chmod) return -ENOSYS;
+        if ((r = ops->chmod(&elr->rq, path, attr->st_mode)) < 0) return r;
+    }
+    if ((to_set & FUSE_SET_ATTR_SIZE)) {
+        if (ffi && ops->ftruncate) {
+            r = ops->ftruncate(&elr->rq, path, attr->st_size, ffi);
+        } else if (ops->truncate) {
+            r = ops->truncate(&elr->rq, path, attr->st_size);
+        } else {
+            r = -ENOSYS;
+        }
+        if (r < 0) return r;
+    }
+    if ((to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME))) {
+        struct timespec tv[2] =
+        {
+            { 0, UTIME_OMIT },
+            { 0, UTIME_OMIT },
+        };
+        if ((to_set & FUSE_SET_ATTR_ATIME_NOW)) {
+            tv[0].tv_nsec = UTIME_NOW;
+        } else if ((to_set & FUSE_SET_ATTR_ATIME)) {
+            tv[0] = attr->st_atim;
+        }
+        if ((to_set & FUSE_SET_ATTR_MTIME_NOW)) {
+            tv[1].tv_nsec = UTIME_NOW;
+        } else if ((to_set & FUSE_SET_ATTR_MTIME)) {
+            tv[1] = attr->st_mtim;
+        }
+        if (!ops->utimens) return -ENOSYS;
+        if ((r = ops->utimens(&elr->rq, path, tv)) < 0) return r;
+    }
+    return 0;
+}
+
+static void
+ejf_ll_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    struct stat stb;
+    double timeout = 0;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0) {
+        r = low_setattr(&elr, attr, to_set, ffi);
+    }
+    if (r >= 0) {
+        r = low_getattr(&elr, &stb, ffi);
+        timeout = low_request_timeout(&elr.rq);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        fuse_reply_attr(req, &stb, timeout);
+    }
+}
+
+static void
+ejf_ll_mknod(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, dev_t rdev)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    struct fuse_entry_param e;
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0 && !elr.rq.ops->mknod) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->mknod(&elr.rq, path, mode, rdev);
+    }
+    if (r >= 0) {
+        r = low_make_entry(&elr, path, NULL, &e);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        low_reply_entry(req, &e);
+    }
+}
+
+static void
+ejf_ll_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    struct fuse_entry_param e;
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0 && !elr.rq.ops->mkdir) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->mkdir(&elr.rq, path, mode);
+    }
+    if (r >= 0) {
+        r = low_make_entry(&elr, path, NULL, &e);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        low_reply_entry(req, &e);
+    }
+}
+
+static void
+ejf_ll_unlink(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0 && !elr.rq.ops->unlink) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->unlink(&elr.rq, path);
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_rmdir(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0 && !elr.rq.ops->rmdir) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->rmdir(&elr.rq, path);
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_rename(fuse_req_t req, fuse_ino_t parent, const char *name, fuse_ino_t newparent, const char *newname)
+{
+    struct EjFuseState *efs = fuse_req_userdata(req);
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    unsigned char newpath[PATH_MAX];
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0) {
+        struct EjLowNode *eln = low_nodes_get(efs->low_nodes, newparent);
+        if (!eln) {
+            r = -ENOENT;
+        } else {
+            const unsigned char *dir = eln->ino == FUSE_ROOT_ID ? (const unsigned char *) "" : eln->path;
+            int len = snprintf(newpath, sizeof(newpath), "%s/%s", dir, newname);
+            if (len < 0 || (size_t) len >= sizeof(newpath)) r = -ENAMETOOLONG;
+        }
+    }
+    if (r >= 0 && !elr.rq.ops->rename) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->rename(&elr.rq, path, newpath);
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && !elr.rq.ops->open) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->open(&elr.rq, elr.node->path, ffi);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else if (fuse_reply_open(req, ffi) != 0 && elr.rq.ops->release) {
+        // the open was interrupted
+        elr.rq.ops->release(&elr.rq, elr.node->path, ffi);
+    }
+}
+
+static void
+ejf_ll_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    char *buf = NULL;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && elr.rq.ops->read_buf) {
+        struct fuse_bufvec *bufv = NULL;
+        r = elr.rq.ops->read_buf(&elr.rq, elr.node->path, &bufv, size, off, ffi);
+        if (r != -ENOSYS) {
+            r = request_free(&elr.rq, r);
+            if (r < 0) {
+                fuse_reply_err(req, -r);
+            } else {
+                // memfd-backed buffers are spliced to the kernel
+                fuse_reply_data(req, bufv, FUSE_BUF_SPLICE_MOVE);
+            }
+            free(bufv);
+            return;
+        }
+        r = 0;
+    }
+    if (r >= 0 && !elr.rq.ops->read) {
+        r = -ENOSYS;
+    }
+    if (r >= 0 && !(buf = malloc(size + 1))) {
+        r = -ENOMEM;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->read(&elr.rq, elr.node->path, buf, size, off, ffi);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        fuse_reply_buf(req, buf, r);
+    }
+    free(buf);
+}
+
+static void
+ejf_ll_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size, off_t off, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && !elr.rq.ops->write) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->write(&elr.rq, elr.node->path, buf, size, off, ffi);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        fuse_reply_write(req, r);
+    }
+}
+
+static void
+ejf_ll_write_buf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv, off_t off, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && elr.rq.ops->write_buf) {
+        r = elr.rq.ops->write_buf(&elr.rq, elr.node->path, bufv, off, ffi);
+        if (r != -ENOSYS) goto done;
+        r = 0;
+    }
+    if (r >= 0 && !elr.rq.ops->write) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        size_t size = fuse_buf_size(bufv);
+        struct fuse_bufvec mem = FUSE_BUFVEC_INIT(size);
+        if (!(mem.buf[0].mem = malloc(size + 1))) {
+            r = -ENOMEM;
+            goto done;
+        }
+        ssize_t copied = fuse_buf_copy(&mem, bufv, 0);
+        if (copied < 0) {
+            r = copied;
+        } else {
+            r = elr.rq.ops->write(&elr.rq, elr.node->path, mem.buf[0].mem, copied, off, ffi);
+        }
+        free(mem.buf[0].mem);
+    }
+
+done:
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        fuse_reply_write(req, r);
+    }
+}
+
+static void
+ejf_ll_flush(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && !elr.rq.ops->flush) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->flush(&elr.rq, elr.node->path, ffi);
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    // the handle is released even if the node does not resolve any more,
+    // the ops of the stored request own ffi->fh
+    int r = low_request_init(req, ino, &elr);
+    if (elr.node) {
+        r = -ENOSYS;
+        if (elr.rq.ops && elr.rq.ops->release) {
+            r = elr.rq.ops->release(&elr.rq, elr.node->path, ffi);
+        }
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && !elr.rq.ops->opendir) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->opendir(&elr.rq, elr.node->path, ffi);
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else {
+        ffi->fh = 0;
+        fuse_reply_open(req, ffi);
+    }
+}
+
+static void
+ejf_ll_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off, struct fuse_file_info *ffi)
+{
+    struct EjLowDirBuf *eldb = (struct EjLowDirBuf *) (uintptr_t) ffi->fh;
+    if (!eldb || !off) {
+        // (re)read the directory from the start
+        struct EjLowRequest elr;
+        int r = low_request_init(req, ino, &elr);
+        if (r >= 0 && !elr.rq.ops->readdir) {
+            r = -ENOSYS;
+        }
+        struct EjLowDirBuf *new_eldb = NULL;
+        if (r >= 0) {
+            new_eldb = calloc(1, sizeof(*new_eldb));
+            new_eldb->req = req;
+            r = elr.rq.ops->readdir(&elr.rq, elr.node->path, new_eldb, low_dir_filler, 0, ffi);
+        }
+        r = request_free(&elr.rq, r);
+        if (r < 0) {
+            low_dir_buf_free(new_eldb);
+            fuse_reply_err(req, -r);
+            return;
+        }
+        low_dir_buf_free(eldb);
+        eldb = new_eldb;
+        ffi->fh = (uintptr_t) eldb;
+    }
+    if (off < 0 || (size_t) off >= eldb->size) {
+        fuse_reply_buf(req, NULL, 0);
+    } else {
+        size_t len = eldb->size - off;
+        if (len > size) len = size;
+        fuse_reply_buf(req, eldb->data + off, len);
+    }
+}
+
+static void
+ejf_ll_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    low_dir_buf_free((struct EjLowDirBuf *) (uintptr_t) ffi->fh);
+    ffi->fh = 0;
+    // as in release, the node does not have to resolve any more
+    int r = low_request_init(req, ino, &elr);
+    if (elr.node) {
+        r = -ENOSYS;
+        if (elr.rq.ops && elr.rq.ops->releasedir) {
+            r = elr.rq.ops->releasedir(&elr.rq, elr.node->path, ffi);
+        }
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_access(fuse_req_t req, fuse_ino_t ino, int mask)
+{
+    struct EjLowRequest elr;
+    int r = low_request_init(req, ino, &elr);
+    if (r >= 0 && !elr.rq.ops->access) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->access(&elr.rq, elr.node->path, mask);
+    }
+    r = request_free(&elr.rq, r);
+    fuse_reply_err(req, r < 0 ? -r : 0);
+}
+
+static void
+ejf_ll_create(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode, struct fuse_file_info *ffi)
+{
+    struct EjLowRequest elr;
+    unsigned char path[PATH_MAX];
+    struct fuse_entry_param e;
+    int r = low_request_init_child(req, parent, name, &elr, path, sizeof(path));
+    if (r >= 0 && !elr.rq.ops->create) {
+        r = -ENOSYS;
+    }
+    if (r >= 0) {
+        r = elr.rq.ops->create(&elr.rq, path, mode, ffi);
+        if (r >= 0 && (r = low_make_entry(&elr, path, ffi, &e)) < 0 && elr.rq.ops->release) {
+            elr.rq.ops->release(&elr.rq, path, ffi);
+        }
+    }
+    r = request_free(&elr.rq, r);
+    if (r < 0) {
+        fuse_reply_err(req, -r);
+    } else if (fuse_reply_create(req, &e, ffi) != 0) {
+        struct EjFuseState *efs = fuse_req_userdata(req);
+        if (elr.rq.ops->release) {
+            elr.rq.ops->release(&elr.rq, path, ffi);
+        }
+        low_nodes_forget(efs->low_nodes, e.ino, 1);
+    }
+}
+
+static const struct fuse_lowlevel_ops ejf_lowlevel_operations =
+{
+    .init = ejf_ll_init,
+    .destroy = ejf_ll_destroy,
+    .lookup = ejf_ll_lookup,
+    .forget = ejf_ll_forget,
+    .getattr = ejf_ll_getattr,
+    .setattr = ejf_ll_setattr,
+    .mknod = ejf_ll_mknod,
+    .mkdir = ejf_ll_mkdir,
+    .unlink = ejf_ll_unlink,
+    .rmdir = ejf_ll_rmdir,
+    .rename = ejf_ll_rename,
+    .open = ejf_ll_open,
+    .read = ejf_ll_read,
+    .write = ejf_ll_write,
+    .write_buf = ejf_ll_write_buf,
+    .flush = ejf_ll_flush,
+    .release = ejf_ll_release,
+    .opendir = ejf_ll_opendir,
+    .readdir = ejf_ll_readdir,
+    .releasedir = ejf_ll_releasedir,
+    .access = ejf_ll_access,
+    .create = ejf_ll_create,
+    .forget_multi = ejf_ll_forget_multi,
+};
+
+/*
+Kernel cache invalidation
+ */
+// the first run entry of a runs listing
+static const struct EjDirEntry *
+runs_listing_first(const struct EjDirListing *edl)
+{
+    const struct EjDirEntry *ede = dir_listing_first(edl);
+    if (ede) ede = dir_listing_next(edl, ede);      // "."
+    if (ede) ede = dir_listing_next(edl, ede);      // ".."
+    return ede;
+}
+
+struct EjLowInvalidation *
+ejf_lowlevel_runs_changes(
+        struct EjFuseState *efs,
+        struct EjProblemState *eps,
+        const struct EjProblemRuns *eprs)
+{
+    if (!efs->low_nodes) return NULL;
+
+    const struct EjDirListing *new_listing = eprs->ok ? eprs->listing : NULL;
+    struct EjProblemRuns *old = problem_runs_read_lock(eps);
+    const struct EjDirListing *old_listing = (old && old->ok) ? old->listing : NULL;
+    if (!old_listing && !new_listing) {
+        problem_runs_read_unlock(old);
+        return NULL;
+    }
+    if (old_listing && new_listing && old_listing->size == new_listing->size
+        && !memcmp(old_listing->data, new_listing->data, new_listing->size)) {
+        problem_runs_read_unlock(old);
+        return NULL;
+    }
+
+    struct EjLowInvalidation *eli = calloc(1, sizeof(*eli));
+    low_inval_add(eli, eps->runs_inode, NULL);
+    // the run directory names carry the run status, so the old names go away,
+    // both listings have an entry per run after "." and "..", sorted by run id
+    if (old_listing) {
+        const struct EjDirEntry *ede = runs_listing_first(old_listing);
+        const struct EjDirEntry *nde = new_listing ? runs_listing_first(new_listing) : NULL;
+        int new_size = new_listing ? eprs->size : 0;
+        int j = 0;
+        for (int i = 0; i < old->size && ede; ++i, ede = dir_listing_next(old_listing, ede)) {
+            int run_id = old->runs[i].run_id;
+            while (j < new_size && nde && eprs->runs[j].run_id < run_id) {
+                ++j;
+                nde = dir_listing_next(new_listing, nde);
+            }
+            if (j >= new_size || !nde || eprs->runs[j].run_id != run_id || strcmp(ede->name, nde->name)) {
+                low_inval_add(eli, eps->runs_inode, ede->name);
+            }
+        }
+    }
+    problem_runs_read_unlock(old);
+    return eli;
+}
+
+static _Bool
+same_text(const unsigned char *s1, const unsigned char *s2)
+{
+    if (!s1 || !s2) return s1 == s2;
+    return !strcmp(s1, s2);
+}
+
+struct EjLowInvalidation *
+ejf_lowlevel_run_info_changes(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        const struct EjRunInfo *eri)
+{
+    if (!efs->low_nodes) return NULL;
+
+    struct EjRunInfo *old = run_info_read_lock(ers);
+    if (!old) {
+        run_info_read_unlock(old);
+        return NULL;
+    }
+    if (old->ok == eri->ok && same_text(old->info_json_text, eri->info_json_text)) {
+        run_info_read_unlock(old);
+        return NULL;
+    }
+    int test_count = old->test_count;
+    run_info_read_unlock(old);
+
+    struct EjLowInvalidation *eli = calloc(1, sizeof(*eli));
+    low_inval_add(eli, ers->inode, NULL);
+    low_inval_add(eli, ers->info_inode, NULL);
+    low_inval_add(eli, ers->info_json_inode, NULL);
+    low_inval_add(eli, ers->compiler_inode, NULL);
+    low_inval_add(eli, ers->valuer_inode, NULL);
+    low_inval_add(eli, ers->msg_inode, NULL);
+    low_inval_add(eli, ers->tests_inode, NULL);
+    for (int num = 1; num <= test_count; ++num) {
+        low_inval_add(eli, inode_code_make(INODE_KIND_TEST, ecs->cnts_id, ers->run_id, num), NULL);
+        for (int i = 0; i < TESTING_REPORT_LAST; ++i) {
+            low_inval_add(eli, inode_code_make(INODE_KIND_TEST_PART + i, ecs->cnts_id, ers->run_id, num), NULL);
+        }
+    }
+    return eli;
+}
+
+void
+ejf_lowlevel_invalidate(struct EjFuseState *efs, struct EjLowInvalidation *eli)
+{
+    if (!eli) return;
+    struct EjLowNodes *elns = efs->low_nodes;
+    if (!elns || !eli->first) {
+        low_inval_free(eli);
+        free(eli);
+        return;
+    }
+    pthread_mutex_lock(&elns->inval_m);
+    if (elns->inval.last) {
+        elns->inval.last->next = eli->first;
+    } else {
+        elns->inval.first = eli->first;
+    }
+    elns->inval.last = eli->last;
+    pthread_cond_signal(&elns->inval_c);
+    pthread_mutex_unlock(&elns->inval_m);
+    free(eli);
+}
+
+int
+ejf_lowlevel_main(int argc, char *argv[], struct EjFuseState *efs)
+{
+    struct fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    char *mountpoint = NULL;
+    int multithreaded = 0;
+    int foreground = 0;
+    struct fuse_chan *ch = NULL;
+    struct fuse_session *se = NULL;
+    int retval = 1;
+
+    if (fuse_parse_cmdline(&args, &mountpoint, &multithreaded, &foreground) < 0) {
+        goto cleanup;
+    }
+    if (!mountpoint) {
+        fprintf(stderr, "mount point not specified\n");
+        goto cleanup;
+    }
+    efs->low_nodes = low_nodes_create();
+    if (!(ch = fuse_mount(mountpoint, &args))) {
+        goto cleanup;
+    }
+    efs->low_nodes->ch = ch;
+    if (!(se = fuse_lowlevel_new(&args, &ejf_lowlevel_operations, sizeof(ejf_lowlevel_operations), efs))) {
+        goto cleanup;
+    }
+    if (fuse_set_signal_handlers(se) < 0) {
+        goto cleanup;
+    }
+    fuse_session_add_chan(se, ch);
+    if (fuse_daemonize(foreground) >= 0) {
+        if (multithreaded) {
+            retval = fuse_session_loop_mt(se) ? 1 : 0;
+        } else {
+            retval = fuse_session_loop(se) ? 1 : 0;
+        }
+    }
+    fuse_remove_signal_handlers(se);
+    fuse_session_remove_chan(ch);
+
+cleanup:
+    if (se) fuse_session_destroy(se);
+    if (ch) fuse_unmount(mountpoint, ch);
+    low_nodes_free(efs->low_nodes);
+    efs->low_nodes = NULL;
+    free(mountpoint);
+    fuse_opt_free_args(&args);
+    return retval;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Low-level FUSE front end. Lookup resolves one path component at a time
+ * into a node cached by its inode number, the other requests are
+ * dispatched directly through the EjFuseOperations table of the node.
+ */
+
+struct EjFuseState;
+struct EjContestState;
+struct EjProblemState;
+struct EjProblemRuns;
+struct EjRunState;
+struct EjRunInfo;
+struct EjLowInvalidation;
+
+int ejf_lowlevel_main(int argc, char *argv[], struct EjFuseState *efs);
+
+/*
+ * The kernel caches of the nodes affected by a new object are invalidated
+ * in two steps: *_changes compares the new object with the current one
+ * before it is replaced and returns NULL if nothing changed,
+ * ejf_lowlevel_invalidate queues the invalidations after the replacement.
+ * Both do nothing if the low-level front end is not used.
+ */
+struct EjLowInvalidation *
+ejf_lowlevel_runs_changes(
+        struct EjFuseState *efs,
+        struct EjProblemState *eps,
+        const struct EjProblemRuns *eprs);
+struct EjLowInvalidation *
+ejf_lowlevel_run_info_changes(
+        struct EjFuseState *efs,
+        struct EjContestState *ecs,
+        struct EjRunState *ers,
+        const struct EjRunInfo *eri);
+void ejf_lowlevel_invalidate(struct EjFuseState *efs, struct EjLowInvalidation *eli);
@@ -21,6 +21,7 @@
 
 #include "settings.h"
 #include "ejfuse.h"
+#include "inode_code.h"
 #include "ops_generic.h"
 
 #include <errno.h>
@@ -33,7 +34,7 @@ ejf_getattr(struct EjFuseRequest *efr, const char *path, struct stat *stb)
     struct EjFuseState *efs = efr->efs;
 
     memset(stb, 0, sizeof(*stb));
-    stb->st_ino = get_inode(efs, "/");
+    stb->st_ino = inode_code_make(INODE_KIND_ROOT, 0, 0, 0);
     //stb->st_ino = 2;
     stb->st_mode = S_IFDIR | EJFUSE_DIR_PERMS;
     stb->st_nlink = 2;
@@ -94,19 +95,16 @@ ejf_readdir(
     struct EjFuseState *efs = efr->efs;
     struct EjContestList *contests = contest_list_read_lock(efs);
     unsigned char name_buf[NAME_MAX + 1];
-    unsigned char name_path[PATH_MAX];
     struct stat es;
     // add "."
     memset(&es, 0, sizeof(es));
-    es.st_ino = get_inode(efs, "/");
+    es.st_ino = inode_code_make(INODE_KIND_ROOT, 0, 0, 0);
     filler(buf, ".", &es, 0);
     filler(buf, "..", &es, 0);
     for (int i = 0; i < contests->count; ++i) {
         memset(&es, 0, sizeof(es));
-        int res = snprintf(name_path, sizeof(name_path), "/%d", contests->entries[i].id);
-        if (res >= sizeof(name_path)) { abort(); }
-        es.st_ino = get_inode(efs, name_path);
-        res = snprintf(name_buf, sizeof(name_buf), "%d,%s", contests->entries[i].id, contests->entries[i].name);
+        es.st_ino = inode_code_make(INODE_KIND_CONTEST, contests->entries[i].id, 0, 0);
+        int res = snprintf(name_buf, sizeof(name_buf), "%d,%s", contests->entries[i].id, contests->entries[i].name);
         if (res >= sizeof(name_buf)) { abort(); }
         // FIXME: truncate UTF-8 correctly, oh, shit, we abort()!
         filler(buf, fix_name(name_buf), &es, 0);
@@ -0,0 +1,189 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "path_cache.h"
+#include "ejfuse.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+enum
+{
+    PATH_CACHE_SETS = 2048,         // power of 2
+    PATH_CACHE_WAYS = 2,
+    PATH_CACHE_LOCKS = 64,          // power of 2
+};
+
+struct EjPathCacheSlot
+{
+    unsigned long long hash;
+    unsigned char *path;
+    int file_name_offset;           // -1 if no file name
+    const struct EjFuseOperations *ops;
+    int contest_id;
+    struct EjContestState *ecs;
+    int file_name_code;
+    int prob_id;
+    struct EjProblemState *eps;
+    int lang_id;
+    int run_id;
+    struct EjRunState *ers;
+    int num;
+    struct EjRunTest *ert;
+    int test_file_index;
+    unsigned list_gen;
+    unsigned path_gen;
+};
+
+struct EjPathCache
+{
+    struct
+    {
+        pthread_mutex_t m;
+    } __attribute__((aligned(64))) locks[PATH_CACHE_LOCKS];
+    // the most recently inserted entry of a set is in way 0
+    struct EjPathCacheSlot slots[PATH_CACHE_SETS][PATH_CACHE_WAYS];
+};
+
+/* FNV-1a */
+static unsigned long long
+path_hash(const unsigned char *path)
+{
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (; *path; ++path) {
+        hash ^= *path;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static struct EjPathCacheSlot *
+find_slot_unlocked(struct EjPathCacheSlot *set, unsigned long long hash, const unsigned char *path)
+{
+    for (int i = 0; i < PATH_CACHE_WAYS; ++i) {
+        if (set[i].path && set[i].hash == hash && !strcmp(set[i].path, path)) {
+            return &set[i];
+        }
+    }
+    return NULL;
+}
+
+struct EjPathCache *
+path_cache_create(void)
+{
+    struct EjPathCache *epc = NULL;
+    if (posix_memalign((void **) &epc, 64, sizeof(*epc))) {
+        return NULL;
+    }
+    memset(epc, 0, sizeof(*epc));
+    for (int i = 0; i < PATH_CACHE_LOCKS; ++i) {
+        pthread_mutex_init(&epc->locks[i].m, NULL);
+    }
+    return epc;
+}
+
+void
+path_cache_free(struct EjPathCache *epc)
+{
+    if (!epc) return;
+    for (int i = 0; i < PATH_CACHE_SETS; ++i) {
+        for (int j = 0; j < PATH_CACHE_WAYS; ++j) {
+            free(epc->slots[i][j].path);
+        }
+    }
+    for (int i = 0; i < PATH_CACHE_LOCKS; ++i) {
+        pthread_mutex_destroy(&epc->locks[i].m);
+    }
+    free(epc);
+}
+
+int
+path_cache_lookup(struct EjPathCache *epc, const unsigned char *path, struct EjFuseRequest *efr)
+{
+    unsigned long long hash = path_hash(path);
+    unsigned index = hash & (PATH_CACHE_SETS - 1);
+    pthread_mutex_t *m = &epc->locks[index & (PATH_CACHE_LOCKS - 1)].m;
+
+    pthread_mutex_lock(m);
+    struct EjPathCacheSlot *slot = find_slot_unlocked(epc->slots[index], hash, path);
+    if (!slot) {
+        pthread_mutex_unlock(m);
+        return 0;
+    }
+    efr->ops = slot->ops;
+    efr->contest_id = slot->contest_id;
+    efr->ecs = slot->ecs;
+    efr->file_name = slot->file_name_offset >= 0 ? path + slot->file_name_offset : NULL;
+    efr->file_name_code = slot->file_name_code;
+    efr->prob_id = slot->prob_id;
+    efr->eps = slot->eps;
+    efr->lang_id = slot->lang_id;
+    efr->run_id = slot->run_id;
+    efr->ers = slot->ers;
+    efr->num = slot->num;
+    efr->ert = slot->ert;
+    efr->test_file_index = slot->test_file_index;
+    efr->list_gen = slot->list_gen;
+    efr->path_gen = slot->path_gen;
+    pthread_mutex_unlock(m);
+    return 1;
+}
+
+void
+path_cache_insert(struct EjPathCache *epc, const unsigned char *path, const struct EjFuseRequest *efr)
+{
+    unsigned long long hash = path_hash(path);
+    unsigned index = hash & (PATH_CACHE_SETS - 1);
+    struct EjPathCacheSlot *set = epc->slots[index];
+    pthread_mutex_t *m = &epc->locks[index & (PATH_CACHE_LOCKS - 1)].m;
+    unsigned char *path_copy = strdup(path);
+    unsigned char *old_path = NULL;
+    if (!path_copy) return;
+
+    pthread_mutex_lock(m);
+    struct EjPathCacheSlot *slot = find_slot_unlocked(set, hash, path);
+    if (!slot) {
+        // evict the least recently inserted entry
+        slot = &set[0];
+        old_path = set[PATH_CACHE_WAYS - 1].path;
+        memmove(&set[1], &set[0], (PATH_CACHE_WAYS - 1) * sizeof(set[0]));
+    } else {
+        old_path = slot->path;
+    }
+    slot->hash = hash;
+    slot->path = path_copy;
+    slot->file_name_offset = efr->file_name ? (int) (efr->file_name - path) : -1;
+    slot->ops = efr->ops;
+    slot->contest_id = efr->contest_id;
+    slot->ecs = efr->ecs;
+    slot->file_name_code = efr->file_name_code;
+    slot->prob_id = efr->prob_id;
+    slot->eps = efr->eps;
+    slot->lang_id = efr->lang_id;
+    slot->run_id = efr->run_id;
+    slot->ers = efr->ers;
+    slot->num = efr->num;
+    slot->ert = efr->ert;
+    slot->test_file_index = efr->test_file_index;
+    slot->list_gen = efr->list_gen;
+    slot->path_gen = efr->path_gen;
+    pthread_mutex_unlock(m);
+    free(old_path);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cache of the ejf_process_path results keyed by the path string.
+ * The cache is a fixed-size two-way set-associative table, a new entry
+ * evicts the older entry of its set. The entries carry the generation
+ * counters of the contest list and of the contest state at the time of
+ * resolution, the caller checks them before using a cached result.
+ */
+
+struct EjFuseRequest;
+struct EjPathCache;
+
+struct EjPathCache *path_cache_create(void);
+void path_cache_free(struct EjPathCache *epc);
+
+/* returns 1 and fills the resolved fields of efr if the path is cached */
+int path_cache_lookup(struct EjPathCache *epc, const unsigned char *path, struct EjFuseRequest *efr);
+void path_cache_insert(struct EjPathCache *epc, const unsigned char *path, const struct EjFuseRequest *efr);
@@ -0,0 +1,465 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "refresh_thread.h"
+#include "contests_state.h"
+#include "ebr.h"
+#include "ejfuse.h"
+#include "settings.h"
+#include "single_flight.h"
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <stdatomic.h>
+#include <time.h>
+
+struct EjRefreshListItem
+{
+    struct EjRefreshListItem *next;
+    struct EjRefreshItem *item;
+};
+
+struct EjRefreshTimer
+{
+    struct EjTimer timer;       // must be the first
+    struct EjRefreshItem *item;
+};
+
+struct EjRefreshThread
+{
+    struct EjFuseState *efs;
+
+    pthread_t ids[EJFUSE_REFRESH_THREADS];
+    int thread_count;
+    pthread_t sched_id;
+    _Bool sched_started;
+    _Atomic _Bool sched_stop;
+
+    pthread_mutex_t qm;
+    pthread_cond_t qc;
+    struct EjRefreshListItem *qhead, *qtail;
+    _Bool stop_request;                 // protected by qm
+
+    // refresh timers, protected by tm
+    pthread_mutex_t tm;
+    struct EjTimerWheel *wheel;
+};
+
+static long long
+get_current_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+struct EjRefreshThread *
+refresh_thread_create(void)
+{
+    struct EjRefreshThread *rt = calloc(1, sizeof(*rt));
+    pthread_mutex_init(&rt->qm, NULL);
+    pthread_cond_init(&rt->qc, NULL);
+    pthread_mutex_init(&rt->tm, NULL);
+    rt->wheel = timer_wheel_create(get_current_time_us() / EJFUSE_REFRESH_TICK);
+    return rt;
+}
+
+void
+refresh_thread_free(struct EjRefreshThread *rt)
+{
+    if (rt) {
+        refresh_thread_stop(rt);
+        while (rt->qhead) {
+            struct EjRefreshListItem *rli = rt->qhead;
+            rt->qhead = rli->next;
+            refresh_item_free(rli->item);
+            free(rli);
+        }
+        struct EjTimer *t = timer_wheel_advance(rt->wheel, rt->wheel->current_tick + (1LL << 62));
+        while (t) {
+            struct EjRefreshTimer *ert = (struct EjRefreshTimer *) t;
+            t = t->next;
+            refresh_item_free(ert->item);
+            free(ert);
+        }
+        timer_wheel_free(rt->wheel);
+        pthread_mutex_destroy(&rt->tm);
+        pthread_cond_destroy(&rt->qc);
+        pthread_mutex_destroy(&rt->qm);
+        free(rt);
+    }
+}
+
+struct EjRefreshItem *
+refresh_item_create(
+        int kind,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        struct EjRunState *ers,
+        struct EjRunTest *ert,
+        int run_id,
+        int index)
+{
+    struct EjRefreshItem *ri = calloc(1, sizeof(*ri));
+    ri->kind = kind;
+    ri->ecs = ecs;
+    ri->eps = eps;
+    ri->ers = ers;
+    ri->ert = ert;
+    ri->run_id = run_id;
+    ri->index = index;
+    return ri;
+}
+
+void
+refresh_item_free(struct EjRefreshItem *ri)
+{
+    free(ri);
+}
+
+void
+refresh_thread_enqueue(struct EjRefreshThread *rt, struct EjRefreshItem *ri)
+{
+    struct EjRefreshListItem *rli = calloc(1, sizeof(*rli));
+    rli->item = ri;
+
+    pthread_mutex_lock(&rt->qm);
+    if (rt->qtail) {
+        rt->qtail->next = rli;
+    } else {
+        rt->qhead = rli;
+    }
+    rt->qtail = rli;
+    pthread_cond_signal(&rt->qc);
+    pthread_mutex_unlock(&rt->qm);
+}
+
+static void
+thread_refresh(struct EjRefreshThread *rt, struct EjRefreshItem *ri)
+{
+    struct EjFuseState *efs = rt->efs;
+    struct EjContestState *ecs = ri->ecs;
+    long long current_time_us = get_current_time_us();
+
+    if (ri->kind == REFRESH_TOP_SESSION) {
+        top_session_refresh(efs, current_time_us);
+        return;
+    }
+    if (ri->kind == REFRESH_CONTEST_SESSION) {
+        contest_session_refresh(efs, ecs, current_time_us);
+        return;
+    }
+
+    contest_session_maybe_update(efs, ecs, current_time_us);
+
+    switch (ri->kind) {
+    case REFRESH_CONTEST_INFO:
+        contest_info_refresh(efs, ecs, current_time_us);
+        break;
+    case REFRESH_PROBLEM_INFO:
+        problem_info_refresh(efs, ecs, ri->eps, current_time_us);
+        break;
+    case REFRESH_PROBLEM_STATEMENT:
+        problem_statement_refresh(efs, ecs, ri->eps, current_time_us);
+        break;
+    case REFRESH_PROBLEM_RUNS:
+        problem_runs_refresh(efs, ecs, ri->eps, current_time_us);
+        break;
+    case REFRESH_RUN_INFO:
+        run_info_refresh(efs, ecs, ri->ers, current_time_us);
+        break;
+    case REFRESH_RUN_SOURCE:
+        run_source_refresh(efs, ecs, ri->ers, current_time_us);
+        break;
+    case REFRESH_RUN_MESSAGES:
+        run_messages_refresh(efs, ecs, ri->ers, current_time_us);
+        break;
+    case REFRESH_RUN_TEST_DATA:
+        run_test_data_refresh(efs, ecs, ri->ert, ri->run_id, ri->index, current_time_us);
+        break;
+    default:
+        abort();
+    }
+}
+
+static void *
+thread_func(void *arg)
+{
+    struct EjRefreshThread *rt = (struct EjRefreshThread *) arg;
+
+    pthread_setname_np(pthread_self(), "REFRESH_THREAD");
+
+    while (1) {
+        pthread_mutex_lock(&rt->qm);
+        while (!rt->qhead && !rt->stop_request) {
+            pthread_cond_wait(&rt->qc, &rt->qm);
+        }
+        if (rt->stop_request) {
+            pthread_mutex_unlock(&rt->qm);
+            break;
+        }
+        struct EjRefreshListItem *rli = rt->qhead;
+        rt->qhead = rli->next;
+        if (!rt->qhead) {
+            rt->qtail = NULL;
+        }
+        pthread_mutex_unlock(&rt->qm);
+        struct EjRefreshItem *ri = rli->item;
+        free(rli); rli = NULL;
+        thread_refresh(rt, ri);
+        refresh_item_free(ri);
+    }
+
+    return NULL;
+}
+
+void
+refresh_thread_schedule(
+        struct EjRefreshThread *rt,
+        struct EjRefreshItem *ri,
+        long long recheck_time_us,
+        long long fire_time_us)
+{
+    struct EjRefreshTimer *ert = calloc(1, sizeof(*ert));
+    ri->recheck_time_us = recheck_time_us;
+    ert->item = ri;
+    ert->timer.expire_tick = fire_time_us / EJFUSE_REFRESH_TICK;
+
+    pthread_mutex_lock(&rt->tm);
+    timer_wheel_add(rt->wheel, &ert->timer);
+    pthread_mutex_unlock(&rt->tm);
+}
+
+static _Atomic long long *
+item_access_time(struct EjRefreshItem *ri)
+{
+    switch (ri->kind) {
+    case REFRESH_CONTEST_INFO:      return &ri->ecs->info.access_us;
+    case REFRESH_PROBLEM_INFO:      return &ri->eps->info.access_us;
+    case REFRESH_PROBLEM_STATEMENT: return &ri->eps->stmt.access_us;
+    case REFRESH_PROBLEM_RUNS:      return &ri->eps->runs.access_us;
+    case REFRESH_RUN_INFO:          return &ri->ers->info.access_us;
+    case REFRESH_RUN_SOURCE:        return &ri->ers->src.access_us;
+    case REFRESH_RUN_MESSAGES:      return &ri->ers->msg.access_us;
+    case REFRESH_RUN_TEST_DATA:     return &ri->ert->parts[ri->index].data.access_us;
+    case REFRESH_TOP_SESSION:       return NULL;
+    case REFRESH_CONTEST_SESSION:   return &ri->ecs->session.access_us;
+    default:
+        abort();
+    }
+}
+
+static _Atomic _Bool *
+item_update_flag(struct EjFuseState *efs, struct EjRefreshItem *ri)
+{
+    switch (ri->kind) {
+    case REFRESH_CONTEST_INFO:      return &ri->ecs->info.update;
+    case REFRESH_PROBLEM_INFO:      return &ri->eps->info.update;
+    case REFRESH_PROBLEM_STATEMENT: return &ri->eps->stmt.update;
+    case REFRESH_PROBLEM_RUNS:      return &ri->eps->runs.update;
+    case REFRESH_RUN_INFO:          return &ri->ers->info.update;
+    case REFRESH_RUN_SOURCE:        return &ri->ers->src.update;
+    case REFRESH_RUN_MESSAGES:      return &ri->ers->msg.update;
+    case REFRESH_RUN_TEST_DATA:     return &ri->ert->parts[ri->index].data.update;
+    case REFRESH_TOP_SESSION:       return &efs->top_session.update;
+    case REFRESH_CONTEST_SESSION:   return &ri->ecs->session.update;
+    default:
+        abort();
+    }
+}
+
+// recheck time of the current object, 0 if the object is not valid
+static long long
+item_recheck_time(struct EjFuseState *efs, struct EjRefreshItem *ri)
+{
+    long long recheck_time_us = 0;
+
+    switch (ri->kind) {
+    case REFRESH_CONTEST_INFO: {
+        struct EjContestInfo *eci = contest_info_read_lock(ri->ecs);
+        if (eci && eci->ok) recheck_time_us = eci->recheck_time_us;
+        contest_info_read_unlock(eci);
+        break;
+    }
+    case REFRESH_PROBLEM_INFO: {
+        struct EjProblemInfo *epi = problem_info_read_lock(ri->eps);
+        if (epi && epi->ok) recheck_time_us = epi->recheck_time_us;
+        problem_info_read_unlock(epi);
+        break;
+    }
+    case REFRESH_PROBLEM_STATEMENT: {
+        struct EjProblemStatement *eph = problem_statement_read_lock(ri->eps);
+        if (eph && eph->ok) recheck_time_us = eph->recheck_time_us;
+        problem_statement_read_unlock(eph);
+        break;
+    }
+    case REFRESH_PROBLEM_RUNS: {
+        struct EjProblemRuns *eprs = problem_runs_read_lock(ri->eps);
+        if (eprs && eprs->ok) recheck_time_us = eprs->recheck_time_us;
+        problem_runs_read_unlock(eprs);
+        break;
+    }
+    case REFRESH_RUN_INFO: {
+        struct EjRunInfo *eri = run_info_read_lock(ri->ers);
+        if (eri && eri->ok) recheck_time_us = eri->recheck_time_us;
+        run_info_read_unlock(eri);
+        break;
+    }
+    case REFRESH_RUN_SOURCE: {
+        struct EjRunSource *ert = run_source_read_lock(ri->ers);
+        if (ert && ert->ok) recheck_time_us = ert->recheck_time_us;
+        run_source_read_unlock(ert);
+        break;
+    }
+    case REFRESH_RUN_MESSAGES: {
+        struct EjRunMessages *erms = run_messages_read_lock(ri->ers);
+        if (erms && erms->ok) recheck_time_us = erms->recheck_time_us;
+        run_messages_read_unlock(erms);
+        break;
+    }
+    case REFRESH_RUN_TEST_DATA: {
+        struct EjRunTestData *ertd = run_test_data_read_lock(ri->ert, ri->index);
+        if (ertd && ertd->ok) recheck_time_us = ertd->recheck_time_us;
+        run_test_data_read_unlock(ertd);
+        break;
+    }
+    case REFRESH_TOP_SESSION: {
+        struct EjTopSession *ets = top_session_read_lock(efs);
+        if (ets && ets->ok) recheck_time_us = ets->expire_us;
+        top_session_read_unlock(ets);
+        break;
+    }
+    case REFRESH_CONTEST_SESSION: {
+        struct EjContestSession *ecc = contest_session_read_lock(ri->ecs);
+        if (ecc && ecc->ok) recheck_time_us = ecc->expire_us;
+        contest_session_read_unlock(ecc);
+        break;
+    }
+    default:
+        abort();
+    }
+
+    return recheck_time_us;
+}
+
+// returns 1 if the item is enqueued for refresh, 0 if the timer is dropped
+static int
+timer_expired(struct EjRefreshThread *rt, struct EjRefreshItem *ri, long long current_time_us)
+{
+    _Atomic long long *p_access_us = item_access_time(ri);
+    if (p_access_us) {
+        long long access_us = atomic_load_explicit(p_access_us, memory_order_relaxed);
+        if (current_time_us - access_us > rt->efs->refresh_idle_us) {
+            // not used recently, the next access goes through the lazy path
+            return 0;
+        }
+    }
+
+    _Atomic _Bool *flag = item_update_flag(rt->efs, ri);
+    if (atomic_exchange_explicit(flag, 1, memory_order_acquire)) {
+        // being refreshed right now
+        return 0;
+    }
+    if (item_recheck_time(rt->efs, ri) != ri->recheck_time_us) {
+        // not valid or already refreshed by somebody else
+        single_flight_done(flag);
+        return 0;
+    }
+
+    refresh_thread_enqueue(rt, ri);
+    return 1;
+}
+
+static void *
+sched_thread_func(void *arg)
+{
+    struct EjRefreshThread *rt = (struct EjRefreshThread *) arg;
+
+    pthread_setname_np(pthread_self(), "REFRESH_SCHED");
+
+    while (!atomic_load_explicit(&rt->sched_stop, memory_order_acquire)) {
+        nanosleep(&(struct timespec) { .tv_sec = 0, .tv_nsec = EJFUSE_REFRESH_TICK * 1000LL }, NULL);
+
+        long long current_time_us = get_current_time_us();
+        pthread_mutex_lock(&rt->tm);
+        struct EjTimer *t = timer_wheel_advance(rt->wheel, current_time_us / EJFUSE_REFRESH_TICK);
+        pthread_mutex_unlock(&rt->tm);
+
+        while (t) {
+            struct EjRefreshTimer *ert = (struct EjRefreshTimer *) t;
+            t = t->next;
+            if (!timer_expired(rt, ert->item, current_time_us)) {
+                refresh_item_free(ert->item);
+            }
+            free(ert);
+        }
+        // frees the retired objects when the updates stop
+        ebr_collect();
+    }
+
+    return NULL;
+}
+
+int
+refresh_thread_start(struct EjRefreshThread *rt, struct EjFuseState *efs)
+{
+    pthread_attr_t pa;
+
+    rt->efs = efs;
+
+    pthread_attr_init(&pa);
+    pthread_attr_setstacksize(&pa, 1024 * 1024);
+    for (; rt->thread_count < EJFUSE_REFRESH_THREADS; ++rt->thread_count) {
+        int res = pthread_create(&rt->ids[rt->thread_count], &pa, thread_func, rt);
+        if (res) {
+            pthread_attr_destroy(&pa);
+            return -res;
+        }
+    }
+    int res = pthread_create(&rt->sched_id, &pa, sched_thread_func, rt);
+    pthread_attr_destroy(&pa);
+    if (res) {
+        return -res;
+    }
+    rt->sched_started = 1;
+
+    return 0;
+}
+
+void
+refresh_thread_stop(struct EjRefreshThread *rt)
+{
+    if (rt->sched_started) {
+        atomic_store_explicit(&rt->sched_stop, 1, memory_order_release);
+        pthread_join(rt->sched_id, NULL);
+        rt->sched_started = 0;
+    }
+
+    // a refresh in progress is completed, the queued ones are dropped
+    pthread_mutex_lock(&rt->qm);
+    rt->stop_request = 1;
+    pthread_cond_broadcast(&rt->qc);
+    pthread_mutex_unlock(&rt->qm);
+    for (; rt->thread_count > 0; --rt->thread_count) {
+        pthread_join(rt->ids[rt->thread_count - 1], NULL);
+    }
+}
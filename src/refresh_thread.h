@@ -0,0 +1,95 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+struct EjFuseState;
+struct EjContestState;
+struct EjProblemState;
+struct EjRunState;
+struct EjRunTest;
+
+enum
+{
+    REFRESH_CONTEST_INFO = 1,
+    REFRESH_PROBLEM_INFO,
+    REFRESH_PROBLEM_STATEMENT,
+    REFRESH_PROBLEM_RUNS,
+    REFRESH_RUN_INFO,
+    REFRESH_RUN_SOURCE,
+    REFRESH_RUN_MESSAGES,
+    REFRESH_RUN_TEST_DATA,
+    REFRESH_TOP_SESSION,
+    REFRESH_CONTEST_SESSION,
+};
+
+/*
+ * Background refresh of an expired object. The enqueueing thread holds
+ * the write lock (*_try_write_lock) of the object, the refresh thread
+ * installs the new object, which releases the lock.
+ */
+struct EjRefreshItem
+{
+    int kind;
+    struct EjContestState *ecs;
+    struct EjProblemState *eps;
+    struct EjRunState *ers;
+    struct EjRunTest *ert;
+    int run_id;
+    int index;
+
+    // the recheck (or session expiration) time of the object
+    // a timer was armed for, the timer is dropped if the object changed
+    long long recheck_time_us;
+};
+
+struct EjRefreshThread;
+
+struct EjRefreshThread *refresh_thread_create(void);
+void refresh_thread_free(struct EjRefreshThread *rt);
+
+struct EjRefreshItem *
+refresh_item_create(
+        int kind,
+        struct EjContestState *ecs,
+        struct EjProblemState *eps,
+        struct EjRunState *ers,
+        struct EjRunTest *ert,
+        int run_id,
+        int index);
+void refresh_item_free(struct EjRefreshItem *ri);
+
+int refresh_thread_start(struct EjRefreshThread *rt, struct EjFuseState *efs);
+// stops and joins the threads, the refresh in progress is completed
+void refresh_thread_stop(struct EjRefreshThread *rt);
+
+void refresh_thread_enqueue(struct EjRefreshThread *rt, struct EjRefreshItem *ri);
+
+/*
+ * Proactive refresh: at fire_time_us the object is refreshed in background
+ * if it has been accessed within the idle window (refresh_idle_us),
+ * otherwise the timer is dropped. The refresh installs the next timer.
+ * The top-level session is renewed regardless of the access time.
+ */
+void
+refresh_thread_schedule(
+        struct EjRefreshThread *rt,
+        struct EjRefreshItem *ri,
+        long long recheck_time_us,
+        long long fire_time_us);
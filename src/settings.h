@@ -33,3 +33,60 @@ enum { EJFUSE_CACHING_TIME = 30000000 }; // 30s
 
 /* server error retry timeout (in us - microseconds) */
 enum { EJFUSE_RETRY_TIME = 10000000 }; // 10s
+
+/* max time to wait for an object being fetched by another thread (in us) */
+enum { EJFUSE_FLIGHT_WAIT_TIME = 20000000 }; // 20s
+
+/* max time an expired object may be served while refreshed in background (in us) */
+enum { EJFUSE_STALE_LIMIT = 300000000 }; // 300s
+
+/* number of background refresh threads */
+enum { EJFUSE_REFRESH_THREADS = 4 };
+
+/* proactive refresh timer resolution (in us) */
+enum { EJFUSE_REFRESH_TICK = 250000 }; // 250ms
+
+/* proactive refresh starts this long before the object expires (in us) */
+enum { EJFUSE_REFRESH_AHEAD = 3000000 }; // 3s
+
+/* the top-level session is renewed this long before expiry (in us) */
+enum { EJFUSE_TOP_SESSION_RENEW_AHEAD = 300000000 }; // 300s
+
+/* contest sessions are renewed this long before expiry (in us) */
+enum { EJFUSE_CONTEST_SESSION_RENEW_AHEAD = 60000000 }; // 60s
+
+/* random spread of session renewal times (in us) */
+enum { EJFUSE_SESSION_JITTER = 30000000 }; // 30s
+
+/* a session is not used if it expires in less than this time (in us) */
+enum { EJFUSE_SESSION_EXPIRE_MARGIN = 5000000 }; // 5s
+
+/* objects not accessed for this long are not refreshed proactively (in us) */
+enum { EJFUSE_REFRESH_IDLE_TIME = 120000000 }; // 120s
+
+/* default attribute and entry timeout of the low-level front end (in ms) */
+enum { EJFUSE_LL_TIMEOUT_MS = 1000 };
+
+/* timeout of the nodes changing often: runs directories, LOG (in ms) */
+enum { EJFUSE_LL_SHORT_TIMEOUT_MS = 100 };
+
+/* timeout of the run sources and the nodes of finished runs (in ms) */
+enum { EJFUSE_LL_LONG_TIMEOUT_MS = 3600000 }; // 1h
+
+/* default max number of concurrent HTTP requests */
+enum { EJFUSE_MAX_REQUESTS = 8 };
+
+/* upper limit for --max-requests */
+enum { EJFUSE_MAX_REQUESTS_LIMIT = 256 };
+
+/* cached payloads of at least this size are kept in memfd (in bytes) */
+enum { EJFUSE_MEMFD_MIN_SIZE = 65536 };
+
+/* max number of cached payloads kept in memfd, each holds a descriptor */
+enum { EJFUSE_MEMFD_MAX_BLOBS = 1024 };
+
+/* size of the cache line, the unit of false sharing between CPUs (in bytes) */
+enum { EJFUSE_CACHE_LINE_SIZE = 64 };
+
+/* chunk size of the arena of a parsed run info (in bytes) */
+enum { EJFUSE_RUN_INFO_ARENA_SIZE = 4096 };
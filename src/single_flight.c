@@ -0,0 +1,97 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "single_flight.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+
+/* the waiters are hashed by the flag address into a fixed set of buckets */
+enum { SINGLE_FLIGHT_BUCKETS = 64 };
+
+struct SingleFlightBucket
+{
+    pthread_mutex_t m;
+    pthread_cond_t c;
+};
+
+static struct SingleFlightBucket buckets[SINGLE_FLIGHT_BUCKETS];
+static pthread_once_t buckets_once = PTHREAD_ONCE_INIT;
+
+static void
+buckets_init(void)
+{
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    for (int i = 0; i < SINGLE_FLIGHT_BUCKETS; ++i) {
+        pthread_mutex_init(&buckets[i].m, NULL);
+        pthread_cond_init(&buckets[i].c, &ca);
+    }
+    pthread_condattr_destroy(&ca);
+}
+
+static struct SingleFlightBucket *
+get_bucket(_Atomic _Bool *flag)
+{
+    uintptr_t v = (uintptr_t) flag;
+    v ^= v >> 17;
+    v *= 0x9E3779B97F4A7C15ULL;
+    pthread_once(&buckets_once, buckets_init);
+    return &buckets[(v >> 32) % SINGLE_FLIGHT_BUCKETS];
+}
+
+int
+single_flight_wait(_Atomic _Bool *flag, long long timeout_us)
+{
+    if (!atomic_load_explicit(flag, memory_order_acquire)) return 0;
+
+    struct SingleFlightBucket *sfb = get_bucket(flag);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    long long nsec = ts.tv_nsec + (timeout_us % 1000000) * 1000;
+    ts.tv_sec += timeout_us / 1000000 + nsec / 1000000000;
+    ts.tv_nsec = nsec % 1000000000;
+
+    int retval = 0;
+    pthread_mutex_lock(&sfb->m);
+    while (atomic_load_explicit(flag, memory_order_acquire)) {
+        if (pthread_cond_timedwait(&sfb->c, &sfb->m, &ts) == ETIMEDOUT) {
+            if (atomic_load_explicit(flag, memory_order_acquire)) retval = -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sfb->m);
+    return retval;
+}
+
+void
+single_flight_done(_Atomic _Bool *flag)
+{
+    struct SingleFlightBucket *sfb = get_bucket(flag);
+    atomic_store_explicit(flag, 0, memory_order_release);
+    // taking the mutex guarantees that a waiter which has seen the flag set
+    // is already blocked in pthread_cond_timedwait
+    pthread_mutex_lock(&sfb->m);
+    pthread_cond_broadcast(&sfb->c);
+    pthread_mutex_unlock(&sfb->m);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Single-flight support for the *_update flags of the cached objects.
+ * The thread which wins the *_try_write_lock exchange fetches the object,
+ * other threads asking for the same object may wait for the flag to be
+ * cleared and then read the freshly installed object.
+ */
+
+// wait until the flag is cleared or timeout_us expires,
+// returns 0 if the flag is cleared, -1 on timeout
+int single_flight_wait(_Atomic _Bool *flag, long long timeout_us);
+
+// clear the flag and wake up all the waiters
+void single_flight_done(_Atomic _Bool *flag);
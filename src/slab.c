@@ -0,0 +1,182 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slab.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    SLAB_MAX = 32,
+    SLAB_MAGAZINE_SIZE = 32,
+    SLAB_ALIGN = 16,
+};
+
+struct EjSlabMagazine
+{
+    struct EjSlabMagazine *next;
+    int count;
+    void *objs[SLAB_MAGAZINE_SIZE];
+};
+
+struct EjSlab
+{
+    int id;
+    const char *name;
+    size_t obj_size;
+    size_t obj_align;
+
+    // depot
+    pthread_mutex_t m;
+    struct EjSlabMagazine *loaded;      // magazines holding objects
+    struct EjSlabMagazine *empty;       // magazines without objects
+};
+
+static struct EjSlab *slabs[SLAB_MAX];
+static _Atomic int slab_count;
+
+static pthread_once_t slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slab_key;
+static __thread struct EjSlabMagazine *thread_mags[SLAB_MAX];
+static __thread _Bool thread_registered;
+
+// returns the magazines of an exiting thread to the depots
+static void
+slab_thread_exit(void *arg)
+{
+    int count = atomic_load_explicit(&slab_count, memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        struct EjSlabMagazine *mag = thread_mags[i];
+        if (!mag) continue;
+        struct EjSlab *es = slabs[i];
+        pthread_mutex_lock(&es->m);
+        if (mag->count > 0) {
+            mag->next = es->loaded;
+            es->loaded = mag;
+        } else {
+            mag->next = es->empty;
+            es->empty = mag;
+        }
+        pthread_mutex_unlock(&es->m);
+        thread_mags[i] = NULL;
+    }
+}
+
+static void
+slab_init_func(void)
+{
+    pthread_key_create(&slab_key, slab_thread_exit);
+}
+
+struct EjSlab *
+slab_create(const char *name, size_t obj_size, size_t obj_align)
+{
+    pthread_once(&slab_once, slab_init_func);
+    int id = atomic_fetch_add_explicit(&slab_count, 1, memory_order_relaxed);
+    if (id >= SLAB_MAX) abort();
+
+    struct EjSlab *es = calloc(1, sizeof(*es));
+    es->id = id;
+    es->name = name;
+    if (obj_align < SLAB_ALIGN) obj_align = SLAB_ALIGN;
+    es->obj_align = obj_align;
+    es->obj_size = (obj_size + obj_align - 1) & ~(obj_align - 1);
+    pthread_mutex_init(&es->m, NULL);
+    slabs[id] = es;
+    return es;
+}
+
+// fills a magazine with new objects carved from one allocation
+static void
+slab_refill_unlocked(struct EjSlab *es, struct EjSlabMagazine *mag)
+{
+    unsigned char *chunk = aligned_alloc(es->obj_align, es->obj_size * SLAB_MAGAZINE_SIZE);
+    if (!chunk) abort();
+    for (int i = 0; i < SLAB_MAGAZINE_SIZE; ++i) {
+        mag->objs[i] = chunk + i * es->obj_size;
+    }
+    mag->count = SLAB_MAGAZINE_SIZE;
+}
+
+// swaps the thread magazine with a loaded (need_objs) or an empty one
+static struct EjSlabMagazine *
+slab_exchange(struct EjSlab *es, struct EjSlabMagazine *mag, int need_objs)
+{
+    if (!thread_registered) {
+        pthread_setspecific(slab_key, es);
+        thread_registered = 1;
+    }
+
+    pthread_mutex_lock(&es->m);
+    if (mag) {
+        if (mag->count > 0) {
+            mag->next = es->loaded;
+            es->loaded = mag;
+        } else {
+            mag->next = es->empty;
+            es->empty = mag;
+        }
+    }
+    struct EjSlabMagazine *res = NULL;
+    if (need_objs && es->loaded) {
+        res = es->loaded;
+        es->loaded = res->next;
+    } else if (!need_objs && es->empty) {
+        res = es->empty;
+        es->empty = res->next;
+    } else {
+        if (es->empty) {
+            res = es->empty;
+            es->empty = res->next;
+        } else {
+            res = calloc(1, sizeof(*res));
+        }
+        if (need_objs) slab_refill_unlocked(es, res);
+    }
+    pthread_mutex_unlock(&es->m);
+    res->next = NULL;
+    thread_mags[es->id] = res;
+    return res;
+}
+
+void *
+slab_alloc(struct EjSlab *es)
+{
+    struct EjSlabMagazine *mag = thread_mags[es->id];
+    if (!mag || mag->count <= 0) {
+        mag = slab_exchange(es, mag, 1);
+    }
+    void *ptr = mag->objs[--mag->count];
+    memset(ptr, 0, es->obj_size);
+    return ptr;
+}
+
+void
+slab_free(struct EjSlab *es, void *ptr)
+{
+    if (!ptr) return;
+    struct EjSlabMagazine *mag = thread_mags[es->id];
+    if (!mag || mag->count >= SLAB_MAGAZINE_SIZE) {
+        mag = slab_exchange(es, mag, 0);
+    }
+    mag->objs[mag->count++] = ptr;
+}
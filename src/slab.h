@@ -0,0 +1,39 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Typed slab allocators for small objects created and freed on every
+ * refresh. Each thread keeps a loaded magazine of free objects per slab,
+ * a central depot exchanges full and empty magazines under a mutex, so
+ * the mutex is taken once per SLAB_MAGAZINE_SIZE operations. Memory of
+ * the slabs is never returned to the system.
+ */
+
+#include <stddef.h>
+
+struct EjSlab;
+
+/* slabs are created once, at most SLAB_MAX of them, and never freed */
+struct EjSlab *slab_create(const char *name, size_t obj_size, size_t obj_align);
+
+/* returns a zero-filled object */
+void *slab_alloc(struct EjSlab *es);
+void slab_free(struct EjSlab *es, void *ptr);
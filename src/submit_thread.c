@@ -24,12 +24,14 @@
 #include "ejfuse_file.h"
 #include "ejudge_client.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <sys/time.h>
 #include <stdatomic.h>
+#include <time.h>
 
 struct EjSubmitListItem
 {
@@ -40,11 +42,13 @@ struct EjSubmitListItem
 struct EjSubmitThread
 {
     pthread_t id;
+    _Bool started;
     struct EjFuseState *efs;
 
     pthread_mutex_t qm;
     pthread_cond_t qc;
     struct EjSubmitListItem *qhead, *qtail;
+    _Bool stop_request;                 // protected by qm
 };
 
 struct EjSubmitThread *
@@ -60,6 +64,13 @@ void
 submit_thread_free(struct EjSubmitThread *st)
 {
     if (st) {
+        submit_thread_stop(st);
+        while (st->qhead) {
+            struct EjSubmitListItem *sli = st->qhead;
+            st->qhead = sli->next;
+            submit_item_free(sli->item);
+            free(sli);
+        }
         pthread_cond_destroy(&st->qc);
         pthread_mutex_destroy(&st->qm);
         free(st);
@@ -209,10 +220,14 @@ thread_submit(struct EjSubmitThread *st, struct EjSubmitItem *si)
     pthread_mutex_lock(&efn->m);
     int copy_size = efn->size;
     unsigned char *copy_data = malloc(copy_size + 1);
-    memcpy(copy_data, efn->data, copy_size);
+    if (copy_size > 0) res = file_node_pread(efn->fd, copy_data, copy_size, 0);
     copy_data[copy_size] = 0;
     pthread_mutex_unlock(&efn->m);
-    atomic_fetch_sub_explicit(&efn->refcnt, 1, memory_order_relaxed); efn = NULL;
+    file_node_unref(efn); efn = NULL;
+    if (res < 0) {
+        free(copy_data);
+        return;
+    }
 
     ejudge_client_submit_run_request(st->efs, ecs, &esv, si->prob_id, si->lang_id, copy_data, copy_size, current_time_us);
     free(copy_data); copy_data = NULL;
@@ -241,9 +256,13 @@ thread_func(void *arg)
 
     while (1) {
         pthread_mutex_lock(&st->qm);
-        while (!st->qhead) {
+        while (!st->qhead && !st->stop_request) {
             pthread_cond_wait(&st->qc, &st->qm);
         }
+        if (st->stop_request) {
+            pthread_mutex_unlock(&st->qm);
+            break;
+        }
         struct EjSubmitListItem *sli = st->qhead;
         st->qhead = sli->next;
         if (st->qhead) {
@@ -266,8 +285,14 @@ thread_func(void *arg)
         }
         submit_item_free(si);
 
-        // rate limiter: 5s timeout
-        nanosleep(&(struct timespec) { .tv_sec = 5, .tv_nsec = 0 }, NULL);
+        // rate limiter: 5s timeout, interrupted by stop
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 5;
+        pthread_mutex_lock(&st->qm);
+        while (!st->stop_request && pthread_cond_timedwait(&st->qc, &st->qm, &ts) != ETIMEDOUT) {
+        }
+        pthread_mutex_unlock(&st->qm);
     }
 
     return NULL;
@@ -290,6 +315,19 @@ submit_thread_start(struct EjSubmitThread *st, struct EjFuseState *efs)
     }
 
     st->id = id; // both parent and child to this
+    st->started = 1;
 
     return 0;
 }
+
+void
+submit_thread_stop(struct EjSubmitThread *st)
+{
+    if (!st->started) return;
+    pthread_mutex_lock(&st->qm);
+    st->stop_request = 1;
+    pthread_cond_broadcast(&st->qc);
+    pthread_mutex_unlock(&st->qm);
+    pthread_join(st->id, NULL);
+    st->started = 0;
+}
@@ -44,7 +44,10 @@ submit_item_create(
         int lang_id,
         int fnode,
         const unsigned char *fname);
+void submit_item_free(struct EjSubmitItem *si);
 
 int submit_thread_start(struct EjSubmitThread *st, struct EjFuseState *);
+// stops and joins the thread, the queued submits are dropped
+void submit_thread_stop(struct EjSubmitThread *st);
 
 void submit_thread_enqueue(struct EjSubmitThread *st, struct EjSubmitItem *si);
@@ -0,0 +1,113 @@
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer_wheel.h"
+
+#include <stdlib.h>
+
+struct EjTimerWheel *
+timer_wheel_create(long long start_tick)
+{
+    struct EjTimerWheel *tw = calloc(1, sizeof(*tw));
+    tw->current_tick = start_tick;
+    return tw;
+}
+
+// the timers still in the wheel are owned by the caller
+void
+timer_wheel_free(struct EjTimerWheel *tw)
+{
+    free(tw);
+}
+
+static void
+add_timer(struct EjTimerWheel *tw, struct EjTimer *t)
+{
+    if (t->expire_tick < tw->current_tick) {
+        t->expire_tick = tw->current_tick;
+    }
+    long long delta = t->expire_tick - tw->current_tick;
+    long long max_delta = (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    if (delta > max_delta) {
+        // fires early, the caller must recheck the expiration time
+        t->expire_tick = tw->current_tick + max_delta;
+        delta = max_delta;
+    }
+
+    int level = 0;
+    while (delta >= (1LL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    int index = (t->expire_tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    t->next = tw->slots[level][index];
+    tw->slots[level][index] = t;
+}
+
+void
+timer_wheel_add(struct EjTimerWheel *tw, struct EjTimer *t)
+{
+    add_timer(tw, t);
+    ++tw->count;
+}
+
+// move the timers of the current slot of the level down, return the slot index
+static int
+cascade(struct EjTimerWheel *tw, int level)
+{
+    int index = (tw->current_tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    struct EjTimer *t = tw->slots[level][index];
+    tw->slots[level][index] = NULL;
+    while (t) {
+        struct EjTimer *next = t->next;
+        add_timer(tw, t);
+        t = next;
+    }
+    return index;
+}
+
+struct EjTimer *
+timer_wheel_advance(struct EjTimerWheel *tw, long long now_tick)
+{
+    struct EjTimer *expired = NULL;
+
+    while (tw->current_tick <= now_tick) {
+        if (!tw->count) {
+            // nothing to cascade, jump forward
+            tw->current_tick = now_tick + 1;
+            break;
+        }
+        int index = tw->current_tick & TIMER_WHEEL_MASK;
+        if (!index) {
+            for (int level = 1; level < TIMER_WHEEL_LEVELS && !cascade(tw, level); ++level) {
+            }
+        }
+        struct EjTimer *t = tw->slots[0][index];
+        tw->slots[0][index] = NULL;
+        while (t) {
+            struct EjTimer *next = t->next;
+            t->next = expired;
+            expired = t;
+            --tw->count;
+            t = next;
+        }
+        ++tw->current_tick;
+    }
+
+    return expired;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+/* Copyright (C) 2026 Alexander Chernov <cher@ejudge.ru> */
+
+/*
+ * This file is part of ejudge-fuse.
+ *
+ * Ejudge-fuse is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Ejudge-fuse is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Ejudge-fuse.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Hierarchical timer wheel: TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SIZE
+ * slots each, level L covers delays up to TIMER_WHEEL_SIZE^(L+1) ticks.
+ * Timers are intrusive, the wheel does no locking and no allocation.
+ */
+
+enum
+{
+    TIMER_WHEEL_BITS = 6,
+    TIMER_WHEEL_SIZE = 1 << TIMER_WHEEL_BITS,
+    TIMER_WHEEL_MASK = TIMER_WHEEL_SIZE - 1,
+    TIMER_WHEEL_LEVELS = 4,
+};
+
+struct EjTimer
+{
+    struct EjTimer *next;
+    long long expire_tick;
+};
+
+struct EjTimerWheel
+{
+    long long current_tick;     // the next tick to process
+    int count;
+    struct EjTimer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+};
+
+struct EjTimerWheel *timer_wheel_create(long long start_tick);
+void timer_wheel_free(struct EjTimerWheel *tw);
+
+void timer_wheel_add(struct EjTimerWheel *tw, struct EjTimer *t);
+
+// process all ticks up to now_tick inclusive, the expired timers are returned as a list
+struct EjTimer *timer_wheel_advance(struct EjTimerWheel *tw, long long now_tick);